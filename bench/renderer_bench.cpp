@@ -0,0 +1,397 @@
+#include <renderer/include_all.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace renderer::bench {
+
+/**
+ * @brief Сцена для замера
+ */
+struct BenchScene {
+    std::string name;
+    Scene scene{Scene::FULL_PRECISION};
+    Scene::CameraId camera = 0;
+    size_t facets = 0;
+};
+
+/**
+ * @brief Параметры запуска
+ */
+struct Options {
+    size_t width = 640;
+    size_t height = 360;
+    size_t iterations = 5;
+    std::vector<size_t> threads;
+    std::string scene_filter;
+    std::string output;
+    std::string trace;  // файл для временной шкалы Chrome trace, пусто - без записи
+};
+
+/**
+ * @brief Результат замера одной конфигурации
+ */
+struct Result {
+    std::string scene;
+    size_t facets = 0;
+    size_t threads = 0;
+    Renderer::RenderFlags flags = 0;
+    double total_ms = 0;
+    double min_ms = 0;
+    double geometry_ms = 0;
+    size_t covered_pixels = 0;
+    RenderStats stats{};
+};
+
+/**
+ * Все флаги рендеринга в порядке битов
+ */
+constexpr std::pair<Renderer::RenderFlags, const char*> kFlagNames[] = {
+    {Renderer::DRAW_EDGES, "DRAW_EDGES"},
+    {Renderer::DRAW_FACETS, "DRAW_FACETS"},
+    {Renderer::DISABLE_BACKFACE_CULLING, "DISABLE_BACKFACE_CULLING"},
+    {Renderer::ENABLE_LIGHT, "ENABLE_LIGHT"}};
+
+/**
+ * Количество комбинаций флагов
+ */
+constexpr Renderer::RenderFlags kFlagCombinations = 1 << std::size(kFlagNames);
+
+/**
+ * @brief Много мелких граней: плотная сетка на весь кадр
+ */
+BenchScene SmallTriangles() {
+    BenchScene result{.name = "small_triangles"};
+    result.scene.PushInstance(utils::PushGridMesh(result.scene, {.cells = 400}));
+    result.camera = utils::PushFrontCamera(result.scene, 2);
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Несколько крупных граней, каждая покрывает значительную часть кадра
+ */
+BenchScene LargeTriangles() {
+    BenchScene result{.name = "large_triangles"};
+    result.scene.PushInstance(utils::PushGridMesh(result.scene, {.cells = 2}));
+    result.camera = utils::PushFrontCamera(result.scene, 2);
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Многократная перерисовка: полноэкранные плоскости от дальней к ближней
+ */
+BenchScene Overdraw() {
+    constexpr size_t kLayers = 32;
+    BenchScene result{.name = "overdraw"};
+    const Scene::MeshId mesh = utils::PushGridMesh(result.scene, {.cells = 1, .size = 8});
+    for (size_t layer = 0; layer < kLayers; ++layer) {
+        const Scene::ObjectId object = result.scene.PushInstance(mesh);
+        result.scene.AccessObject(object).AccessPosition() = Point{0, kLayers - layer, 0};
+    }
+    result.camera = utils::PushFrontCamera(result.scene, 1);
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Сетка из 100 точечных источников света над плоскостью
+ */
+BenchScene ManyLights() {
+    BenchScene result{.name = "many_lights"};
+    result.scene.PushInstance(utils::PushGridMesh(result.scene, {.cells = 64}));
+    result.camera = utils::PushFrontCamera(result.scene, 2);
+    result.scene.PushLight(AmbientLight{});
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            result.scene.PushLight(PointLight{.strength = 0.1,
+                                              .color = Color{i / 9.0f, j / 9.0f, 1},
+                                              .position = {-2 + i * 0.45f, -0.5, -2 + j * 0.45f}});
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Текстурированная сетка с большой текстурой, повторяющейся много раз
+ */
+BenchScene Textured() {
+    BenchScene result{.name = "textured"};
+    result.camera = utils::PushTexturedScene(result.scene, utils::TexturedSceneParameters{});
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Камера внутри коробки из крупных граней: почти каждая грань обрезается
+ */
+BenchScene Clipping() {
+    BenchScene result{.name = "clipping"};
+    result.camera = utils::PushClippingScene(result.scene, 8);
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Процедурная сцена из ландшафта, леса и сфер с сеткой точечных источников
+ */
+BenchScene Stress() {
+    BenchScene result{.name = "stress"};
+    result.camera = utils::PushStressScene(result.scene, utils::StressSceneParameters{});
+    return result;
+}
+
+/**
+ * @brief Создание всех сцен
+ */
+std::vector<BenchScene> MakeScenes(const std::string& filter) {
+    std::vector<BenchScene (*)()> makers = {SmallTriangles, LargeTriangles, Overdraw,
+                                           ManyLights,     Textured,       Clipping,
+                                           Stress};
+    std::vector<BenchScene> scenes;
+    for (auto maker : makers) {
+        BenchScene scene = maker();
+        if (not filter.empty() and scene.name != filter) {
+            continue;
+        }
+        for (auto it = scene.scene.ObjectsBegin(); it != scene.scene.ObjectsEnd(); ++it) {
+            scene.facets += it->Size();
+        }
+        scene.scene.UpdateTransforms();
+        scenes.push_back(std::move(scene));
+    }
+    return scenes;
+}
+
+/**
+ * @brief Медиана замеров в миллисекундах
+ */
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/**
+ * @brief Замер одного рендеринга
+ */
+double Measure(Renderer& renderer, const BenchScene& scene, const Options& options,
+               const Renderer::RenderFlags flags, Image& image) {
+    image = Image{Width{options.width}, Height{options.height}};
+    auto start = std::chrono::steady_clock::now();
+    image = renderer.Render(scene.scene, scene.camera, std::move(image), flags);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Замер сцены с переданными флагами
+ *
+ * Геометрическая стадия замеряется отдельно рендерингом без отрисовки ребер и граней, время
+ * растеризации считается как разность. Статистика кадра собирается отдельным рендерингом, чтобы
+ * ее сбор не влиял на замеры
+ */
+Result Run(Renderer& renderer, const BenchScene& scene, const Options& options,
+           const size_t threads, const Renderer::RenderFlags flags) {
+    Image image{Width{options.width}, Height{options.height}};
+    const Renderer::RenderFlags geometry_flags =
+        flags & ~(Renderer::DRAW_EDGES | Renderer::DRAW_FACETS);
+    // прогрев
+    Measure(renderer, scene, options, flags, image);
+
+    std::vector<double> total;
+    std::vector<double> geometry;
+    for (size_t i = 0; i < options.iterations; ++i) {
+        geometry.push_back(Measure(renderer, scene, options, geometry_flags, image));
+        total.push_back(Measure(renderer, scene, options, flags, image));
+    }
+
+    Result result{.scene = scene.name, .facets = scene.facets, .threads = threads, .flags = flags};
+    result.total_ms = Median(total);
+    result.min_ms = *std::min_element(total.begin(), total.end());
+    result.geometry_ms = std::min(Median(geometry), result.total_ms);
+    image = renderer.Render(scene.scene, scene.camera, std::move(image), flags, &result.stats);
+    result.covered_pixels = result.stats.pixels_covered;
+    return result;
+}
+
+/**
+ * @brief Запись статистики кадра в JSON
+ */
+void WriteStats(std::FILE* file, const RenderStats& stats) {
+    auto ms = [](const std::chrono::nanoseconds time) { return time.count() / 1e6; };
+    std::fprintf(file, "\"stats\": {\"triangles_produced\": %llu, \"backface_culled\": %llu, ",
+                 static_cast<unsigned long long>(stats.triangles_produced),
+                 static_cast<unsigned long long>(stats.triangles_backface_culled));
+    std::fprintf(file, "\"frustum_culled\": %llu, \"clipped\": %llu,\n       ",
+                 static_cast<unsigned long long>(stats.triangles_frustum_culled),
+                 static_cast<unsigned long long>(stats.triangles_clipped));
+    std::fprintf(file,
+                 "\"pixels_tested\": %llu, \"pixels_shaded\": %llu, \"overdraw\": %.3f,\n       ",
+                 static_cast<unsigned long long>(stats.pixels_tested),
+                 static_cast<unsigned long long>(stats.pixels_shaded), stats.overdraw);
+    std::fprintf(file,
+                 "\"stage_ms\": {\"transform\": %.4f, \"clip\": %.4f, \"raster\": %.4f, "
+                 "\"shade\": %.4f}}",
+                 ms(stats.transform_time), ms(stats.clip_time), ms(stats.raster_time),
+                 ms(stats.shade_time));
+}
+
+/**
+ * @brief Запись результатов в JSON
+ */
+void WriteJson(std::FILE* file, const Options& options, const std::vector<Result>& results) {
+    const double pixels = static_cast<double>(options.width * options.height);
+    std::fprintf(file, "{\n  \"benchmark\": \"Renderer_bench\",\n");
+#ifdef NDEBUG
+    std::fprintf(file, "  \"build\": \"release\",\n");
+#else
+    std::fprintf(file, "  \"build\": \"debug\",\n");
+#endif
+    std::fprintf(file, "  \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(file, "  \"width\": %zu,\n  \"height\": %zu,\n  \"iterations\": %zu,\n",
+                 options.width, options.height, options.iterations);
+    std::fprintf(file, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        const double raster_ms = result.total_ms - result.geometry_ms;
+        std::fprintf(file, "%s\n    {\"scene\": \"%s\", \"facets\": %zu, \"threads\": %zu, ",
+                     i == 0 ? "" : ",", result.scene.c_str(), result.facets, result.threads);
+        std::fprintf(file, "\"flags\": [");
+        bool first = true;
+        for (const auto& [flag, name] : kFlagNames) {
+            if (result.flags & flag) {
+                std::fprintf(file, "%s\"%s\"", first ? "" : ", ", name);
+                first = false;
+            }
+        }
+        std::fprintf(file, "],\n     \"total_ms\": %.4f, \"min_ms\": %.4f, ", result.total_ms,
+                     result.min_ms);
+        std::fprintf(file, "\"geometry_ms\": %.4f, \"raster_ms\": %.4f,\n     ",
+                     result.geometry_ms, raster_ms);
+        std::fprintf(file, "\"triangles_per_sec\": %.1f, \"covered_pixels\": %zu, ",
+                     result.facets / (result.total_ms / 1000), result.covered_pixels);
+        std::fprintf(file, "\"covered_pixels_per_sec\": %.1f,\n     ",
+                     result.covered_pixels / (result.total_ms / 1000));
+        std::fprintf(file,
+                     "\"ns_per_pixel\": {\"total\": %.3f, \"geometry\": %.3f, "
+                     "\"raster\": %.3f},\n     ",
+                     result.total_ms * 1e6 / pixels, result.geometry_ms * 1e6 / pixels,
+                     raster_ms * 1e6 / pixels);
+        WriteStats(file, result.stats);
+        std::fprintf(file, "}");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+}
+
+/**
+ * @brief Разбор списка чисел через запятую
+ */
+std::vector<size_t> ParseList(const char* text) {
+    std::vector<size_t> values;
+    std::string token;
+    for (const char* it = text;; ++it) {
+        if (*it == ',' or *it == '\0') {
+            if (not token.empty()) {
+                values.push_back(std::stoul(token));
+            }
+            token.clear();
+            if (*it == '\0') {
+                break;
+            }
+        } else {
+            token += *it;
+        }
+    }
+    return values;
+}
+
+/**
+ * @brief Разбор аргументов командной строки
+ *
+ * @return false, если аргументы некорректны
+ */
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--width") == 0 and has_value) {
+            options.width = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 and has_value) {
+            options.height = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--iterations") == 0 and has_value) {
+            options.iterations = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--threads") == 0 and has_value) {
+            options.threads = ParseList(argv[++i]);
+        } else if (std::strcmp(argv[i], "--scene") == 0 and has_value) {
+            options.scene_filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 and has_value) {
+            options.output = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 and has_value) {
+            options.trace = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    if (options.threads.empty()) {
+        options.threads = {1};
+        const size_t hardware = std::max(std::thread::hardware_concurrency(), 1u);
+        for (size_t threads = 2; threads < hardware; threads *= 2) {
+            options.threads.push_back(threads);
+        }
+        if (hardware > 1) {
+            options.threads.push_back(hardware);
+        }
+    }
+    return options.width > 0 and options.height > 0;
+}
+
+}  // namespace renderer::bench
+
+int main(int argc, char** argv) {
+    using namespace renderer::bench;
+    Options options;
+    if (not ParseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: Renderer_bench [--width W] [--height H] [--iterations N]\n"
+                     "                      [--threads 1,2,4] [--scene NAME] [--output FILE]\n"
+                     "                      [--trace FILE]\n");
+        return 1;
+    }
+    renderer::Tracer& tracer = renderer::Tracer::Get();
+    tracer.Enable(not options.trace.empty());
+
+    std::vector<BenchScene> scenes = MakeScenes(options.scene_filter);
+    std::vector<Result> results;
+    for (const size_t threads : options.threads) {
+        renderer::ThreadPool pool{threads};
+        renderer::Renderer renderer{pool, renderer::ResourcesManager::Get()};
+        for (const BenchScene& scene : scenes) {
+            for (renderer::Renderer::RenderFlags flags = 0; flags < kFlagCombinations; ++flags) {
+                results.push_back(Run(renderer, scene, options, threads, flags));
+                std::fprintf(stderr, "%s threads=%zu flags=%u: %.3f ms\n", scene.name.c_str(),
+                             threads, flags, results.back().total_ms);
+            }
+        }
+    }
+
+    std::FILE* file = options.output.empty() ? stdout : std::fopen(options.output.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Renderer_bench: не удалось открыть %s\n", options.output.c_str());
+        return 1;
+    }
+    WriteJson(file, options, results);
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    if (not options.trace.empty() and
+        not tracer.SaveChromeTrace(options.trace, 0, tracer.CurrentFrame())) {
+        std::fprintf(stderr, "Renderer_bench: не удалось записать %s\n", options.trace.c_str());
+        return 1;
+    }
+    return 0;
+}
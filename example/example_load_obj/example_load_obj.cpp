@@ -1,14 +1,13 @@
 #include <renderer/include_all.hpp>
 
-#include "../BMP_Writer/BMP_Writer.hpp"
-
 int main() {
     // Загружаем объект из OBJ файла
     renderer::Object cube = renderer::utils::LoadFile("cube.obj");
 
-    // Создаем сцену и добавляем объект, который по-умолчанию устанавливается в начало координат
+    // Создаем сцену и добавляем объект, который по-умолчанию устанавливается в начало координат.
+    // Объект больше не нужен, поэтому его грани передаются в сцену без копирования
     renderer::Scene scene;
-    scene.PushObject(cube);
+    scene.PushObject(std::move(cube));
 
     // Создаем камеру в точке (3, 3, 3) и направляем в сторону начала координат
     renderer::Camera camera{renderer::Point{3, 3, 3}, 225, -35};
@@ -27,6 +26,9 @@ int main() {
     image = renderer.Render(scene, camera_id, std::move(image));
 
     // Записываем результат в файл
-    SaveToBmp(image, "example_load_obj.bmp");
+    renderer::ImageWriter writer;
+    if (not writer.Save(image, "example_load_obj.bmp", renderer::ImageWriter::BMP)) {
+        return 1;
+    }
     return 0;
 }
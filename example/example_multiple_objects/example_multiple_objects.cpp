@@ -1,7 +1,5 @@
 #include <renderer/include_all.hpp>
 
-#include "../BMP_Writer/BMP_Writer.hpp"
-
 int main() {
     // Загружаем объект из OBJ файла
     renderer::Object cube = renderer::utils::LoadFile("cube.obj");
@@ -9,17 +7,20 @@ int main() {
     // Создаем сцену
     renderer::Scene scene;
 
-    // Добавляем несколько объектов
+    // Добавляем грани куба в сцену один раз
+    renderer::Scene::MeshId cube_mesh = scene.PushMesh(cube);
+
+    // Добавляем несколько экземпляров куба, они используют общие грани
 
     // Куб с центром (0, 0, 0)
-    scene.PushObject(cube);
+    scene.PushInstance(cube_mesh);
 
     // Куб с центром (2, 2, 0)
-    renderer::Scene::ObjectId cube_2 = scene.PushObject(cube);
+    renderer::Scene::ObjectId cube_2 = scene.PushInstance(cube_mesh);
     scene.AccessObject(cube_2).AccessPosition() = renderer::Point{2, 2, 0};
 
     // Куб с центром (-2, -2, 0), повернутый на 45 градусов относительно вертикали
-    renderer::Scene::ObjectId cube_3 = scene.PushObject(cube);
+    renderer::Scene::ObjectId cube_3 = scene.PushInstance(cube_mesh);
     scene.AccessObject(cube_3).AccessPosition() = renderer::Point{-2, -2, 0};
     scene.AccessObject(cube_3).AccessZAngle() = 45;
 
@@ -41,6 +42,9 @@ int main() {
                             renderer::Renderer::DRAW_EDGES | renderer::Renderer::DRAW_FACETS);
 
     // Записываем результат в файл
-    SaveToBmp(image, "example_multiple_objects.bmp");
+    renderer::ImageWriter writer;
+    if (not writer.Save(image, "example_multiple_objects.bmp", renderer::ImageWriter::BMP)) {
+        return 1;
+    }
     return 0;
 }
@@ -1,7 +1,5 @@
 #include <renderer/include_all.hpp>
 
-#include "../BMP_Writer/BMP_Writer.hpp"
-
 int main() {
     // Создаем вершины
     renderer::Vertex a = {.point = {0, 0, 0}};
@@ -44,6 +42,9 @@ int main() {
         renderer::Renderer::DRAW_EDGES | renderer::Renderer::DISABLE_BACKFACE_CULLING);
 
     // Записываем результат в файл
-    SaveToBmp(image, "example_simple_piramide.bmp");
+    renderer::ImageWriter writer;
+    if (not writer.Save(image, "example_simple_piramide.bmp", renderer::ImageWriter::BMP)) {
+        return 1;
+    }
     return 0;
 }
@@ -1,7 +1,5 @@
 #include <renderer/include_all.hpp>
 
-#include "../BMP_Writer/BMP_Writer.hpp"
-
 int main() {
     // Загружаем объект из файла
     renderer::Object cube = renderer::utils::LoadFile("textured_cube.fbx");
@@ -59,6 +57,9 @@ int main() {
                             renderer::Renderer::DRAW_FACETS | renderer::Renderer::ENABLE_LIGHT);
 
     // Записываем результат в файл
-    SaveToBmp(image, "example_texturing.bmp");
+    renderer::ImageWriter writer;
+    if (not writer.Save(image, "example_texturing.bmp", renderer::ImageWriter::BMP)) {
+        return 1;
+    }
     return 0;
 }
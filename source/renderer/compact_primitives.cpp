@@ -0,0 +1,113 @@
+#include "renderer/compact_primitives.hpp"
+
+#include <cassert>
+#include <limits>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Октаэдрическое кодирование нормали
+ *
+ * Проецирует нормаль на октаэдр |x| + |y| + |z| = 1 и разворачивает нижнюю половину октаэдра на
+ * квадрат [-1, 1]x[-1, 1]. Нулевая нормаль кодируется как (0, 0, 1)
+ */
+void EncodeNormal(const Vector& normal, uint16_t* result) {
+    float l1_norm = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+    Point2 encoded{0, 0};
+    if (l1_norm > 0) {
+        encoded = Point2{normal.x, normal.y} / l1_norm;
+        if (normal.z < 0) {
+            Point2 folded{(1.0f - glm::abs(encoded.y)) * (encoded.x >= 0 ? 1.0f : -1.0f),
+                          (1.0f - glm::abs(encoded.x)) * (encoded.y >= 0 ? 1.0f : -1.0f)};
+            encoded = folded;
+        }
+    }
+    result[0] = glm::packSnorm1x16(encoded.x);
+    result[1] = glm::packSnorm1x16(encoded.y);
+}
+
+/**
+ * @brief Октаэдрическое декодирование нормали
+ */
+Vector DecodeNormal(const uint16_t* encoded) {
+    Vector normal{glm::unpackSnorm1x16(encoded[0]), glm::unpackSnorm1x16(encoded[1]), 0};
+    normal.z = 1.0f - glm::abs(normal.x) - glm::abs(normal.y);
+    if (normal.z < 0) {
+        float x = normal.x;
+        normal.x = (1.0f - glm::abs(normal.y)) * (x >= 0 ? 1.0f : -1.0f);
+        normal.y = (1.0f - glm::abs(x)) * (normal.y >= 0 ? 1.0f : -1.0f);
+    }
+    return glm::normalize(normal);
+}
+
+}  // namespace
+
+QuantizationBounds ComputeQuantizationBounds(const Triangle* begin, const Triangle* end) {
+    QuantizationBounds bounds;
+    if (begin == end) {
+        return bounds;
+    }
+    Point min = begin->vertices[0].point;
+    Point max = min;
+    for (const Triangle* triangle = begin; triangle != end; ++triangle) {
+        for (const Vertex& vertex : triangle->vertices) {
+            min = glm::min(min, vertex.point);
+            max = glm::max(max, vertex.point);
+        }
+    }
+    bounds.min = min;
+    bounds.extent = max - min;
+    for (int i = 0; i < 3; ++i) {
+        if (bounds.extent[i] <= 0) {
+            bounds.extent[i] = 1;
+        }
+    }
+    return bounds;
+}
+
+CompactTriangle EncodeTriangle(const Triangle& triangle, const QuantizationBounds& bounds) {
+    {
+        assert((0 <= triangle.material and
+                triangle.material <= std::numeric_limits<uint32_t>::max()) and
+               "EncodeTriangle: ID материала должен помещаться в 32 бита");
+    }
+    CompactTriangle result;
+    for (int i = 0; i < 3; ++i) {
+        const Vertex& vertex = triangle.vertices[i];
+        CompactVertex& compact = result.vertices[i];
+        Point relative = (vertex.point - bounds.min) / bounds.extent;
+        for (int axis = 0; axis < 3; ++axis) {
+            compact.point[axis] = glm::packUnorm1x16(relative[axis]);
+        }
+        EncodeNormal(vertex.normal, compact.normal);
+        compact.uv_coordinates[0] = glm::packHalf1x16(vertex.uv_coordinates.x);
+        compact.uv_coordinates[1] = glm::packHalf1x16(vertex.uv_coordinates.y);
+    }
+    result.material = static_cast<uint32_t>(triangle.material);
+    return result;
+}
+
+Triangle DecodeTriangle(const CompactTriangle& triangle, const QuantizationBounds& bounds) {
+    Triangle result;
+    for (int i = 0; i < 3; ++i) {
+        const CompactVertex& compact = triangle.vertices[i];
+        Vertex& vertex = result.vertices[i];
+        Point relative{glm::unpackUnorm1x16(compact.point[0]),
+                       glm::unpackUnorm1x16(compact.point[1]),
+                       glm::unpackUnorm1x16(compact.point[2])};
+        vertex.point = bounds.min + relative * bounds.extent;
+        vertex.normal = DecodeNormal(compact.normal);
+        vertex.uv_coordinates = Point2{glm::unpackHalf1x16(compact.uv_coordinates[0]),
+                                       glm::unpackHalf1x16(compact.uv_coordinates[1])};
+    }
+    result.material = triangle.material;
+    return result;
+}
+
+}  // namespace renderer
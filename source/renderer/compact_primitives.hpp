@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief Сжатое представление графических примитивов
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "renderer/primitives.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Границы квантования
+ *
+ * Ограничивающий параллелепипед объекта, относительно которого квантуются координаты вершин
+ */
+struct QuantizationBounds {
+    /**
+     * Минимальная точка
+     */
+    Point min = {0, 0, 0};
+
+    /**
+     * Размеры вдоль осей. Нулевые размеры заменяются на 1
+     */
+    Vector extent = {1, 1, 1};
+};
+
+/**
+ * @brief Сжатая вершина
+ *
+ * Вершина, занимающая 14 байт вместо 32:
+ * - Координаты точки квантуются в 16 бит относительно границ объекта
+ * - Нормаль хранится в октаэдрическом представлении, по 16 бит на компоненту
+ * - UV координаты хранятся в виде чисел половинной точности
+ */
+struct CompactVertex {
+    /**
+     * Квантованные координаты точки
+     */
+    uint16_t point[3];
+
+    /**
+     * Нормаль в октаэдрическом представлении
+     */
+    uint16_t normal[2];
+
+    /**
+     * UV координаты в половинной точности
+     */
+    uint16_t uv_coordinates[2];
+};
+
+/**
+ * @brief Сжатая треугольная грань
+ *
+ * Грань, занимающая 48 байт вместо 104
+ */
+struct CompactTriangle {
+    /**
+     * Вершины грани, порядок как в Triangle
+     */
+    CompactVertex vertices[3];
+
+    /**
+     * Материал грани
+     */
+    uint32_t material = 0;
+};
+
+/**
+ * @brief Вычисление границ квантования
+ *
+ * Возвращает ограничивающий параллелепипед вершин переданных граней
+ *
+ * @param[in] begin Указатель на первую грань
+ * @param[in] end Указатель за последнюю грань
+ *
+ * @return Границы квантования
+ */
+QuantizationBounds ComputeQuantizationBounds(const Triangle* begin, const Triangle* end);
+
+/**
+ * @brief Сжатие грани
+ *
+ * Переводит грань в сжатое представление относительно переданных границ. Требуется, чтобы все
+ * вершины грани лежали внутри границ, а ID материала помещался в 32 бита
+ *
+ * @param[in] triangle Грань
+ * @param[in] bounds Границы квантования
+ *
+ * @return Сжатая грань
+ */
+CompactTriangle EncodeTriangle(const Triangle& triangle, const QuantizationBounds& bounds);
+
+/**
+ * @brief Распаковка грани
+ *
+ * Восстанавливает грань из сжатого представления. Нормали восстанавливаются единичными
+ *
+ * @param[in] triangle Сжатая грань
+ * @param[in] bounds Границы квантования, использованные при сжатии
+ *
+ * @return Грань
+ */
+Triangle DecodeTriangle(const CompactTriangle& triangle, const QuantizationBounds& bounds);
+
+}  // namespace renderer
@@ -0,0 +1,306 @@
+#include "renderer/frame_sink.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) or defined(__APPLE__)
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include "renderer/trace.hpp"
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Коэффициенты перевода RGB в одну компоненту YUV
+ *
+ * Компонента равна (r * R + g * G + b * B + bias) >> 8. В bias входят округление и смещение
+ * компоненты, поэтому для любых R, G, B сумма лежит в [0, 65535] и считается в беззнаковых
+ * 16-битных числах
+ */
+struct YuvCoefficients {
+    int16_t r;
+    int16_t g;
+    int16_t b;
+    uint16_t bias;
+};
+
+/**
+ * @brief BT.601, ограниченный диапазон: Y в [16, 235], U и V в [16, 240]
+ */
+constexpr YuvCoefficients kLuma{.r = 66, .g = 129, .b = 25, .bias = 128 + (16 << 8)};
+constexpr YuvCoefficients kChromaU{.r = -38, .g = -74, .b = 112, .bias = 128 + (128 << 8)};
+constexpr YuvCoefficients kChromaV{.r = 112, .g = -94, .b = -18, .bias = 128 + (128 << 8)};
+
+/**
+ * @brief Вычисление компоненты YUV для отрезка плоскостей R, G, B
+ *
+ * @param[in] red Плоскость R
+ * @param[in] green Плоскость G
+ * @param[in] blue Плоскость B
+ * @param[in] count Количество точек
+ * @param[in] coefficients Коэффициенты компоненты
+ * @param[out] output Компонента
+ */
+void ConvertPlane(const uint8_t* red, const uint8_t* green, const uint8_t* blue,
+                  const size_t count, const YuvCoefficients& coefficients, uint8_t* output) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    // умножения и сложения по модулю 2^16 дают ту же сумму, что и скалярный код
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i factor_r = _mm_set1_epi16(coefficients.r);
+    const __m128i factor_g = _mm_set1_epi16(coefficients.g);
+    const __m128i factor_b = _mm_set1_epi16(coefficients.b);
+    const __m128i bias = _mm_set1_epi16(static_cast<int16_t>(coefficients.bias));
+    auto combine = [&](const __m128i r, const __m128i g, const __m128i b) {
+        const __m128i sum =
+            _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, factor_r), _mm_mullo_epi16(g, factor_g)),
+                          _mm_add_epi16(_mm_mullo_epi16(b, factor_b), bias));
+        return _mm_srli_epi16(sum, 8);
+    };
+    for (; i + 16 <= count; i += 16) {
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(red + i));
+        const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(green + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blue + i));
+        const __m128i low = combine(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero),
+                                    _mm_unpacklo_epi8(b, zero));
+        const __m128i high = combine(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero),
+                                     _mm_unpackhi_epi8(b, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        const int32_t sum = coefficients.r * red[i] + coefficients.g * green[i] +
+                            coefficients.b * blue[i] + coefficients.bias;
+        output[i] = static_cast<uint8_t>(sum >> 8);
+    }
+}
+
+/**
+ * @brief Разделение строки пикселей на плоскости R, G, B
+ */
+void SplitRow(const Image::Pixel* pixels, const size_t width, uint8_t* red, uint8_t* green,
+              uint8_t* blue) {
+    for (size_t x = 0; x < width; ++x) {
+        red[x] = pixels[x].r;
+        green[x] = pixels[x].g;
+        blue[x] = pixels[x].b;
+    }
+}
+
+/**
+ * @brief Усреднение плоскости по блокам 2x2
+ *
+ * При нечетной ширине последний столбец усредняется сам с собой
+ *
+ * @param[in] top Верхняя строка
+ * @param[in] bottom Нижняя строка
+ * @param[in] width Ширина строк
+ * @param[out] output Строка ширины (width + 1) / 2
+ */
+void DownsampleRows(const uint8_t* top, const uint8_t* bottom, const size_t width,
+                    uint8_t* output) {
+    for (size_t x = 0; x < width; x += 2) {
+        const size_t next = std::min(x + 1, width - 1);
+        const int sum = top[x] + top[next] + bottom[x] + bottom[next];
+        output[x / 2] = static_cast<uint8_t>((sum + 2) / 4);
+    }
+}
+
+#if defined(__unix__) or defined(__APPLE__)
+
+/**
+ * @brief Запись двух буферов одним вызовом writev с повтором при частичной записи
+ */
+bool WriteAll(const int fd, const uint8_t* first, size_t first_size, const uint8_t* second,
+              size_t second_size) {
+    while (first_size + second_size > 0) {
+        iovec vectors[2] = {{.iov_base = const_cast<uint8_t*>(first), .iov_len = first_size},
+                            {.iov_base = const_cast<uint8_t*>(second), .iov_len = second_size}};
+        const ssize_t written = writev(fd, vectors, 2);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        const size_t from_first = std::min(static_cast<size_t>(written), first_size);
+        first += from_first;
+        first_size -= from_first;
+        second += static_cast<size_t>(written) - from_first;
+        second_size -= static_cast<size_t>(written) - from_first;
+    }
+    return true;
+}
+
+#else
+
+bool WriteAll(const int, const uint8_t*, size_t, const uint8_t*, size_t) {
+    return false;
+}
+
+#endif
+
+}  // namespace
+
+FrameSink::FrameSink(const int fd, const Width width, const Height height, const Format format,
+                     const uint32_t frame_rate, const size_t max_queued_frames)
+    : fd_{fd},
+      width_{width},
+      height_{height},
+      format_{format},
+      frame_rate_{frame_rate},
+      max_queued_frames_{max_queued_frames} {
+    {
+        assert((fd >= 0) and "FrameSink: дескриптор должен быть открыт");
+        assert((width != 0) and "FrameSink: ширина кадров не может быть 0");
+        assert((height != 0) and "FrameSink: высота кадров не может быть 0");
+        assert((frame_rate > 0) and "FrameSink: частота кадров должна быть больше 0");
+        assert((max_queued_frames > 0) and
+               "FrameSink: размер очереди кадров должен быть больше 0");
+    }
+    write_thread_ = std::thread{&FrameSink::WriteLoop, this};
+}
+
+FrameSink::~FrameSink() {
+    Wait();
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    frame_queued_.notify_all();
+    write_thread_.join();
+}
+
+bool FrameSink::Push(Image&& image) {
+    {
+        assert((image.GetWidth() == width_ and image.GetHeight() == height_) and
+               "Push: размеры изображения должны совпадать с размерами кадров");
+    }
+    {
+        std::unique_lock lock{mutex_};
+        frame_done_.wait(lock, [this]() { return frames_in_flight_ < max_queued_frames_; });
+        if (failed_) {
+            return false;
+        }
+        ++frames_in_flight_;
+        queue_.push_back(std::move(image));
+    }
+    frame_queued_.notify_one();
+    return true;
+}
+
+Image FrameSink::AcquireFramebuffer() {
+    std::unique_lock lock{mutex_};
+    if (free_framebuffers_.empty()) {
+        lock.unlock();
+        return Image{width_, height_};
+    }
+    Image image = std::move(free_framebuffers_.back());
+    free_framebuffers_.pop_back();
+    return image;
+}
+
+bool FrameSink::Wait() {
+    std::unique_lock lock{mutex_};
+    frame_done_.wait(lock, [this]() { return frames_in_flight_ == 0; });
+    return not failed_;
+}
+
+void FrameSink::WriteLoop() {
+    Tracer::SetThreadName("FrameSink");
+    while (true) {
+        std::unique_lock lock{mutex_};
+        frame_queued_.wait(lock, [this]() { return stop_ or not queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        Image image = std::move(queue_.front());
+        queue_.pop_front();
+        const bool failed = failed_;
+        lock.unlock();
+
+        // после ошибки оставшиеся кадры не записываются, чтобы не испортить поток
+        const bool written = not failed and WriteFrame(image);
+        std::fill(image.AccessData(), image.AccessData() + image.GetWidth() * image.GetHeight(),
+                  Image::Pixel{.r = 0, .g = 0, .b = 0});
+        {
+            std::lock_guard guard{mutex_};
+            failed_ = failed_ or not written;
+            free_framebuffers_.push_back(std::move(image));
+            --frames_in_flight_;
+        }
+        frame_done_.notify_all();
+    }
+}
+
+bool FrameSink::WriteFrame(const Image& image) {
+    TraceScope trace{"WriteFrame"};
+    if (format_ == RAW_RGB) {
+        return WriteAll(fd_, reinterpret_cast<const uint8_t*>(image.AccessData()),
+                        image.GetWidth() * image.GetHeight() * sizeof(Image::Pixel), nullptr, 0);
+    }
+    ConvertToYuv(image);
+    std::string header;
+    if (not header_written_) {
+        header = "YUV4MPEG2 W" + std::to_string(width_) + " H" + std::to_string(height_) + " F" +
+                 std::to_string(frame_rate_) + ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+        header_written_ = true;
+    }
+    return WriteAll(fd_, reinterpret_cast<const uint8_t*>(header.data()), header.size(),
+                    frame_.data(), frame_.size());
+}
+
+void FrameSink::ConvertToYuv(const Image& image) {
+    TraceScope trace{"ConvertToYuv"};
+    constexpr char kFrameMarker[] = "FRAME\n";
+    constexpr size_t kMarkerSize = sizeof(kFrameMarker) - 1;
+    const size_t width = width_;
+    const size_t height = height_;
+    const size_t chroma_width = (width + 1) / 2;
+    const size_t chroma_height = (height + 1) / 2;
+    frame_.resize(kMarkerSize + width * height + 2 * chroma_width * chroma_height);
+    std::copy(kFrameMarker, kFrameMarker + kMarkerSize, frame_.begin());
+    uint8_t* luma = frame_.data() + kMarkerSize;
+    uint8_t* chroma_u = luma + width * height;
+    uint8_t* chroma_v = chroma_u + chroma_width * chroma_height;
+
+    // плоскости R, G, B верхней и нижней строки пары и усредненной по 2x2 строки
+    rows_.resize(6 * width + 3 * chroma_width);
+    uint8_t* top[3] = {rows_.data(), rows_.data() + width, rows_.data() + 2 * width};
+    uint8_t* bottom[3] = {top[2] + width, top[2] + 2 * width, top[2] + 3 * width};
+    uint8_t* average[3] = {bottom[2] + width, bottom[2] + width + chroma_width,
+                           bottom[2] + width + 2 * chroma_width};
+    for (size_t y = 0; y < height; y += 2) {
+        SplitRow(image.AccessData() + y * width, width, top[0], top[1], top[2]);
+        ConvertPlane(top[0], top[1], top[2], width, kLuma, luma + y * width);
+        // при нечетной высоте последняя строка усредняется сама с собой
+        uint8_t* const* second = top;
+        if (y + 1 < height) {
+            SplitRow(image.AccessData() + (y + 1) * width, width, bottom[0], bottom[1],
+                     bottom[2]);
+            ConvertPlane(bottom[0], bottom[1], bottom[2], width, kLuma, luma + (y + 1) * width);
+            second = bottom;
+        }
+        for (size_t channel = 0; channel < 3; ++channel) {
+            DownsampleRows(top[channel], second[channel], width, average[channel]);
+        }
+        const size_t offset = y / 2 * chroma_width;
+        ConvertPlane(average[0], average[1], average[2], chroma_width, kChromaU,
+                     chroma_u + offset);
+        ConvertPlane(average[0], average[1], average[2], chroma_width, kChromaV,
+                     chroma_v + offset);
+    }
+}
+
+}  // namespace renderer
@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Потоковый вывод последовательности кадров в Y4M или сырой RGB
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "renderer/image.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Вывод последовательности кадров в файловый дескриптор
+ *
+ * Записывает кадры анимации одним потоком в файл или канал, например в stdin процесса
+ * видеокодировщика. Кадры принимаются через Push и записываются отдельным потоком вывода в
+ * порядке отправки. Очередь ограничена (по умолчанию два кадра: записываемый и ожидающий),
+ * поэтому преобразование и запись кадра N идут одновременно с рендерингом кадра N + 1, а Push
+ * ждет, только если вывод не успевает за рендерингом
+ *
+ * В формате Y4M кадры переводятся в YUV 4:2:0 (BT.601, ограниченный диапазон, цветность
+ * усредняется по блокам 2x2). Преобразование выполняется потоком вывода, на x86 через SSE2. В
+ * формате RAW_RGB пиксели изображения записываются без копирования, по 3 байта на пиксель
+ *
+ * Записанные изображения очищаются в черный цвет и возвращаются в пул, откуда их можно взять
+ * через AcquireFramebuffer для следующих кадров
+ *
+ * Запись выполняется через POSIX write, на других системах вывод всегда завершается ошибкой.
+ * Если читатель канала завершился, запись вызывает SIGPIPE, который приложение должно
+ * игнорировать, чтобы получить ошибку записи вместо завершения процесса
+ */
+class FrameSink {
+public:
+    /**
+     * @brief Формат потока
+     */
+    enum Format : uint8_t {
+        /**
+         * YUV4MPEG2, заголовок потока и кадры YUV 4:2:0
+         */
+        Y4M,
+        /**
+         * Кадры RGB24 подряд без заголовков
+         */
+        RAW_RGB
+    };
+
+    /**
+     * @brief Создание вывода
+     *
+     * Дескриптор не закрывается выводом и должен оставаться открытым до завершения вывода
+     *
+     * @param[in] fd Дескриптор файла или канала, открытый на запись
+     * @param[in] width Ширина кадров, должна быть больше 0
+     * @param[in] height Высота кадров, должна быть больше 0
+     * @param[in] format Формат потока
+     * @param[in] frame_rate Кадров в секунду, записывается в заголовок Y4M
+     * @param[in] max_queued_frames Максимальное число отправленных, но не записанных кадров,
+     * больше 0
+     */
+    FrameSink(const int fd, const Width width, const Height height, const Format format,
+              const uint32_t frame_rate = 30, const size_t max_queued_frames = 2);
+
+    /**
+     * @brief Завершение вывода
+     *
+     * Дожидается записи всех отправленных кадров
+     */
+    ~FrameSink();
+
+    /**
+     * @brief Отправка кадра
+     *
+     * Ставит изображение в очередь записи, ожидая места в очереди. Требуется, чтобы размеры
+     * изображения совпадали с размерами кадров вывода
+     *
+     * @param[in] image Изображение кадра
+     *
+     * @return false, если запись одного из предыдущих кадров завершилась ошибкой. В этом случае
+     * кадр не записывается
+     */
+    bool Push(Image&& image);
+
+    /**
+     * @brief Получение изображения для следующего кадра
+     *
+     * Возвращает записанное изображение из пула, очищенное в черный цвет, или создает новое
+     *
+     * @return Изображение размера кадров вывода
+     */
+    Image AcquireFramebuffer();
+
+    /**
+     * @brief Ожидание записи всех отправленных кадров
+     *
+     * @return true, если все кадры записаны без ошибок
+     */
+    bool Wait();
+
+    FrameSink(const FrameSink& other) = delete;
+    FrameSink(FrameSink&& other) = delete;
+
+    FrameSink& operator=(const FrameSink& other) = delete;
+    FrameSink& operator=(FrameSink&& other) = delete;
+
+private:
+    /**
+     * @brief Цикл потока вывода
+     */
+    void WriteLoop();
+
+    /**
+     * @brief Запись кадра
+     *
+     * Вызывается только потоком вывода. Перед первым кадром Y4M записывает заголовок потока
+     *
+     * @param[in] image Изображение кадра
+     *
+     * @return true, если кадр записан
+     */
+    bool WriteFrame(const Image& image);
+
+    /**
+     * @brief Перевод изображения в кадр Y4M
+     *
+     * Заполняет frame_ строкой "FRAME" и плоскостями Y, U и V
+     *
+     * @param[in] image Изображение кадра
+     */
+    void ConvertToYuv(const Image& image);
+
+    const int fd_;
+    const Width width_;
+    const Height height_;
+    const Format format_;
+    const uint32_t frame_rate_;
+    const size_t max_queued_frames_;
+
+    // используются только потоком вывода
+    std::vector<uint8_t> frame_;
+    std::vector<uint8_t> rows_;  // плоскости R, G, B двух строк и усредненной строки
+    bool header_written_{false};
+
+    std::mutex mutex_;
+    std::condition_variable frame_queued_;
+    std::condition_variable frame_done_;
+    std::deque<Image> queue_;
+    size_t frames_in_flight_{0};  // отправленные и еще не записанные кадры
+    std::vector<Image> free_framebuffers_;
+    bool failed_{false};
+    bool stop_{false};
+
+    std::thread write_thread_;
+};
+
+}  // namespace renderer
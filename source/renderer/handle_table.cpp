@@ -0,0 +1,79 @@
+#include "renderer/handle_table.hpp"
+
+#include <cassert>
+
+namespace renderer {
+
+namespace {
+
+constexpr size_t kSlotBits = 32;
+constexpr size_t kSlotMask = (size_t{1} << kSlotBits) - 1;
+
+}  // namespace
+
+HandleTable::Handle HandleTable::Push() {
+    uint32_t slot;
+    if (free_slots_.empty()) {
+        {
+            assert((slots_.size() < kFreeSlot) and "Push: превышено количество элементов");
+        }
+        slot = slots_.size();
+        slots_.push_back(Slot{.index = kFreeSlot, .generation = 0});
+    } else {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    slots_[slot].index = index_to_slot_.size();
+    index_to_slot_.push_back(slot);
+    return (static_cast<size_t>(slots_[slot].generation) << kSlotBits) | slot;
+}
+
+size_t HandleTable::Remove(const Handle handle) {
+    {
+        assert(Contains(handle) and "Remove: элемента с переданным ID не существует");
+    }
+    const uint32_t slot = handle & kSlotMask;
+    const size_t index = slots_[slot].index;
+    const uint32_t moved_slot = index_to_slot_.back();
+    index_to_slot_[index] = moved_slot;
+    slots_[moved_slot].index = index;
+    index_to_slot_.pop_back();
+
+    slots_[slot].index = kFreeSlot;
+    ++slots_[slot].generation;
+    free_slots_.push_back(slot);
+    return index;
+}
+
+bool HandleTable::Contains(const Handle handle) const {
+    const size_t slot = handle & kSlotMask;
+    return slot < slots_.size() and slots_[slot].index != kFreeSlot and
+           slots_[slot].generation == (handle >> kSlotBits);
+}
+
+size_t HandleTable::IndexOf(const Handle handle) const {
+    {
+        assert(Contains(handle) and "IndexOf: элемента с переданным ID не существует");
+    }
+    return slots_[handle & kSlotMask].index;
+}
+
+HandleTable::Handle HandleTable::HandleOf(const size_t index) const {
+    {
+        assert((index < index_to_slot_.size()) and
+               "HandleOf: номер должен быть меньше количества элементов");
+    }
+    const uint32_t slot = index_to_slot_[index];
+    return (static_cast<size_t>(slots_[slot].generation) << kSlotBits) | slot;
+}
+
+size_t HandleTable::Size() const {
+    return index_to_slot_.size();
+}
+
+size_t HandleTable::GetMemoryBytes() const {
+    return slots_.capacity() * sizeof(Slot) + index_to_slot_.capacity() * sizeof(uint32_t) +
+           free_slots_.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace renderer
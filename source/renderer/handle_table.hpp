@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Таблица поколенческих ID
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace renderer {
+
+/**
+ * @brief Таблица поколенческих ID
+ *
+ * Сопоставляет устойчивые ID элементам плотного массива, хранящегося снаружи. ID состоит из
+ * номера ячейки (младшие 32 бита) и поколения ячейки (старшие 32 бита). При удалении элемента
+ * поколение ячейки увеличивается, поэтому ID удаленного элемента перестает быть действительным, а
+ * сама ячейка переиспользуется следующим добавленным элементом
+ *
+ * Удаление выполняется перестановкой последнего элемента на место удаленного, поэтому порядок
+ * элементов плотного массива при удалении меняется. Первые добавленные в пустую таблицу элементы
+ * получают ID 0, 1, 2, ...
+ */
+class HandleTable {
+public:
+    /**
+     * @brief ID элемента
+     */
+    using Handle = size_t;
+
+    /**
+     * @brief Добавление элемента
+     *
+     * Регистрирует новый элемент, который должен быть добавлен в конец плотного массива
+     *
+     * @return ID элемента
+     */
+    Handle Push();
+
+    /**
+     * @brief Удаление элемента
+     *
+     * Удаляет элемент из таблицы. Вызывающий должен переместить последний элемент плотного массива
+     * на место с возвращенным номером и удалить последний элемент. Требуется, чтобы элемент
+     * существовал
+     *
+     * @param[in] handle ID элемента
+     *
+     * @return Номер удаленного элемента в плотном массиве
+     */
+    size_t Remove(const Handle handle);
+
+    /**
+     * @brief Проверка существования элемента
+     *
+     * @param[in] handle ID элемента
+     *
+     * @return Существует ли элемент с таким ID
+     */
+    bool Contains(const Handle handle) const;
+
+    /**
+     * @brief Номер элемента в плотном массиве
+     *
+     * Требуется, чтобы элемент существовал
+     *
+     * @param[in] handle ID элемента
+     *
+     * @return Номер элемента
+     */
+    size_t IndexOf(const Handle handle) const;
+
+    /**
+     * @brief ID элемента по номеру в плотном массиве
+     *
+     * Требуется, чтобы index был меньше количества элементов
+     *
+     * @param[in] index Номер элемента
+     *
+     * @return ID элемента
+     */
+    Handle HandleOf(const size_t index) const;
+
+    /**
+     * @brief Количество элементов
+     *
+     * @return Количество элементов
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Память таблицы
+     *
+     * @return Размер выделенных массивов в байтах
+     */
+    size_t GetMemoryBytes() const;
+
+private:
+    static constexpr uint32_t kFreeSlot = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        uint32_t index;       // номер элемента в плотном массиве или kFreeSlot
+        uint32_t generation;  // увеличивается при каждом удалении элемента из ячейки
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> index_to_slot_;
+    std::vector<uint32_t> free_slots_;
+};
+
+};  // namespace renderer
@@ -1,7 +1,10 @@
 #include "renderer/image.hpp"
 
+#include <algorithm>
 #include <cassert>
 
+#include "renderer/thread_pool.hpp"
+
 namespace renderer {
 
 Color Image::Pixel::ToColor(const Image::Pixel& pixel) {
@@ -10,7 +13,18 @@ Color Image::Pixel::ToColor(const Image::Pixel& pixel) {
 }
 
 Image::Image(const Width width, const Height height) : width_{width} {
+    image_.resize(width_ * static_cast<size_t>(height), Pixel{0, 0, 0});
+}
+
+Image::Image(const Width width, const Height height, ThreadPool& thread_pool) : width_{width} {
+    // строки заполняются потоками ThreadPool, страницы изображения распределяются по их узлам NUMA
     image_.resize(width_ * static_cast<size_t>(height));
+    const size_t rows_per_thread = height / thread_pool.GetWorkersCount() + 1;
+    thread_pool.ParallelFor(0, height, rows_per_thread,
+                            [this](const size_t begin, const size_t end) {
+                                std::fill(image_.begin() + begin * width_,
+                                          image_.begin() + end * width_, Pixel{0, 0, 0});
+                            });
 }
 
 size_t Image::GetWidth() const {
@@ -48,4 +62,8 @@ const Image::Pixel* Image::AccessData() const {
     return image_.data();
 }
 
+size_t Image::GetMemoryBytes() const {
+    return image_.capacity() * sizeof(Pixel);
+}
+
 }  // namespace renderer
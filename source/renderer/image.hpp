@@ -9,9 +9,12 @@
 #include <vector>
 
 #include "renderer/color.hpp"
+#include "renderer/numa.hpp"
 
 namespace renderer {
 
+class ThreadPool;
+
 /**
  * @brief Ширина изображения
  */
@@ -53,11 +56,25 @@ public:
     /**
      * @brief Создание изображения
      *
+     * Изображение заполняется черным цветом в вызывающем потоке
+     *
      * @param[in] width Ширина изображения
      * @param[in] height Высота изображения
      */
     Image(const Width width, const Height height);
 
+    /**
+     * @brief Создание изображения с заполнением потоками ThreadPool
+     *
+     * Строки изображения заполняются черным цветом потоками переданного ThreadPool, поэтому его
+     * страницы распределяются по узлам NUMA этих потоков
+     *
+     * @param[in] width Ширина изображения
+     * @param[in] height Высота изображения
+     * @param[in] thread_pool ThreadPool, потоки которого будут работать с изображением
+     */
+    Image(const Width width, const Height height, ThreadPool& thread_pool);
+
     /**
      * @brief Получение ширины изображения
      *
@@ -117,8 +134,15 @@ public:
      */
     const Pixel* AccessData() const;
 
+    /**
+     * @brief Память изображения
+     *
+     * @return Размер выделенного массива пикселей в байтах
+     */
+    size_t GetMemoryBytes() const;
+
 private:
     size_t width_;
-    std::vector<Pixel> image_;
+    std::vector<Pixel, FirstTouchAllocator<Pixel>> image_;
 };
 };  // namespace renderer
@@ -0,0 +1,775 @@
+#include "renderer/image_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) or defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#endif
+
+namespace renderer {
+
+namespace {
+
+static_assert(sizeof(Image::Pixel) == 3, "Пиксели должны лежать подряд по 3 байта");
+
+/**
+ * @brief Байты на пиксель во всех форматах
+ */
+constexpr size_t kBytesPerPixel = 3;
+
+/**
+ * @brief Размер заголовков BMP: BITMAPFILEHEADER и BITMAPINFOHEADER
+ */
+constexpr size_t kBmpFileHeaderSize = 14;
+constexpr size_t kBmpInfoHeaderSize = 40;
+
+/**
+ * @brief Константы QOI
+ */
+constexpr uint8_t kQoiOpIndex = 0x00;
+constexpr uint8_t kQoiOpDiff = 0x40;
+constexpr uint8_t kQoiOpLuma = 0x80;
+constexpr uint8_t kQoiOpRun = 0xc0;
+constexpr uint8_t kQoiOpRgb = 0xfe;
+constexpr size_t kQoiMaxRun = 62;
+constexpr size_t kQoiHeaderSize = 14;
+constexpr std::array<uint8_t, 8> kQoiEnd = {0, 0, 0, 0, 0, 0, 0, 1};
+
+/**
+ * @brief Константы PNG и deflate
+ */
+constexpr std::array<uint8_t, 8> kPngSignature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+constexpr size_t kPngChunkOverhead = 12;  // длина, тип и CRC
+constexpr uint32_t kAdlerModulo = 65521;
+constexpr size_t kAdlerBlock = 5552;  // наибольший блок без переполнения сумм
+constexpr size_t kWindowSize = 1 << 15;
+constexpr size_t kHashBits = 15;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr size_t kMaxChain = 16;  // проверяемые совпадения на позицию
+
+/**
+ * @brief Запись чисел в порядке байтов формата
+ */
+void PutLittle16(uint8_t* output, const uint16_t value) {
+    output[0] = static_cast<uint8_t>(value);
+    output[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutLittle32(uint8_t* output, const uint32_t value) {
+    PutLittle16(output, static_cast<uint16_t>(value));
+    PutLittle16(output + 2, static_cast<uint16_t>(value >> 16));
+}
+
+void PutBig32(uint8_t* output, const uint32_t value) {
+    output[0] = static_cast<uint8_t>(value >> 24);
+    output[1] = static_cast<uint8_t>(value >> 16);
+    output[2] = static_cast<uint8_t>(value >> 8);
+    output[3] = static_cast<uint8_t>(value);
+}
+
+void AppendBig32(std::vector<uint8_t>& output, const uint32_t value) {
+    output.resize(output.size() + 4);
+    PutBig32(output.data() + output.size() - 4, value);
+}
+
+/**
+ * @brief Пиксели изображения как байты RGB
+ */
+std::span<const uint8_t> GetBytes(const Image& image) {
+    return {reinterpret_cast<const uint8_t*>(image.AccessData()),
+            image.GetWidth() * image.GetHeight() * kBytesPerPixel};
+}
+
+/**
+ * @brief Заголовок PPM, за ним в файле следуют пиксели изображения без преобразования
+ */
+std::vector<uint8_t> EncodePpmHeader(const Image& image) {
+    const std::string text = "P6\n" + std::to_string(image.GetWidth()) + ' ' +
+                             std::to_string(image.GetHeight()) + "\n255\n";
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+/**
+ * @brief Кодирование QOI
+ *
+ * Каждый пиксель зависит от предыдущего, поэтому кодирование последовательное
+ */
+std::vector<uint8_t> EncodeQoi(const Image& image) {
+    const size_t pixels_count = image.GetWidth() * image.GetHeight();
+    std::vector<uint8_t> output(kQoiHeaderSize + pixels_count * (kBytesPerPixel + 1) +
+                                kQoiEnd.size());
+    uint8_t* cursor = output.data();
+    std::memcpy(cursor, "qoif", 4);
+    PutBig32(cursor + 4, static_cast<uint32_t>(image.GetWidth()));
+    PutBig32(cursor + 8, static_cast<uint32_t>(image.GetHeight()));
+    cursor[12] = kBytesPerPixel;
+    cursor[13] = 0;  // sRGB с линейной альфой
+    cursor += kQoiHeaderSize;
+
+    // в таблице хранятся RGBA, альфа всегда 255, поэтому нулевые записи не совпадут с пикселем
+    std::array<uint32_t, 64> index{};
+    auto pack = [](const Image::Pixel& pixel) {
+        return (uint32_t{pixel.r} << 24) | (uint32_t{pixel.g} << 16) | (uint32_t{pixel.b} << 8) |
+               0xffu;
+    };
+    const Image::Pixel* pixels = image.AccessData();
+    Image::Pixel previous{.r = 0, .g = 0, .b = 0};
+    size_t run = 0;
+    for (size_t i = 0; i < pixels_count; ++i) {
+        const Image::Pixel& pixel = pixels[i];
+        if (pixel.r == previous.r and pixel.g == previous.g and pixel.b == previous.b) {
+            ++run;
+            if (run == kQoiMaxRun or i + 1 == pixels_count) {
+                *cursor++ = static_cast<uint8_t>(kQoiOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *cursor++ = static_cast<uint8_t>(kQoiOpRun | (run - 1));
+            run = 0;
+        }
+        const uint8_t hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + 255 * 11) % 64;
+        if (index[hash] == pack(pixel)) {
+            *cursor++ = kQoiOpIndex | hash;
+        } else {
+            index[hash] = pack(pixel);
+            const int8_t dr = static_cast<int8_t>(pixel.r - previous.r);
+            const int8_t dg = static_cast<int8_t>(pixel.g - previous.g);
+            const int8_t db = static_cast<int8_t>(pixel.b - previous.b);
+            const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+            const int8_t db_dg = static_cast<int8_t>(db - dg);
+            if (dr >= -2 and dr <= 1 and dg >= -2 and dg <= 1 and db >= -2 and db <= 1) {
+                *cursor++ =
+                    static_cast<uint8_t>(kQoiOpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+            } else if (dg >= -32 and dg <= 31 and dr_dg >= -8 and dr_dg <= 7 and db_dg >= -8 and
+                       db_dg <= 7) {
+                *cursor++ = static_cast<uint8_t>(kQoiOpLuma | (dg + 32));
+                *cursor++ = static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+            } else {
+                *cursor++ = kQoiOpRgb;
+                *cursor++ = pixel.r;
+                *cursor++ = pixel.g;
+                *cursor++ = pixel.b;
+            }
+        }
+        previous = pixel;
+    }
+    cursor = std::copy(kQoiEnd.begin(), kQoiEnd.end(), cursor);
+    output.resize(cursor - output.data());
+    return output;
+}
+
+/**
+ * @brief Таблица CRC-32 для чанков PNG
+ */
+constexpr std::array<uint32_t, 256> kCrcTable = []() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (0xedb88320u ^ (crc >> 1)) : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+uint32_t Crc32(const uint8_t* data, const size_t size) {
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = kCrcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+/**
+ * @brief Контрольная сумма Adler-32 потока zlib
+ */
+uint32_t Adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0) {
+        const size_t block = std::min(size, kAdlerBlock);
+        for (size_t i = 0; i < block; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= kAdlerModulo;
+        b %= kAdlerModulo;
+        data += block;
+        size -= block;
+    }
+    return (b << 16) | a;
+}
+
+/**
+ * @brief Adler-32 склейки данных по суммам частей
+ *
+ * @param[in] first Сумма первой части
+ * @param[in] second Сумма второй части
+ * @param[in] second_size Размер второй части
+ */
+uint32_t CombineAdler32(const uint32_t first, const uint32_t second, const size_t second_size) {
+    const uint64_t a1 = first & 0xffff;
+    const uint64_t b1 = first >> 16;
+    const uint64_t a2 = second & 0xffff;
+    const uint64_t b2 = second >> 16;
+    const uint64_t size = second_size % kAdlerModulo;
+    const uint64_t a = (a1 + a2 + kAdlerModulo - 1) % kAdlerModulo;
+    const uint64_t b = (b1 + b2 + size * (a1 + kAdlerModulo - 1)) % kAdlerModulo;
+    return static_cast<uint32_t>((b << 16) | a);
+}
+
+/**
+ * @brief Запись чанка PNG с длиной, типом и CRC
+ */
+void AppendPngChunk(std::vector<uint8_t>& output, const char* type,
+                    std::span<const uint8_t> data) {
+    AppendBig32(output, static_cast<uint32_t>(data.size()));
+    const size_t begin = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data.begin(), data.end());
+    AppendBig32(output, Crc32(output.data() + begin, output.size() - begin));
+}
+
+/**
+ * @brief Предсказатель Paeth фильтра PNG
+ */
+uint8_t Paeth(const uint8_t left, const uint8_t up, const uint8_t up_left) {
+    const int predictor = int{left} + int{up} - int{up_left};
+    const int to_left = std::abs(predictor - int{left});
+    const int to_up = std::abs(predictor - int{up});
+    const int to_up_left = std::abs(predictor - int{up_left});
+    if (to_left <= to_up and to_left <= to_up_left) {
+        return left;
+    }
+    return (to_up <= to_up_left) ? up : up_left;
+}
+
+/**
+ * @brief Фильтрация строки PNG
+ *
+ * Перебирает фильтры None, Sub, Up и Paeth и выбирает тот, у которого меньше сумма модулей
+ * результата. Записывает байт типа фильтра и отфильтрованную строку
+ *
+ * @param[in] row Строка
+ * @param[in] previous Предыдущая строка или nullptr для первой строки изображения
+ * @param[in] size Размер строки в байтах
+ * @param[out] output Буфер размера size + 1
+ * @param[in,out] scratch Буфер размера size для сравнения фильтров
+ */
+void FilterRow(const uint8_t* row, const uint8_t* previous, const size_t size, uint8_t* output,
+               uint8_t* scratch) {
+    auto cost = [size](const uint8_t* data) {
+        size_t sum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum += static_cast<size_t>(std::abs(static_cast<int8_t>(data[i])));
+        }
+        return sum;
+    };
+    auto filter = [row, previous, size](const uint8_t type, uint8_t* result) {
+        for (size_t i = 0; i < size; ++i) {
+            const uint8_t left = (i >= kBytesPerPixel) ? row[i - kBytesPerPixel] : 0;
+            const uint8_t up = (previous != nullptr) ? previous[i] : 0;
+            const uint8_t up_left =
+                (previous != nullptr and i >= kBytesPerPixel) ? previous[i - kBytesPerPixel] : 0;
+            const uint8_t predicted = (type == 1) ? left : (type == 2) ? up
+                                                       : (type == 4)   ? Paeth(left, up, up_left)
+                                                                       : 0;
+            result[i] = static_cast<uint8_t>(row[i] - predicted);
+        }
+    };
+    constexpr uint8_t kFilters[] = {1, 2, 4};  // Sub, Up, Paeth
+    uint8_t best = 0;
+    size_t best_cost = cost(row);
+    for (const uint8_t type : kFilters) {
+        filter(type, scratch);
+        const size_t current = cost(scratch);
+        if (current < best_cost) {
+            best = type;
+            best_cost = current;
+        }
+    }
+    output[0] = best;
+    filter(best, output + 1);
+}
+
+/**
+ * @brief Запись битового потока deflate, младшие биты первыми
+ */
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& output) : output_{output} {
+    }
+
+    void Put(const uint32_t value, const uint32_t length) {
+        bits_ |= uint64_t{value} << count_;
+        count_ += length;
+        while (count_ >= 8) {
+            output_.push_back(static_cast<uint8_t>(bits_));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void Align() {
+        if (count_ > 0) {
+            Put(0, 8 - count_);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& output_;
+    uint64_t bits_ = 0;
+    uint32_t count_ = 0;
+};
+
+/**
+ * @brief Код Хаффмана с битами в порядке записи
+ */
+struct HuffmanCode {
+    uint16_t bits;
+    uint8_t length;
+};
+
+constexpr uint16_t ReverseBits(uint16_t code, const uint8_t length) {
+    uint16_t result = 0;
+    for (uint8_t i = 0; i < length; ++i) {
+        result = static_cast<uint16_t>((result << 1) | (code & 1));
+        code >>= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Фиксированные коды литералов и длин deflate
+ */
+constexpr std::array<HuffmanCode, 288> kLiteralCodes = []() {
+    std::array<HuffmanCode, 288> codes{};
+    for (uint16_t symbol = 0; symbol < 288; ++symbol) {
+        uint16_t code = 0;
+        uint8_t length = 0;
+        if (symbol < 144) {
+            code = 0x30 + symbol;
+            length = 8;
+        } else if (symbol < 256) {
+            code = 0x190 + symbol - 144;
+            length = 9;
+        } else if (symbol < 280) {
+            code = symbol - 256;
+            length = 7;
+        } else {
+            code = 0xc0 + symbol - 280;
+            length = 8;
+        }
+        codes[symbol] = HuffmanCode{.bits = ReverseBits(code, length), .length = length};
+    }
+    return codes;
+}();
+
+/**
+ * @brief Запись литерала
+ */
+void PutLiteral(BitWriter& writer, const uint16_t symbol) {
+    writer.Put(kLiteralCodes[symbol].bits, kLiteralCodes[symbol].length);
+}
+
+/**
+ * @brief Запись совпадения: длина от 3 до 258, расстояние от 1 до 32768
+ */
+void PutMatch(BitWriter& writer, const size_t length, const size_t distance) {
+    if (length == kMaxMatch) {
+        PutLiteral(writer, 285);
+    } else {
+        const uint32_t value = static_cast<uint32_t>(length - kMinMatch);
+        if (value < 8) {
+            PutLiteral(writer, static_cast<uint16_t>(257 + value));
+        } else {
+            const uint32_t extra = std::bit_width(value) - 3;
+            const uint32_t symbol = 257 + 4 * (extra + 1) + ((value >> extra) & 3);
+            PutLiteral(writer, static_cast<uint16_t>(symbol));
+            writer.Put(value & ((1u << extra) - 1), extra);
+        }
+    }
+    const uint32_t value = static_cast<uint32_t>(distance - 1);
+    if (value < 4) {
+        writer.Put(ReverseBits(static_cast<uint16_t>(value), 5), 5);
+    } else {
+        const uint32_t extra = std::bit_width(value) - 2;
+        const uint16_t code = static_cast<uint16_t>(2 * (extra + 1) + ((value >> extra) & 1));
+        writer.Put(ReverseBits(code, 5), 5);
+        writer.Put(value & ((1u << extra) - 1), extra);
+    }
+}
+
+/**
+ * @brief Сжатие данных одним блоком deflate с фиксированными кодами
+ *
+ * Совпадения ищутся жадно по цепочкам хешей трех байтов. Для незавершающей части поток
+ * выравнивается пустым несжатым блоком, чтобы следующая часть, сжатая независимо, начиналась с
+ * целого байта
+ *
+ * @param[in] data Данные
+ * @param[in] last Последняя ли часть потока
+ * @param[in,out] output Буфер, в конец которого дописывается результат
+ */
+void Deflate(std::span<const uint8_t> data, const bool last, std::vector<uint8_t>& output) {
+    BitWriter writer{output};
+    writer.Put(last ? 1 : 0, 1);
+    writer.Put(1, 2);  // фиксированные коды
+
+    std::vector<int32_t> head(size_t{1} << kHashBits, -1);
+    std::vector<int32_t> chain(kWindowSize, -1);
+    auto hash = [&data](const size_t position) {
+        const uint32_t value = (uint32_t{data[position]} << 16) |
+                               (uint32_t{data[position + 1]} << 8) | data[position + 2];
+        return (value * 2654435761u) >> (32 - kHashBits);
+    };
+    auto insert = [&head, &chain, &hash](const size_t position) {
+        const uint32_t key = hash(position);
+        chain[position & (kWindowSize - 1)] = head[key];
+        head[key] = static_cast<int32_t>(position);
+    };
+
+    size_t position = 0;
+    while (position < data.size()) {
+        size_t best_length = 0;
+        size_t best_distance = 0;
+        if (position + kMinMatch <= data.size()) {
+            const size_t max_length = std::min(kMaxMatch, data.size() - position);
+            int32_t candidate = head[hash(position)];
+            for (size_t step = 0; step < kMaxChain and candidate >= 0; ++step) {
+                const size_t distance = position - static_cast<size_t>(candidate);
+                if (distance > kWindowSize) {
+                    break;
+                }
+                const uint8_t* lhs = data.data() + candidate;
+                const uint8_t* rhs = data.data() + position;
+                size_t length = 0;
+                while (length < max_length and lhs[length] == rhs[length]) {
+                    ++length;
+                }
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = distance;
+                    if (length == max_length) {
+                        break;
+                    }
+                }
+                candidate = chain[static_cast<size_t>(candidate) & (kWindowSize - 1)];
+            }
+        }
+        if (best_length >= kMinMatch) {
+            PutMatch(writer, best_length, best_distance);
+            const size_t end = position + best_length;
+            for (; position < end; ++position) {
+                if (position + kMinMatch <= data.size()) {
+                    insert(position);
+                }
+            }
+        } else {
+            PutLiteral(writer, data[position]);
+            if (position + kMinMatch <= data.size()) {
+                insert(position);
+            }
+            ++position;
+        }
+    }
+    PutLiteral(writer, 256);  // конец блока
+
+    if (not last) {
+        writer.Put(0, 3);  // пустой несжатый блок
+        writer.Align();
+        constexpr uint8_t kEmptyStored[] = {0x00, 0x00, 0xff, 0xff};
+        output.insert(output.end(), std::begin(kEmptyStored), std::end(kEmptyStored));
+    }
+    writer.Align();
+}
+
+#if defined(__unix__) or defined(__APPLE__)
+
+/**
+ * @brief Запись буфера целиком с повтором при частичной записи
+ */
+bool WriteAll(const int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief Запись частей вызовами writev по IOV_MAX частей
+ */
+bool WriteVector(const int fd, std::span<const std::span<const uint8_t>> parts) {
+    std::vector<iovec> vectors;
+    vectors.reserve(parts.size());
+    for (const std::span<const uint8_t> part : parts) {
+        if (not part.empty()) {
+            vectors.push_back(iovec{.iov_base = const_cast<uint8_t*>(part.data()),
+                                    .iov_len = part.size()});
+        }
+    }
+    size_t first = 0;
+    while (first < vectors.size()) {
+        const int count = static_cast<int>(std::min<size_t>(vectors.size() - first, IOV_MAX));
+        ssize_t written = writev(fd, vectors.data() + first, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        // пропуск записанных частей и сдвиг начала частично записанной
+        while (first < vectors.size() and static_cast<size_t>(written) >= vectors[first].iov_len) {
+            written -= static_cast<ssize_t>(vectors[first].iov_len);
+            ++first;
+        }
+        if (first < vectors.size()) {
+            vectors[first].iov_base = static_cast<uint8_t*>(vectors[first].iov_base) + written;
+            vectors[first].iov_len -= static_cast<size_t>(written);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Запись частей через отображение файла в память
+ */
+bool WriteMapped(const int fd, std::span<const std::span<const uint8_t>> parts,
+                 const size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+    void* mapping = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    uint8_t* cursor = static_cast<uint8_t*>(mapping);
+    for (const std::span<const uint8_t> part : parts) {
+        cursor = std::copy(part.begin(), part.end(), cursor);
+    }
+    return munmap(mapping, size) == 0;
+}
+
+#endif
+
+}  // namespace
+
+void ImageWriter::Encoded::AddBuffer(std::vector<uint8_t> buffer) {
+    buffers.push_back(std::move(buffer));
+    AddPart(buffers.back());
+}
+
+void ImageWriter::Encoded::AddPart(std::span<const uint8_t> part) {
+    parts.push_back(part);
+    size += part.size();
+}
+
+ImageWriter::ImageWriter() : ImageWriter{ThreadPool::Get()} {
+}
+
+ImageWriter::ImageWriter(ThreadPool& thread_pool) : thread_pool_{&thread_pool} {
+}
+
+void ImageWriter::SetRowsPerStrip(const size_t rows) {
+    rows_per_strip_ = std::max<size_t>(rows, 1);
+}
+
+std::vector<uint8_t> ImageWriter::Encode(const Image& image, const Format format) const {
+    const Encoded encoded = EncodeParts(image, format);
+    std::vector<uint8_t> output;
+    output.reserve(encoded.size);
+    for (const std::span<const uint8_t> part : encoded.parts) {
+        output.insert(output.end(), part.begin(), part.end());
+    }
+    return output;
+}
+
+bool ImageWriter::Save(const Image& image, const std::string& path, const Format format,
+                       const Output output) const {
+    const Encoded encoded = EncodeParts(image, format);
+#if defined(__unix__) or defined(__APPLE__)
+    const int flags = (output == MMAP) ? O_RDWR : O_WRONLY;
+    const int fd = open(path.c_str(), flags | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = false;
+    if (output == WRITE) {
+        written = std::all_of(encoded.parts.begin(), encoded.parts.end(),
+                              [fd](const std::span<const uint8_t> part) {
+                                  return WriteAll(fd, part.data(), part.size());
+                              });
+    } else if (output == WRITEV) {
+        written = WriteVector(fd, encoded.parts);
+    } else {
+        written = WriteMapped(fd, encoded.parts, encoded.size);
+    }
+    return (close(fd) == 0) and written;
+#else
+    (void)output;
+    std::ofstream file{path, std::ios_base::binary | std::ios_base::trunc};
+    for (const std::span<const uint8_t> part : encoded.parts) {
+        file.write(reinterpret_cast<const char*>(part.data()),
+                   static_cast<std::streamsize>(part.size()));
+    }
+    return static_cast<bool>(file);
+#endif
+}
+
+ImageWriter::Encoded ImageWriter::EncodeParts(const Image& image, const Format format) const {
+    {
+        assert((image.GetWidth() > 0) and "ImageWriter: ширина должна быть больше 0");
+        assert((image.GetHeight() > 0) and "ImageWriter: высота должна быть больше 0");
+    }
+    switch (format) {
+        case BMP:
+            return EncodeBmp(image);
+        case PPM: {
+            Encoded encoded;
+            encoded.AddBuffer(EncodePpmHeader(image));
+            encoded.AddPart(GetBytes(image));
+            return encoded;
+        }
+        case QOI: {
+            Encoded encoded;
+            encoded.AddBuffer(EncodeQoi(image));
+            return encoded;
+        }
+        case PNG:
+            return EncodePng(image);
+    }
+    return Encoded{};
+}
+
+ImageWriter::Encoded ImageWriter::EncodeBmp(const Image& image) const {
+    const size_t width = image.GetWidth();
+    const size_t height = image.GetHeight();
+    const size_t row_size = (width * kBytesPerPixel + 3) / 4 * 4;  // строки выровнены на 4 байта
+    const size_t offset = kBmpFileHeaderSize + kBmpInfoHeaderSize;
+    std::vector<uint8_t> output(offset + row_size * height);
+
+    uint8_t* header = output.data();
+    PutLittle16(header, 0x4d42);  // "BM"
+    PutLittle32(header + 2, static_cast<uint32_t>(output.size()));
+    PutLittle32(header + 10, static_cast<uint32_t>(offset));
+    uint8_t* info = header + kBmpFileHeaderSize;
+    PutLittle32(info, kBmpInfoHeaderSize);
+    PutLittle32(info + 4, static_cast<uint32_t>(width));
+    PutLittle32(info + 8, static_cast<uint32_t>(height));
+    PutLittle16(info + 12, 1);                    // плоскости
+    PutLittle16(info + 14, kBytesPerPixel * 8);  // бит на пиксель
+    PutLittle32(info + 20, static_cast<uint32_t>(row_size * height));
+
+    // BMP хранит строки снизу вверх в порядке BGR, выравнивание уже заполнено нулями
+    const Image::Pixel* pixels = image.AccessData();
+    uint8_t* rows = output.data() + offset;
+    const size_t rows_per_thread = height / thread_pool_->GetWorkersCount() + 1;
+    thread_pool_->ParallelFor(0, height, rows_per_thread,
+                              [pixels, rows, width, height, row_size](const size_t begin,
+                                                                      const size_t end) {
+                                  for (size_t y = begin; y < end; ++y) {
+                                      const Image::Pixel* source = pixels + y * width;
+                                      uint8_t* target = rows + (height - 1 - y) * row_size;
+                                      for (size_t x = 0; x < width; ++x) {
+                                          target[3 * x] = source[x].b;
+                                          target[3 * x + 1] = source[x].g;
+                                          target[3 * x + 2] = source[x].r;
+                                      }
+                                  }
+                              });
+    Encoded encoded;
+    encoded.AddBuffer(std::move(output));
+    return encoded;
+}
+
+ImageWriter::Encoded ImageWriter::EncodePng(const Image& image) const {
+    const size_t width = image.GetWidth();
+    const size_t height = image.GetHeight();
+    const size_t row_size = width * kBytesPerPixel;
+    const size_t strips = (height + rows_per_strip_ - 1) / rows_per_strip_;
+
+    Encoded encoded;
+    std::vector<uint8_t> head(kPngSignature.begin(), kPngSignature.end());
+    std::array<uint8_t, 13> header{};
+    PutBig32(header.data(), static_cast<uint32_t>(width));
+    PutBig32(header.data() + 4, static_cast<uint32_t>(height));
+    header[8] = 8;  // бит на канал
+    header[9] = 2;  // RGB
+    AppendPngChunk(head, "IHDR", header);
+    encoded.AddBuffer(std::move(head));
+
+    // каждая полоса - отдельный чанк IDAT со своей частью потока zlib
+    std::vector<std::vector<uint8_t>> chunks(strips);
+    std::vector<uint32_t> checksums(strips);
+    std::vector<size_t> sizes(strips);
+    const uint8_t* bytes = GetBytes(image).data();
+    thread_pool_->ParallelFor(0, strips, 1, [&](const size_t begin, const size_t end) {
+        std::vector<uint8_t> filtered;
+        std::vector<uint8_t> scratch(row_size);
+        for (size_t strip = begin; strip < end; ++strip) {
+            const size_t first_row = strip * rows_per_strip_;
+            const size_t last_row = std::min(first_row + rows_per_strip_, height);
+            filtered.resize((last_row - first_row) * (row_size + 1));
+            for (size_t y = first_row; y < last_row; ++y) {
+                const uint8_t* row = bytes + y * row_size;
+                FilterRow(row, (y > 0) ? row - row_size : nullptr, row_size,
+                          filtered.data() + (y - first_row) * (row_size + 1), scratch.data());
+            }
+            checksums[strip] = Adler32(filtered.data(), filtered.size());
+            sizes[strip] = filtered.size();
+
+            std::vector<uint8_t>& chunk = chunks[strip];
+            chunk.reserve(filtered.size() / 2 + kPngChunkOverhead);
+            chunk.assign({0, 0, 0, 0, 'I', 'D', 'A', 'T'});
+            if (strip == 0) {
+                chunk.push_back(0x78);  // deflate, окно 32 КБ
+                chunk.push_back(0x01);
+            }
+            Deflate(filtered, strip + 1 == strips, chunk);
+            PutBig32(chunk.data(), static_cast<uint32_t>(chunk.size() - 8));
+            AppendBig32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+        }
+    });
+
+    uint32_t checksum = 1;
+    for (size_t strip = 0; strip < strips; ++strip) {
+        checksum = CombineAdler32(checksum, checksums[strip], sizes[strip]);
+        encoded.AddBuffer(std::move(chunks[strip]));
+    }
+    std::vector<uint8_t> tail;
+    std::array<uint8_t, 4> adler{};
+    PutBig32(adler.data(), checksum);
+    AppendPngChunk(tail, "IDAT", adler);
+    AppendPngChunk(tail, "IEND", {});
+    encoded.AddBuffer(std::move(tail));
+    return encoded;
+}
+
+}  // namespace renderer
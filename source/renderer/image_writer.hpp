@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief Запись изображений в форматах BMP, PPM, QOI и PNG
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "renderer/image.hpp"
+#include "renderer/thread_pool.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Запись изображений
+ *
+ * Кодирует Image в память целиком и записывает файл несколькими большими блоками, а не по
+ * пикселям. Преобразование строк BMP и сжатие PNG выполняются параллельно в ThreadPool
+ *
+ * PNG делится на полосы по несколько строк. Каждая полоса фильтруется и сжимается независимо и
+ * записывается отдельным чанком IDAT. Сжатие выполняет собственный кодировщик deflate с
+ * фиксированными кодами Хаффмана: файл получается больше, чем у zlib, но кодирование быстрое и
+ * не требует зависимостей
+ */
+class ImageWriter {
+public:
+    /**
+     * @brief Формат файла
+     */
+    enum Format : uint8_t {
+        /**
+         * BMP, 24 бита на пиксель, без сжатия
+         */
+        BMP,
+        /**
+         * Двоичный PPM (P6)
+         */
+        PPM,
+        /**
+         * QOI, 3 канала, кодируется последовательно
+         */
+        QOI,
+        /**
+         * PNG, 8 бит на канал, RGB
+         */
+        PNG
+    };
+
+    /**
+     * @brief Способ записи файла
+     */
+    enum Output : uint8_t {
+        /**
+         * Вызов write для каждой части файла (заголовок, данные, чанки)
+         */
+        WRITE,
+        /**
+         * Все части файла записываются одним вызовом writev без склеивания в один буфер
+         */
+        WRITEV,
+        /**
+         * Файл расширяется до итогового размера, отображается в память через mmap, и части
+         * копируются в отображение
+         */
+        MMAP
+    };
+
+    /**
+     * @brief Количество строк в полосе PNG по умолчанию
+     */
+    static constexpr size_t kDefaultRowsPerStrip = 64;
+
+    /**
+     * @brief Создание объекта записи
+     *
+     * Использует глобальный ThreadPool::Get()
+     */
+    ImageWriter();
+
+    /**
+     * @brief Создание объекта записи с переданным ThreadPool
+     *
+     * ThreadPool должен существовать дольше объекта записи
+     *
+     * @param[in] thread_pool ThreadPool для параллельного кодирования
+     */
+    explicit ImageWriter(ThreadPool& thread_pool);
+
+    /**
+     * @brief Задание размера полосы PNG
+     *
+     * Меньшие полосы лучше распределяются между потоками, большие сжимаются сильнее, так как
+     * словарь deflate не переходит между полосами
+     *
+     * @param[in] rows Количество строк в полосе, 0 считается за 1
+     */
+    void SetRowsPerStrip(const size_t rows);
+
+    /**
+     * @brief Кодирование изображения в память
+     *
+     * @param[in] image Изображение
+     * @param[in] format Формат
+     *
+     * @return Содержимое файла
+     */
+    std::vector<uint8_t> Encode(const Image& image, const Format format) const;
+
+    /**
+     * @brief Сохранение изображения в файл
+     *
+     * Существующий файл перезаписывается. На системах без POSIX все способы записи сводятся к
+     * записи частей через std::ofstream
+     *
+     * @param[in] image Изображение
+     * @param[in] path Путь к файлу
+     * @param[in] format Формат
+     * @param[in] output Способ записи
+     *
+     * @return true, если файл записан полностью
+     */
+    bool Save(const Image& image, const std::string& path, const Format format,
+              const Output output = WRITEV) const;
+
+private:
+    /**
+     * @brief Закодированное изображение
+     *
+     * Части файла в порядке записи. Части ссылаются на buffers или на пиксели изображения
+     */
+    struct Encoded {
+        std::vector<std::vector<uint8_t>> buffers;
+        std::vector<std::span<const uint8_t>> parts;
+        size_t size = 0;
+
+        /**
+         * @brief Добавление буфера как очередной части
+         */
+        void AddBuffer(std::vector<uint8_t> buffer);
+
+        /**
+         * @brief Добавление внешних данных как очередной части
+         */
+        void AddPart(std::span<const uint8_t> part);
+    };
+
+    /**
+     * @brief Кодирование изображения в части файла
+     */
+    Encoded EncodeParts(const Image& image, const Format format) const;
+
+    /**
+     * @brief Кодирование BMP, строки переставляются параллельно
+     */
+    Encoded EncodeBmp(const Image& image) const;
+
+    /**
+     * @brief Кодирование PNG, полосы сжимаются параллельно
+     */
+    Encoded EncodePng(const Image& image) const;
+
+    ThreadPool* thread_pool_;
+    size_t rows_per_strip_ = kDefaultRowsPerStrip;
+};
+
+};  // namespace renderer
@@ -7,13 +7,24 @@
 
 #include "renderer/camera.hpp"
 #include "renderer/color.hpp"
+#include "renderer/frame_sink.hpp"
+#include "renderer/image_writer.hpp"
 #include "renderer/light.hpp"
+#include "renderer/memory_report.hpp"
+#include "renderer/mesh_optimizer.hpp"
 #include "renderer/object.hpp"
 #include "renderer/primitives.hpp"
+#include "renderer/render_control.hpp"
+#include "renderer/render_pipeline.hpp"
+#include "renderer/render_stats.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/resources_manager.hpp"
 #include "renderer/scene.hpp"
+#include "renderer/scene_generator.hpp"
 #include "renderer/scene_object.hpp"
+#include "renderer/task_group.hpp"
+#include "renderer/thread_pool.hpp"
+#include "renderer/trace.hpp"
 #include "renderer/types.hpp"
 #include "renderer/utils.hpp"
 
@@ -0,0 +1,82 @@
+#include "renderer/memory_report.hpp"
+
+#include <algorithm>
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Запись составляющих с отступом по убыванию размера
+ */
+void WriteEntries(std::ostream& output, std::vector<MemoryUsage::Entry> entries,
+                  const size_t max_entries) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const MemoryUsage::Entry& lhs, const MemoryUsage::Entry& rhs) {
+                         return lhs.bytes > rhs.bytes;
+                     });
+    const size_t shown = std::min(entries.size(), max_entries);
+    for (size_t i = 0; i < shown; ++i) {
+        output << "    " << entries[i].name << ": " << entries[i].bytes << '\n';
+    }
+    if (shown < entries.size()) {
+        size_t rest = 0;
+        for (size_t i = shown; i < entries.size(); ++i) {
+            rest += entries[i].bytes;
+        }
+        output << "    ... " << entries.size() - shown << " more: " << rest << '\n';
+    }
+}
+
+}  // namespace
+
+void MemoryUsage::AddPart(std::string name, const size_t part_bytes) {
+    parts.push_back(Entry{.name = std::move(name), .bytes = part_bytes});
+    bytes += part_bytes;
+}
+
+void MemoryReport::Add(MemoryUsage usage) {
+    subsystems_.push_back(std::move(usage));
+}
+
+void MemoryReport::AddImage(std::string name, const Image& image) {
+    auto images =
+        std::find_if(subsystems_.begin(), subsystems_.end(),
+                     [](const MemoryUsage& usage) { return usage.subsystem == "Images"; });
+    if (images == subsystems_.end()) {
+        subsystems_.push_back(MemoryUsage{.subsystem = "Images"});
+        images = subsystems_.end() - 1;
+        images->parts.push_back(MemoryUsage::Entry{.name = "pixels"});
+    }
+    const size_t bytes = image.GetMemoryBytes();
+    images->bytes += bytes;
+    images->parts.front().bytes += bytes;
+    images->assets.push_back(MemoryUsage::Entry{.name = std::move(name), .bytes = bytes});
+}
+
+const std::vector<MemoryUsage>& MemoryReport::GetSubsystems() const {
+    return subsystems_;
+}
+
+size_t MemoryReport::GetTotalBytes() const {
+    size_t total = 0;
+    for (const MemoryUsage& usage : subsystems_) {
+        total += usage.bytes;
+    }
+    return total;
+}
+
+void MemoryReport::Write(std::ostream& output, const size_t max_assets) const {
+    output << "Total: " << GetTotalBytes() << " bytes\n";
+    for (const MemoryUsage& usage : subsystems_) {
+        output << usage.subsystem << ": " << usage.bytes << '\n';
+        output << "  parts:\n";
+        WriteEntries(output, usage.parts, usage.parts.size());
+        if (not usage.assets.empty()) {
+            output << "  assets:\n";
+            WriteEntries(output, usage.assets, max_assets);
+        }
+    }
+}
+
+}  // namespace renderer
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief Учет памяти, занимаемой компонентами библиотеки
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "renderer/image.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Отсутствие ограничения на объем памяти
+ */
+inline constexpr size_t kNoMemoryBudget = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Память одной подсистемы
+ *
+ * Возвращается методами GetMemoryUsage классов Scene, ResourcesManager, Renderer и
+ * RenderPipeline. Учитывается память массивов, принадлежащих подсистеме, включая их
+ * неиспользуемую емкость, но не служебные данные распределителя памяти
+ */
+struct MemoryUsage {
+    /**
+     * @brief Составляющая подсистемы или отдельный ресурс
+     */
+    struct Entry {
+        std::string name;
+        size_t bytes = 0;
+    };
+
+    /**
+     * Название подсистемы
+     */
+    std::string subsystem;
+    /**
+     * Вся память подсистемы, сумма parts
+     */
+    size_t bytes = 0;
+    /**
+     * Составляющие подсистемы: хранилища, буферы, служебные массивы
+     */
+    std::vector<Entry> parts{};
+    /**
+     * Отдельные ресурсы (сетки, текстуры), память которых входит в одну из parts
+     */
+    std::vector<Entry> assets{};
+
+    /**
+     * @brief Добавление составляющей
+     *
+     * @param[in] name Название
+     * @param[in] part_bytes Размер в байтах
+     */
+    void AddPart(std::string name, const size_t part_bytes);
+};
+
+/**
+ * @brief Отчет о памяти
+ *
+ * Собирает MemoryUsage нескольких подсистем и изображения приложения в один отчет
+ */
+class MemoryReport {
+public:
+    /**
+     * @brief Добавление подсистемы
+     *
+     * @param[in] usage Память подсистемы
+     */
+    void Add(MemoryUsage usage);
+
+    /**
+     * @brief Добавление изображения
+     *
+     * Изображения попадают в подсистему "Images" как отдельные ресурсы
+     *
+     * @param[in] name Название изображения
+     * @param[in] image Изображение
+     */
+    void AddImage(std::string name, const Image& image);
+
+    /**
+     * @brief Получение подсистем
+     *
+     * @return Подсистемы в порядке добавления
+     */
+    const std::vector<MemoryUsage>& GetSubsystems() const;
+
+    /**
+     * @brief Вся учтенная память
+     *
+     * @return Сумма памяти подсистем в байтах
+     */
+    size_t GetTotalBytes() const;
+
+    /**
+     * @brief Запись отчета в текстовом виде
+     *
+     * Для каждой подсистемы выводятся ее составляющие и ресурсы, отсортированные по убыванию
+     * размера
+     *
+     * @param[out] output Поток для записи
+     * @param[in] max_assets Наибольшее количество ресурсов, выводимых для подсистемы
+     */
+    void Write(std::ostream& output, const size_t max_assets = 16) const;
+
+private:
+    std::vector<MemoryUsage> subsystems_;
+};
+
+};  // namespace renderer
@@ -0,0 +1,316 @@
+#include "renderer/utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+#include "renderer/resources_manager.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RENDERER_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define RENDERER_HAS_MMAP 0
+#endif
+
+namespace renderer::utils {
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<Object::FacetType>,
+              "Грани должны быть тривиально копируемыми для записи в кэш");
+
+/**
+ * Сигнатура файла кэша
+ */
+constexpr char kMeshCacheMagic[4] = {'R', 'M', 'C', 'H'};
+
+/**
+ * Выравнивание начала массива граней в файле
+ */
+constexpr uint64_t kFacetsAlignment = 64;
+
+/**
+ * Параметры хэша FNV-1a
+ */
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+/**
+ * Примесь к хэшу исходного файла для кэша оптимизированного объекта
+ */
+constexpr uint64_t kOptimizedHashSalt = 0x9e3779b97f4a7c15ull;
+
+/**
+ * @brief Заголовок файла кэша
+ */
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t facet_size;  // sizeof(FacetType) на момент записи
+    uint32_t materials_count;
+    uint64_t facets_count;
+    uint64_t facets_offset;  // смещение массива граней от начала файла
+};
+
+/**
+ * @brief Запись о материале в файле кэша
+ *
+ * После записи следует texture_path_size байт пути до текстуры
+ */
+struct CachedMaterial {
+    MaterialId id;
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float shininess;
+    uint32_t two_sided;
+    uint32_t texture_path_size;
+};
+
+/**
+ * @brief Файл, отображенный в память
+ *
+ * Отображает файл в память только для чтения. Если отображение недоступно на платформе, файл
+ * целиком читается в выровненный буфер
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if RENDERER_HAS_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0 and file_stat.st_size > 0) {
+            void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char*>(data);
+                size_ = file_stat.st_size;
+            }
+        }
+        close(fd);
+#else
+        std::ifstream input{path, std::ios_base::binary | std::ios_base::ate};
+        if (not input) {
+            return;
+        }
+        size_t size = input.tellg();
+        input.seekg(0);
+        buffer_.reset(new std::max_align_t[size / sizeof(std::max_align_t) + 1]);
+        if (input.read(reinterpret_cast<char*>(buffer_.get()), size)) {
+            data_ = reinterpret_cast<const char*>(buffer_.get());
+            size_ = size;
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    ~MappedFile() {
+#if RENDERER_HAS_MMAP
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    const char* Data() const {
+        return data_;
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if RENDERER_HAS_MMAP == 0
+    std::unique_ptr<std::max_align_t[]> buffer_;
+#endif
+};
+
+/**
+ * @brief Шаг хэша FNV-1a
+ */
+uint64_t HashBytes(uint64_t hash, const char* data, const size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+/**
+ * @brief Запись значения в поток в бинарном виде
+ */
+template <typename T>
+void WriteRaw(std::ofstream& output, const T& value) {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+uint64_t HashFile(const std::string& path) {
+    MappedFile file{path};
+    if (file.Data() == nullptr) {
+        return 0;
+    }
+    return HashBytes(kFnvOffsetBasis, file.Data(), file.Size());
+}
+
+bool SaveMeshCache(const Object& object, const std::string& cache_path,
+                   const uint64_t source_hash) {
+    const ResourcesManager& manager = ResourcesManager::Get();
+
+    // собираем используемые материалы, материал по-умолчанию не сохраняется
+    std::vector<MaterialId> materials;
+    for (auto it = object.Begin(); it != object.End(); ++it) {
+        if (it->material != 0 and
+            std::find(materials.begin(), materials.end(), it->material) == materials.end()) {
+            materials.push_back(it->material);
+        }
+    }
+
+    const std::string temporary_path = cache_path + ".tmp";
+    {
+        std::ofstream output{temporary_path, std::ios_base::binary | std::ios_base::trunc};
+        if (not output) {
+            return false;
+        }
+        CacheHeader header{};
+        std::memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+        header.version = kMeshCacheVersion;
+        header.source_hash = source_hash;
+        header.facet_size = sizeof(Object::FacetType);
+        header.materials_count = materials.size();
+        header.facets_count = std::distance(object.Begin(), object.End());
+        WriteRaw(output, header);
+
+        for (const MaterialId id : materials) {
+            const Material& material = manager.AccessMaterial(id);
+            const std::string& texture_path = manager.GetTexturePath(material.texture);
+            CachedMaterial record{
+                .id = id,
+                .ambient = {material.ambient.r, material.ambient.g, material.ambient.b},
+                .diffuse = {material.diffuse.r, material.diffuse.g, material.diffuse.b},
+                .specular = {material.specular.r, material.specular.g, material.specular.b},
+                .shininess = material.shininess,
+                .two_sided = material.two_sided,
+                .texture_path_size = static_cast<uint32_t>(texture_path.size())};
+            WriteRaw(output, record);
+            output.write(texture_path.data(), texture_path.size());
+        }
+
+        // грани выравниваются, чтобы их можно было использовать прямо из отображенной памяти
+        uint64_t position = output.tellp();
+        header.facets_offset =
+            (position + kFacetsAlignment - 1) / kFacetsAlignment * kFacetsAlignment;
+        for (; position < header.facets_offset; ++position) {
+            output.put(0);
+        }
+        // Object хранит грани непрерывно, поэтому они записываются одним вызовом
+        if (header.facets_count > 0) {
+            output.write(reinterpret_cast<const char*>(&*object.Begin()),
+                         header.facets_count * sizeof(Object::FacetType));
+        }
+        output.seekp(0);
+        WriteRaw(output, header);
+        if (not output) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary_path, cache_path, error);
+    return not error;
+}
+
+std::optional<Object> LoadMeshCache(const std::string& cache_path, const uint64_t source_hash) {
+    MappedFile file{cache_path};
+    if (file.Data() == nullptr or file.Size() < sizeof(CacheHeader)) {
+        return std::nullopt;
+    }
+    CacheHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0 or
+        header.version != kMeshCacheVersion or header.source_hash != source_hash or
+        header.facet_size != sizeof(Object::FacetType)) {
+        return std::nullopt;
+    }
+    if (header.facets_offset % alignof(Object::FacetType) != 0 or
+        header.facets_offset > file.Size() or
+        header.facets_count > (file.Size() - header.facets_offset) / sizeof(Object::FacetType)) {
+        return std::nullopt;
+    }
+
+    ResourcesManager& manager = ResourcesManager::Get();
+    std::unordered_map<MaterialId, MaterialId> materials_map;
+    size_t position = sizeof(CacheHeader);
+    for (uint32_t i = 0; i < header.materials_count; ++i) {
+        if (position + sizeof(CachedMaterial) > header.facets_offset) {
+            return std::nullopt;
+        }
+        CachedMaterial record;
+        std::memcpy(&record, file.Data() + position, sizeof(record));
+        position += sizeof(record);
+        if (position + record.texture_path_size > header.facets_offset) {
+            return std::nullopt;
+        }
+        std::string texture_path{file.Data() + position, record.texture_path_size};
+        position += record.texture_path_size;
+
+        Material material{
+            .ambient = {record.ambient[0], record.ambient[1], record.ambient[2]},
+            .diffuse = {record.diffuse[0], record.diffuse[1], record.diffuse[2]},
+            .specular = {record.specular[0], record.specular[1], record.specular[2]},
+            .shininess = record.shininess,
+            .two_sided = (record.two_sided != 0)};
+        if (not texture_path.empty()) {
+            material.texture = manager.PushTexture(texture_path);
+        }
+        materials_map[record.id] = manager.PushMaterial(material);
+    }
+
+    // единственное копирование граней - из отображенного файла в хранилище объекта
+    const auto* facets_begin =
+        reinterpret_cast<const Object::FacetType*>(file.Data() + header.facets_offset);
+    std::vector<Object::FacetType> facets(facets_begin, facets_begin + header.facets_count);
+    if (not materials_map.empty()) {
+        for (Object::FacetType& facet : facets) {
+            auto it = materials_map.find(facet.material);
+            facet.material = (it != materials_map.end()) ? it->second : 0;
+        }
+    }
+    return Object{std::move(facets)};
+}
+
+Object LoadFileCached(const std::string& path, const std::string& cache_path,
+                      const bool optimize, MeshOptimizationStats* stats) {
+    uint64_t source_hash = HashFile(path);
+    if (optimize) {
+        source_hash ^= kOptimizedHashSalt;
+    }
+    std::optional<Object> cached = LoadMeshCache(cache_path, source_hash);
+    if (cached.has_value()) {
+        return std::move(*cached);
+    }
+    Object object = LoadFile(path, optimize, stats);
+    if (object.Begin() != object.End()) {
+        SaveMeshCache(object, cache_path, source_hash);
+    }
+    return object;
+}
+
+}  // namespace renderer::utils
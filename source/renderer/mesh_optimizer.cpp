@@ -0,0 +1,241 @@
+#include "renderer/mesh_optimizer.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+
+namespace renderer::utils {
+
+namespace {
+
+/**
+ * Значение, обозначающее отсутствие вершины
+ */
+constexpr int64_t kNoVertex = -1;
+
+/**
+ * @brief Хэш вершины по ее байтам
+ */
+struct VertexHash {
+    size_t operator()(const Vertex& vertex) const {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(Vertex); ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+/**
+ * @brief Побитовое сравнение вершин
+ */
+struct VertexEqual {
+    bool operator()(const Vertex& lhs, const Vertex& rhs) const {
+        return std::memcmp(&lhs, &rhs, sizeof(Vertex)) == 0;
+    }
+};
+
+/**
+ * @brief Поиск следующей вершины в стеке тупиков
+ *
+ * Возвращает последнюю добавленную в стек вершину, у которой остались неиспользованные грани, иначе
+ * первую по порядку такую вершину, начиная с cursor. Если таких нет, возвращает kNoVertex
+ */
+int64_t SkipDeadEnd(const std::vector<uint32_t>& live_triangles, std::vector<uint32_t>& dead_end,
+                    size_t& cursor) {
+    while (not dead_end.empty()) {
+        uint32_t vertex = dead_end.back();
+        dead_end.pop_back();
+        if (live_triangles[vertex] > 0) {
+            return vertex;
+        }
+    }
+    for (; cursor < live_triangles.size(); ++cursor) {
+        if (live_triangles[cursor] > 0) {
+            return cursor;
+        }
+    }
+    return kNoVertex;
+}
+
+}  // namespace
+
+IndexedMesh WeldVertices(const Object& object) {
+    IndexedMesh mesh;
+    const size_t facets_count = std::distance(object.Begin(), object.End());
+    mesh.indices.reserve(facets_count * 3);
+    mesh.materials.reserve(facets_count);
+
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique_vertices;
+    unique_vertices.reserve(facets_count * 3);
+    for (auto it = object.Begin(); it != object.End(); ++it) {
+        for (const Vertex& vertex : it->vertices) {
+            auto [position, inserted] = unique_vertices.try_emplace(vertex, mesh.vertices.size());
+            if (inserted) {
+                mesh.vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(position->second);
+        }
+        mesh.materials.push_back(it->material);
+    }
+    return mesh;
+}
+
+void OptimizeVertexCache(IndexedMesh& mesh, const size_t cache_size) {
+    {
+        assert((cache_size > 0) and "OptimizeVertexCache: размер кэша должен быть больше 0");
+    }
+    const size_t vertices_count = mesh.vertices.size();
+    const size_t triangles_count = mesh.materials.size();
+
+    // смежность вершина -> грани в виде сжатых списков
+    std::vector<uint32_t> live_triangles(vertices_count, 0);
+    for (uint32_t index : mesh.indices) {
+        ++live_triangles[index];
+    }
+    std::vector<size_t> adjacency_offsets(vertices_count + 1, 0);
+    for (size_t vertex = 0; vertex < vertices_count; ++vertex) {
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+    }
+    std::vector<uint32_t> adjacency(mesh.indices.size());
+    {
+        std::vector<size_t> fill = adjacency_offsets;
+        for (size_t i = 0; i < mesh.indices.size(); ++i) {
+            adjacency[fill[mesh.indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<size_t> cache_time(vertices_count, 0);  // время попадания вершины в кэш
+    std::vector<bool> emitted(triangles_count, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> order;
+    order.reserve(triangles_count);
+
+    size_t time = cache_size + 1;
+    size_t cursor = 0;
+    int64_t fanning_vertex = vertices_count > 0 ? 0 : kNoVertex;
+    while (fanning_vertex != kNoVertex) {
+        candidates.clear();
+        // выпускаем все оставшиеся грани вокруг текущей вершины
+        for (size_t i = adjacency_offsets[fanning_vertex];
+             i < adjacency_offsets[fanning_vertex + 1]; ++i) {
+            const uint32_t triangle = adjacency[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; ++corner) {
+                const uint32_t vertex = mesh.indices[triangle * 3 + corner];
+                dead_end.push_back(vertex);
+                candidates.push_back(vertex);
+                --live_triangles[vertex];
+                if (time - cache_time[vertex] > cache_size) {
+                    cache_time[vertex] = time;
+                    ++time;
+                }
+            }
+            emitted[triangle] = true;
+            order.push_back(triangle);
+        }
+
+        // выбираем следующую вершину среди вершин выпущенных граней, которая останется в кэше
+        int64_t best_vertex = kNoVertex;
+        int64_t best_priority = -1;
+        for (uint32_t vertex : candidates) {
+            if (live_triangles[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cache_time[vertex] + 2 * live_triangles[vertex] <= cache_size) {
+                priority = time - cache_time[vertex];
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                best_vertex = vertex;
+            }
+        }
+        if (best_vertex == kNoVertex) {
+            best_vertex = SkipDeadEnd(live_triangles, dead_end, cursor);
+        }
+        fanning_vertex = best_vertex;
+    }
+    {
+        assert((order.size() == triangles_count) and
+               "OptimizeVertexCache: каждая грань должна быть выпущена ровно один раз");
+    }
+
+    std::vector<uint32_t> new_indices(mesh.indices.size());
+    std::vector<MaterialId> new_materials(triangles_count);
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            new_indices[i * 3 + corner] = mesh.indices[order[i] * 3 + corner];
+        }
+        new_materials[i] = mesh.materials[order[i]];
+    }
+    mesh.indices = std::move(new_indices);
+    mesh.materials = std::move(new_materials);
+}
+
+void OptimizeVertexFetch(IndexedMesh& mesh) {
+    constexpr uint32_t kUnassigned = UINT32_MAX;
+    std::vector<uint32_t> remap(mesh.vertices.size(), kUnassigned);
+    std::vector<Vertex> new_vertices;
+    new_vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == kUnassigned) {
+            remap[index] = new_vertices.size();
+            new_vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(new_vertices);
+}
+
+float ComputeACMR(const IndexedMesh& mesh, const size_t cache_size) {
+    if (mesh.materials.empty()) {
+        return 0;
+    }
+    std::vector<size_t> cache_time(mesh.vertices.size(), 0);
+    size_t time = cache_size + 1;
+    size_t misses = 0;
+    for (uint32_t index : mesh.indices) {
+        if (time - cache_time[index] > cache_size) {
+            cache_time[index] = time;
+            ++time;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(mesh.materials.size());
+}
+
+Object ToObject(const IndexedMesh& mesh) {
+    std::vector<Object::FacetType> facets(mesh.materials.size());
+    for (size_t i = 0; i < facets.size(); ++i) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            facets[i].vertices[corner] = mesh.vertices[mesh.indices[i * 3 + corner]];
+        }
+        facets[i].material = mesh.materials[i];
+    }
+    return Object{std::move(facets)};
+}
+
+MeshOptimizationStats OptimizeObject(Object& object) {
+    MeshOptimizationStats stats;
+    IndexedMesh mesh = WeldVertices(object);
+    stats.facets = mesh.materials.size();
+    stats.vertices_before = mesh.indices.size();
+    stats.vertices_after = mesh.vertices.size();
+    stats.acmr_before = ComputeACMR(mesh);
+
+    OptimizeVertexCache(mesh);
+    OptimizeVertexFetch(mesh);
+    stats.acmr_after = ComputeACMR(mesh);
+
+    object = ToObject(mesh);
+    return stats;
+}
+
+}  // namespace renderer::utils
@@ -0,0 +1,142 @@
+/**
+ * @file
+ * @brief Оптимизация геометрии объектов
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "renderer/object.hpp"
+
+namespace renderer {
+namespace utils {
+
+/**
+ * @brief Размер моделируемого кэша трансформированных вершин
+ */
+inline constexpr size_t kVertexCacheSize = 16;
+
+/**
+ * @brief Индексированная сетка
+ *
+ * Промежуточное представление объекта, в котором одинаковые вершины хранятся один раз. Грань i
+ * задается вершинами indices[3 * i], indices[3 * i + 1], indices[3 * i + 2] и материалом
+ * materials[i]
+ */
+struct IndexedMesh {
+    /**
+     * Уникальные вершины
+     */
+    std::vector<Vertex> vertices;
+    /**
+     * Индексы вершин граней, по 3 на грань
+     */
+    std::vector<uint32_t> indices;
+    /**
+     * Материалы граней
+     */
+    std::vector<MaterialId> materials;
+};
+
+/**
+ * @brief Результат оптимизации объекта
+ *
+ * ACMR (average cache miss ratio) - среднее число промахов кэша трансформированных вершин на
+ * грань. Лучшее достижимое значение около 0.5, худшее - 3
+ */
+struct MeshOptimizationStats {
+    /**
+     * Количество граней
+     */
+    size_t facets = 0;
+    /**
+     * Количество вершин до склеивания (3 на грань)
+     */
+    size_t vertices_before = 0;
+    /**
+     * Количество уникальных вершин после склеивания
+     */
+    size_t vertices_after = 0;
+    /**
+     * ACMR склеенной сетки в исходном порядке граней
+     */
+    float acmr_before = 0;
+    /**
+     * ACMR после переупорядочивания граней
+     */
+    float acmr_after = 0;
+};
+
+/**
+ * @brief Склеивание одинаковых вершин
+ *
+ * Строит индексированную сетку по граням объекта. Вершины считаются одинаковыми, если совпадают
+ * побитово все их атрибуты. Порядок граней сохраняется
+ *
+ * @param[in] object Объект
+ *
+ * @return Индексированная сетка
+ */
+IndexedMesh WeldVertices(const Object& object);
+
+/**
+ * @brief Оптимизация порядка граней под кэш вершин
+ *
+ * Переупорядочивает грани алгоритмом Tipsify (Sander, Nehab, Barczak, 2007) так, чтобы соседние
+ * грани использовали общие вершины, пока те еще находятся в кэше размера cache_size. Работает за
+ * линейное от числа граней время
+ *
+ * @param[in,out] mesh Сетка
+ * @param[in] cache_size Размер кэша вершин
+ */
+void OptimizeVertexCache(IndexedMesh& mesh, const size_t cache_size = kVertexCacheSize);
+
+/**
+ * @brief Оптимизация порядка вершин под последовательное чтение
+ *
+ * Переупорядочивает вершины в порядке их первого использования гранями, после чего вершины
+ * читаются из памяти почти последовательно
+ *
+ * @param[in,out] mesh Сетка
+ */
+void OptimizeVertexFetch(IndexedMesh& mesh);
+
+/**
+ * @brief Вычисление ACMR
+ *
+ * Моделирует FIFO кэш трансформированных вершин размера cache_size и возвращает среднее число
+ * промахов на грань. Для сетки без граней возвращает 0
+ *
+ * @param[in] mesh Сетка
+ * @param[in] cache_size Размер кэша вершин
+ *
+ * @return ACMR
+ */
+float ComputeACMR(const IndexedMesh& mesh, const size_t cache_size = kVertexCacheSize);
+
+/**
+ * @brief Преобразование индексированной сетки в объект
+ *
+ * @param[in] mesh Сетка
+ *
+ * @return Объект с гранями в порядке сетки
+ */
+Object ToObject(const IndexedMesh& mesh);
+
+/**
+ * @brief Оптимизация объекта
+ *
+ * Последовательно склеивает одинаковые вершины, переупорядочивает грани под кэш вершин и
+ * переупорядочивает вершины под последовательное чтение, после чего заменяет грани объекта на
+ * результат
+ *
+ * @param[in,out] object Объект
+ *
+ * @return Статистика оптимизации
+ */
+MeshOptimizationStats OptimizeObject(Object& object);
+
+};  // namespace utils
+};  // namespace renderer
@@ -0,0 +1,111 @@
+#include "renderer/numa.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Разбор числа, в случае ошибки возвращает false
+ */
+bool ParseNumber(const std::string_view text, size_t& result) {
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), result);
+    return error == std::errc{} and end == text.data() + text.size();
+}
+
+/**
+ * @brief Разбор списка процессоров вида "0-3,8,10-11"
+ *
+ * Некорректные элементы списка пропускаются
+ */
+std::vector<size_t> ParseCpuList(const std::string_view list) {
+    std::vector<size_t> cpus;
+    size_t position = 0;
+    while (position < list.size()) {
+        size_t end = std::min(list.find(',', position), list.size());
+        const std::string_view range = list.substr(position, end - position);
+        const size_t dash = range.find('-');
+        size_t first = 0;
+        size_t last = 0;
+        if (dash == std::string_view::npos) {
+            if (ParseNumber(range, first)) {
+                cpus.push_back(first);
+            }
+        } else if (ParseNumber(range.substr(0, dash), first) and
+                   ParseNumber(range.substr(dash + 1), last)) {
+            for (size_t cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        position = end + 1;
+    }
+    return cpus;
+}
+
+}  // namespace
+
+std::vector<NumaNode> GetNumaNodes() {
+    std::vector<NumaNode> nodes;
+    const std::filesystem::path root{"/sys/devices/system/node"};
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator{root, error}) {
+        const std::string name = entry.path().filename().string();
+        constexpr std::string_view kPrefix = "node";
+        NumaNode node;
+        if (name.rfind(kPrefix, 0) != 0 or
+            not ParseNumber(std::string_view{name}.substr(kPrefix.size()), node.id)) {
+            continue;
+        }
+        std::ifstream cpulist{entry.path() / "cpulist"};
+        std::string list;
+        std::getline(cpulist, list);
+        node.cpus = ParseCpuList(list);
+        if (not node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+    if (nodes.empty()) {
+        NumaNode node;
+        const size_t cpus_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        for (size_t cpu = 0; cpu < cpus_count; ++cpu) {
+            node.cpus.push_back(cpu);
+        }
+        nodes.push_back(std::move(node));
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](const NumaNode& lhs, const NumaNode& rhs) { return lhs.id < rhs.id; });
+    return nodes;
+}
+
+bool SetThreadAffinity(std::thread& thread, std::span<const size_t> cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpus.empty()) {
+        for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    for (size_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+}  // namespace renderer
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Топология процессоров и размещение памяти на узлах NUMA
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace renderer {
+
+/**
+ * @brief Узел NUMA
+ */
+struct NumaNode {
+    /**
+     * Номер узла в системе
+     */
+    size_t id = 0;
+
+    /**
+     * Номера логических процессоров узла
+     */
+    std::vector<size_t> cpus;
+};
+
+/**
+ * @brief Получение узлов NUMA
+ *
+ * В Linux узлы читаются из /sys/devices/system/node. Если узлы определить не удалось, возвращается
+ * один узел со всеми std::thread::hardware_concurrency процессорами
+ *
+ * @return Узлы NUMA, упорядоченные по номеру
+ */
+std::vector<NumaNode> GetNumaNodes();
+
+/**
+ * @brief Привязка потока к процессорам
+ *
+ * Ограничивает выполнение потока переданными логическими процессорами. Поддерживается только в
+ * Linux, на остальных системах ничего не делает
+ *
+ * @param[in] thread Поток
+ * @param[in] cpus Номера процессоров. Пустой список снимает привязку
+ *
+ * @return Удалось ли привязать поток
+ */
+bool SetThreadAffinity(std::thread& thread, std::span<const size_t> cpus);
+
+/**
+ * @brief Аллокатор без инициализации значений
+ *
+ * При изменении размера контейнера не инициализирует тривиальные элементы. В Linux физические
+ * страницы памяти выделяются на узле NUMA потока, который первым записал в них, поэтому
+ * заполнение такого контейнера потоками ThreadPool распределяет его по узлам этих потоков
+ */
+template <class T>
+class FirstTouchAllocator : public std::allocator<T> {
+public:
+    template <class U>
+    struct rebind {
+        using other = FirstTouchAllocator<U>;
+    };
+
+    FirstTouchAllocator() = default;
+
+    template <class U>
+    FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept {
+    }
+
+    template <class U, class... Args>
+    void construct(U* pointer, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0 and std::is_trivially_default_constructible_v<U>) {
+            ::new (static_cast<void*>(pointer)) U;
+        } else {
+            ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+        }
+    }
+};
+
+};  // namespace renderer
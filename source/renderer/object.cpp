@@ -5,6 +5,23 @@ namespace renderer {
 Object::Object(const std::vector<FacetType>& triangles) : triangles_{triangles} {
 }
 
+Object::Object(std::vector<FacetType>&& triangles) : triangles_{std::move(triangles)} {
+}
+
+size_t Object::Size() const {
+    return triangles_.size();
+}
+
+std::span<const Object::FacetType> Object::Facets() const {
+    return triangles_;
+}
+
+std::vector<Object::FacetType> Object::ReleaseFacets() {
+    std::vector<FacetType> result = std::move(triangles_);
+    triangles_.clear();
+    return result;
+}
+
 Object::Iterator Object::Begin() {
     return triangles_.begin();
 }
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <span>
 #include <vector>
 
 #include "renderer/primitives.hpp"
@@ -27,6 +28,40 @@ public:
      */
     explicit Object(const std::vector<FacetType>& triangles);
 
+    /**
+     * @brief Конструктор из треугольников
+     *
+     * Забирает переданный массив треугольников без копирования
+     *
+     * @param[in] triangles треугольники
+     */
+    explicit Object(std::vector<FacetType>&& triangles);
+
+    /**
+     * @brief Количество граней
+     *
+     * @return Количество граней в контейнере
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Просмотр граней
+     *
+     * Возвращает непрерывный диапазон граней объекта, действительный до изменения объекта
+     *
+     * @return Диапазон граней
+     */
+    std::span<const FacetType> Facets() const;
+
+    /**
+     * @brief Извлечение граней
+     *
+     * Забирает у объекта массив граней без копирования, после чего объект становится пустым
+     *
+     * @return Массив граней
+     */
+    std::vector<FacetType> ReleaseFacets();
+
     /**
      * @brief Итератор начала контейнера
      *
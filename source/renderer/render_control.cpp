@@ -0,0 +1,35 @@
+#include "renderer/render_control.hpp"
+
+namespace renderer {
+
+void CancellationToken::Cancel() {
+    cancelled_.store(true, std::memory_order_relaxed);
+}
+
+void CancellationToken::Reset() {
+    cancelled_.store(false, std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+}
+
+bool RenderControl::ShouldStop() {
+    using Clock = std::chrono::steady_clock;
+    if (status.load(std::memory_order_relaxed) != COMPLETED) {
+        return true;
+    }
+    Status reason = COMPLETED;
+    if (cancellation != nullptr and cancellation->IsCancelled()) {
+        reason = CANCELLED;
+    } else if (deadline != Clock::time_point::max() and Clock::now() >= deadline) {
+        reason = DEADLINE_EXCEEDED;
+    } else {
+        return false;
+    }
+    Status expected = COMPLETED;
+    status.compare_exchange_strong(expected, reason, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace renderer
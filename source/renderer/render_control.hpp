@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief Отмена рендеринга и ограничение времени кадра
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace renderer {
+
+/**
+ * @brief Флаг отмены рендеринга
+ *
+ * Cancel может вызываться из любого потока во время рендеринга. Один флаг можно передавать в
+ * несколько кадров, тогда отмена прерывает их все
+ */
+class CancellationToken {
+public:
+    /**
+     * @brief Отмена
+     */
+    void Cancel();
+
+    /**
+     * @brief Сброс отмены для следующих кадров
+     */
+    void Reset();
+
+    /**
+     * @brief Отменен ли рендеринг
+     *
+     * @return true, если был вызван Cancel и после него не было Reset
+     */
+    bool IsCancelled() const;
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+/**
+ * @brief Управление рендерингом кадра
+ *
+ * Передается в Renderer::Render и RenderPipeline::Submit. Отмена и срок проверяются между
+ * пакетами граней и между группами строк растеризуемого треугольника, поэтому кадр прерывается с
+ * задержкой не больше времени отрисовки одного пакета. Прерванный кадр возвращается таким, каким
+ * он был на момент остановки: часть объектов может быть не нарисована
+ */
+struct RenderControl {
+    /**
+     * @brief Результат рендеринга кадра
+     */
+    enum Status : uint8_t {
+        /**
+         * Кадр отрисован полностью
+         */
+        COMPLETED,
+        /**
+         * Рендеринг прерван через CancellationToken
+         */
+        CANCELLED,
+        /**
+         * Рендеринг прерван по истечении срока кадра
+         */
+        DEADLINE_EXCEEDED
+    };
+
+    /**
+     * Флаг отмены или nullptr, если кадр не отменяется
+     */
+    const CancellationToken* cancellation = nullptr;
+    /**
+     * Срок, после которого рендеринг прерывается. По умолчанию не ограничен
+     */
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    /**
+     * Результат, записывается рендерером. Остановку могут обнаружить несколько потоков
+     * растеризации одновременно, сохраняется первая причина
+     */
+    std::atomic<Status> status = COMPLETED;
+
+    /**
+     * @brief Проверка, нужно ли прервать кадр
+     *
+     * Вызывается рендерером. При остановке записывает причину в status, если она еще не записана.
+     * Может вызываться одновременно из нескольких потоков. Часы опрашиваются, только если срок
+     * задан
+     *
+     * @return true, если кадр отменен, срок истек или остановка уже была обнаружена
+     */
+    bool ShouldStop();
+};
+
+};  // namespace renderer
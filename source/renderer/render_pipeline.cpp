@@ -0,0 +1,178 @@
+#include "renderer/render_pipeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+namespace renderer {
+
+RenderPipeline::RenderPipeline(const Renderer& renderer, const Width width, const Height height,
+                               const size_t max_queued_frames)
+    : renderer_{renderer}, width_{width}, height_{height}, max_queued_frames_{max_queued_frames} {
+    {
+        assert((width != 0) and "RenderPipeline: ширина кадров не может быть 0");
+        assert((height != 0) and "RenderPipeline: высота кадров не может быть 0");
+        assert((max_queued_frames > 0) and
+               "RenderPipeline: размер очереди кадров должен быть больше 0");
+    }
+    raster_thread_ = std::thread{&RenderPipeline::RasterLoop, this};
+}
+
+RenderPipeline::~RenderPipeline() {
+    Wait();
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    frame_queued_.notify_all();
+    raster_thread_.join();
+}
+
+std::future<Image> RenderPipeline::Submit(const Scene& scene, const Scene::CameraId camera_id,
+                                          const Renderer::RenderFlags flags,
+                                          RenderControl* control) {
+    auto promise = std::make_shared<std::promise<Image>>();
+    std::future<Image> result = promise->get_future();
+    Submit(
+        scene, camera_id, flags,
+        [promise](Image&& image) { promise->set_value(std::move(image)); }, control);
+    return result;
+}
+
+void RenderPipeline::Submit(const Scene& scene, const Scene::CameraId camera_id,
+                            const Renderer::RenderFlags flags, Callback callback,
+                            RenderControl* control) {
+    {
+        assert((scene.HasCamera(camera_id)) and "Submit: камера должна принадлежать сцене");
+        assert(callback and "Submit: обработчик кадра не должен быть пустым");
+    }
+    Frame frame;
+    frame.frame_id = Tracer::Get().BeginFrame();
+    if (control != nullptr) {
+        control->status.store(RenderControl::COMPLETED, std::memory_order_relaxed);
+    }
+    frame.parameters = renderer_.PrepareFrame(scene, camera_id, width_, height_, flags);
+    frame.parameters.control = control;
+    const Renderer::SceneParameters scene_parameters = renderer_.PrepareScene(scene);
+    renderer_.PrepareLights(scene_parameters, frame.parameters, frame.lights);
+    frame.callback = std::move(callback);
+    {
+        std::lock_guard lock{mutex_};
+        if (not free_triangles_.empty()) {
+            frame.triangles = std::move(free_triangles_.back());
+            free_triangles_.pop_back();
+        }
+    }
+    // геометрия считается до ожидания места в очереди, параллельно с растеризацией
+    renderer_.CollectGeometry(frame.parameters, scene, scene_parameters, frame.triangles);
+    {
+        std::unique_lock lock{mutex_};
+        frame_done_.wait(lock, [this]() { return frames_in_flight_ < max_queued_frames_; });
+        ++frames_in_flight_;
+        queue_.push_back(std::move(frame));
+    }
+    frame_queued_.notify_one();
+}
+
+void RenderPipeline::ReleaseFramebuffer(Image&& image) {
+    {
+        assert((image.GetWidth() == width_ and image.GetHeight() == height_) and
+               "ReleaseFramebuffer: размеры изображения должны совпадать с размерами кадров");
+    }
+    std::lock_guard lock{mutex_};
+    free_framebuffers_.push_back(std::move(image));
+}
+
+void RenderPipeline::Wait() {
+    std::unique_lock lock{mutex_};
+    frame_done_.wait(lock, [this]() { return frames_in_flight_ == 0; });
+}
+
+MemoryUsage RenderPipeline::GetMemoryUsage() const {
+    MemoryUsage usage{.subsystem = "RenderPipeline"};
+    std::lock_guard lock{mutex_};
+    usage.AddPart("z_buffer", z_buffer_bytes_);
+    size_t queued_bytes = 0;
+    for (const Frame& frame : queue_) {
+        queued_bytes += frame.triangles.capacity() * sizeof(Triangle) +
+                        frame.lights.capacity() * sizeof(LightSource);
+    }
+    usage.AddPart("queued frames", queued_bytes);
+    size_t framebuffers_bytes = free_framebuffers_.capacity() * sizeof(Image);
+    for (const Image& image : free_framebuffers_) {
+        framebuffers_bytes += image.GetMemoryBytes();
+    }
+    usage.AddPart("free framebuffers", framebuffers_bytes);
+    size_t triangles_bytes = free_triangles_.capacity() * sizeof(std::vector<Triangle>);
+    for (const std::vector<Triangle>& triangles : free_triangles_) {
+        triangles_bytes += triangles.capacity() * sizeof(Triangle);
+    }
+    usage.AddPart("free triangles", triangles_bytes);
+    return usage;
+}
+
+void RenderPipeline::RasterLoop() {
+    Tracer::SetThreadName("RenderPipeline raster");
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock lock{mutex_};
+            frame_queued_.wait(lock, [this]() { return stop_ or not queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            frame = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        frame.callback(Rasterize(frame));
+        frame.triangles.clear();
+        {
+            std::lock_guard lock{mutex_};
+            free_triangles_.push_back(std::move(frame.triangles));
+            z_buffer_bytes_ = context_.GetMemoryBytes();
+            --frames_in_flight_;
+        }
+        frame_done_.notify_all();
+    }
+}
+
+Image RenderPipeline::Rasterize(Frame& frame) {
+    TraceScope trace{"Rasterize", frame.frame_id};
+    Image image = AcquireFramebuffer();
+    Renderer::Parameters& parameters = frame.parameters;
+    parameters.lights = frame.lights;
+    renderer_.PrepareDepthBuffer(context_, parameters);
+    RenderControl* const control = parameters.control;
+    for (size_t i = 0; i < frame.triangles.size(); ++i) {
+        if (control != nullptr and i % Renderer::kTrianglesPerControlCheck == 0 and
+            control->ShouldStop()) {
+            break;
+        }
+        renderer_.DrawTriangle(parameters, image, frame.triangles[i]);
+    }
+    renderer_.ResolveHeatmap(parameters, image);
+    return image;
+}
+
+Image RenderPipeline::AcquireFramebuffer() {
+    std::unique_lock lock{mutex_};
+    if (free_framebuffers_.empty()) {
+        lock.unlock();
+        return Image{width_, height_, *renderer_.thread_pool_};
+    }
+    Image image = std::move(free_framebuffers_.back());
+    free_framebuffers_.pop_back();
+    lock.unlock();
+
+    const size_t width = width_;
+    Image::Pixel* data = image.AccessData();
+    const size_t rows_per_thread = height_ / renderer_.thread_pool_->GetWorkersCount() + 1;
+    renderer_.thread_pool_->ParallelFor(0, height_, rows_per_thread,
+                                        [data, width](const size_t begin, const size_t end) {
+                                            std::fill(data + begin * width, data + end * width,
+                                                      Image::Pixel{0, 0, 0});
+                                        });
+    return image;
+}
+
+}  // namespace renderer
@@ -0,0 +1,186 @@
+/**
+ * @file
+ * @brief Конвейерный рендеринг кадров
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "renderer/renderer.hpp"
+#include "renderer/trace.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Конвейер асинхронного рендеринга кадров
+ *
+ * Делит рендеринг кадра на две стадии. Геометрическая стадия (перевод граней в пространство
+ * камеры, отбрасывание и обрезка) выполняется в потоке, вызвавшем Submit, и копирует все данные
+ * сцены, нужные растеризации, поэтому после возврата из Submit сцену можно менять для следующего
+ * кадра. Растеризация выполняется потоком конвейера в порядке отправки кадров, так что геометрия
+ * кадра N + 1 считается одновременно с растеризацией кадра N. Число отправленных, но еще не
+ * растеризованных кадров ограничено: Submit ждет, пока очередь заполнена
+ *
+ * Кадры рисуются в изображения из пула конвейера. Изображения, которые больше не нужны, можно
+ * вернуть в пул через ReleaseFramebuffer, тогда память под кадры не выделяется повторно
+ */
+class RenderPipeline {
+public:
+    /**
+     * @brief Обработчик готового кадра
+     *
+     * Вызывается потоком растеризации конвейера
+     */
+    using Callback = std::function<void(Image&&)>;
+
+    /**
+     * @brief Создание конвейера
+     *
+     * Рендерер должен существовать дольше конвейера
+     *
+     * @param[in] renderer Рендерер
+     * @param[in] width Ширина кадров, должна быть больше 0
+     * @param[in] height Высота кадров, должна быть больше 0
+     * @param[in] max_queued_frames Максимальное число отправленных, но не растеризованных кадров,
+     * больше 0
+     */
+    RenderPipeline(const Renderer& renderer, const Width width, const Height height,
+                   const size_t max_queued_frames = 2);
+
+    /**
+     * @brief Завершение конвейера
+     *
+     * Дожидается растеризации всех отправленных кадров
+     */
+    ~RenderPipeline();
+
+    /**
+     * @brief Отправка кадра
+     *
+     * Выполняет геометрическую стадию кадра и ставит его в очередь растеризации. Требуется, чтобы
+     * камера принадлежала сцене
+     *
+     * @param[in] scene Сцена
+     * @param[in] camera_id ID камеры в сцене
+     * @param[in] flags Флаги отрисовки
+     * @param[in,out] control Отмена и срок кадра или nullptr, если кадр не прерывается. Должен
+     * существовать, пока кадр не готов. В control->status записывается результат
+     *
+     * @return Future с готовым изображением. Если рендеринг прерван, изображение нарисовано
+     * частично
+     */
+    std::future<Image> Submit(const Scene& scene, const Scene::CameraId camera_id,
+                              const Renderer::RenderFlags flags = Renderer::DRAW_FACETS,
+                              RenderControl* control = nullptr);
+
+    /**
+     * @brief Отправка кадра с обработчиком
+     *
+     * Аналогичен Submit, возвращающему future, но готовое изображение передается в callback.
+     * Обработчики вызываются по одному в порядке отправки кадров, долгий обработчик задерживает
+     * растеризацию следующих кадров
+     *
+     * @param[in] scene Сцена
+     * @param[in] camera_id ID камеры в сцене
+     * @param[in] flags Флаги отрисовки
+     * @param[in] callback Обработчик готового кадра
+     * @param[in,out] control Отмена и срок кадра или nullptr, если кадр не прерывается. Должен
+     * существовать до вызова обработчика
+     */
+    void Submit(const Scene& scene, const Scene::CameraId camera_id,
+                const Renderer::RenderFlags flags, Callback callback,
+                RenderControl* control = nullptr);
+
+    /**
+     * @brief Возврат изображения в пул
+     *
+     * Требуется, чтобы размеры изображения совпадали с размерами кадров конвейера
+     *
+     * @param[in] image Изображение
+     */
+    void ReleaseFramebuffer(Image&& image);
+
+    /**
+     * @brief Ожидание растеризации всех отправленных кадров
+     */
+    void Wait();
+
+    /**
+     * @brief Память конвейера
+     *
+     * Учитывает буфер глубины потока растеризации, кадры в очереди и пулы изображений и
+     * треугольников. Кадр, растеризуемый в момент вызова, не учитывается. Может вызываться
+     * одновременно с работой конвейера
+     *
+     * @return Память конвейера
+     */
+    MemoryUsage GetMemoryUsage() const;
+
+    RenderPipeline(const RenderPipeline& other) = delete;
+    RenderPipeline(RenderPipeline&& other) = delete;
+
+    RenderPipeline& operator=(const RenderPipeline& other) = delete;
+    RenderPipeline& operator=(RenderPipeline&& other) = delete;
+
+private:
+    /**
+     * Кадр, ожидающий растеризации
+     */
+    struct Frame {
+        Renderer::Parameters parameters;
+        std::vector<LightSource> lights;  // источники света в пространстве камеры
+        std::vector<Triangle> triangles;  // результат геометрической стадии
+        Callback callback;
+        Tracer::FrameId frame_id = 0;  // номер кадра на временной шкале
+    };
+
+    /**
+     * @brief Цикл потока растеризации
+     */
+    void RasterLoop();
+
+    /**
+     * @brief Растеризация кадра
+     *
+     * @param[in,out] frame Кадр
+     *
+     * @return Изображение кадра
+     */
+    Image Rasterize(Frame& frame);
+
+    /**
+     * @brief Получение изображения из пула
+     *
+     * Возвращает свободное изображение, очищенное в черный цвет, или создает новое
+     */
+    Image AcquireFramebuffer();
+
+    const Renderer& renderer_;
+    const Width width_;
+    const Height height_;
+    const size_t max_queued_frames_;
+
+    RenderContext context_;  // используется только потоком растеризации
+
+    mutable std::mutex mutex_;
+    std::condition_variable frame_queued_;
+    std::condition_variable frame_done_;
+    std::deque<Frame> queue_;
+    size_t frames_in_flight_{0};  // отправленные и еще не обработанные кадры
+    std::vector<Image> free_framebuffers_;
+    std::vector<std::vector<Triangle>> free_triangles_;
+    size_t z_buffer_bytes_{0};  // размер буфера глубины после последнего кадра
+    bool stop_{false};
+
+    std::thread raster_thread_;
+};
+
+}  // namespace renderer
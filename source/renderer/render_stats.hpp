@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @brief Статистика отрисовки кадра
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "renderer/scene.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Статистика отрисовки кадра
+ *
+ * Заполняется методом Renderer::Render, если передан указатель на нее. Без него статистика не
+ * собирается, и отрисовка выполняется без дополнительных затрат. Чтобы замеры не искажали
+ * результат, часы опрашиваются выборочно: растеризация замеряется для каждого треугольника
+ * целиком, перевод и обрезка - для части граней, закраска - для части пикселей. Время этих стадий
+ * оценивается по выборке и счетчикам граней и пикселей
+ */
+struct RenderStats {
+    /**
+     * @brief Затраты на отрисовку одного объекта
+     */
+    struct ObjectStats {
+        /**
+         * Сетка объекта
+         */
+        Scene::MeshId mesh = 0;
+        /**
+         * Количество граней сетки
+         */
+        uint64_t triangles = 0;
+        /**
+         * Количество треугольников, переданных на растеризацию после обрезки
+         */
+        uint64_t triangles_drawn = 0;
+        /**
+         * Количество закрашенных пикселей
+         */
+        uint64_t pixels_shaded = 0;
+        /**
+         * Время всех стадий отрисовки объекта: замеренное время растеризации и доля оценки
+         * времени перевода и обрезки, пропорциональная количеству граней объекта
+         */
+        std::chrono::nanoseconds time{0};
+    };
+
+    /**
+     * Количество объектов сцены
+     */
+    uint64_t objects_submitted = 0;
+    /**
+     * Количество объектов, ни одна грань которых не попала на растеризацию
+     */
+    uint64_t objects_culled = 0;
+
+    /**
+     * Количество граней всех объектов
+     */
+    uint64_t triangles_submitted = 0;
+    /**
+     * Количество граней, обращенных от камеры
+     */
+    uint64_t triangles_backface_culled = 0;
+    /**
+     * Количество граней, полностью лежащих вне пирамиды зрения. Грани объектов, отброшенных по
+     * ограничивающей сфере, считаются здесь целиком, в том числе обращенные от камеры
+     */
+    uint64_t triangles_frustum_culled = 0;
+    /**
+     * Количество граней, частично обрезанных по пирамиде зрения
+     */
+    uint64_t triangles_clipped = 0;
+    /**
+     * Количество треугольников, переданных на растеризацию, в том числе полученных обрезкой
+     */
+    uint64_t triangles_produced = 0;
+
+    /**
+     * Количество пикселей внутри треугольников, для которых проверялся буфер глубины
+     */
+    uint64_t pixels_tested = 0;
+    /**
+     * Количество пикселей, прошедших проверку глубины
+     */
+    uint64_t pixels_passed_depth = 0;
+    /**
+     * Количество пикселей, для которых вычислялся цвет
+     */
+    uint64_t pixels_shaded = 0;
+    /**
+     * Количество пикселей кадра, на которые попала хотя бы одна грань или ребро
+     */
+    uint64_t pixels_covered = 0;
+    /**
+     * Отношение прошедших проверку глубины пикселей к покрытым, 0 для пустого кадра
+     */
+    double overdraw = 0;
+
+    /**
+     * Время перевода граней в пространство камеры и отсечения обращенных от камеры граней,
+     * оценка по выборке граней
+     */
+    std::chrono::nanoseconds transform_time{0};
+    /**
+     * Время обрезки граней по пирамиде зрения, оценка по выборке граней
+     */
+    std::chrono::nanoseconds clip_time{0};
+    /**
+     * Время растеризации, включая закраску
+     */
+    std::chrono::nanoseconds raster_time{0};
+    /**
+     * Время вычисления цвета пикселей, суммарное по всем потокам, оценка по выборке пикселей. При
+     * параллельной растеризации может превышать raster_time
+     */
+    std::chrono::nanoseconds shade_time{0};
+
+    /**
+     * Затраты на каждый объект, индекс совпадает с номером объекта в порядке Scene::ObjectsBegin
+     */
+    std::vector<ObjectStats> objects;
+};
+
+};  // namespace renderer
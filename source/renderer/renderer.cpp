@@ -1,12 +1,18 @@
 #include "renderer/renderer.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
 #include <glm/common.hpp>
 #include <glm/geometric.hpp>
 #include <glm/gtc/epsilon.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "renderer/resources_manager.hpp"
-#include "renderer/thread_pool.hpp"
+#include "renderer/task_group.hpp"
+#include "renderer/trace.hpp"
 
 namespace renderer {
 
@@ -81,8 +87,9 @@ Vertex InterpolateVertex(const Vertex& start, const Vertex& end, const float t)
  * Обрезает треугольник относительно плоскости, заданной вектором нормали и смещением
  * относительно начала координат. Остается часть, лежащая по ту же сторону плоскости, что и
  * нормаль. Эта часть разбивается на треугольники и записывается по переданному указателю,
- * возвращается количество записанных треугольников (0, 1 или 2). Требуется, чтобы по
- * переданному указателю было возможно записать 2 значения
+ * возвращается количество записанных треугольников (0, 1 или 2). Материал части совпадает с
+ * материалом исходного треугольника. Требуется, чтобы по переданному указателю было возможно
+ * записать 2 значения
  *
  * @param[in] triangle Треугольник для обрезки
  * @param[in] plane Плоскость
@@ -120,6 +127,7 @@ size_t ClipTriangleAganistPlane(const Triangle& triangle, const Vector4& plane,
     if (inside_count == 1) {
         // от треугольника остается один треугольник
         result[0].vertices[0] = inside[0];
+        result[0].material = triangle.material;
         {
             Vector direction = outside[0].point - inside[0].point;
             float t = PlaneIntersection(plane, inside[0].point,
@@ -138,6 +146,7 @@ size_t ClipTriangleAganistPlane(const Triangle& triangle, const Vector4& plane,
     {
         result[0].vertices[0] = inside[0];
         result[0].vertices[1] = inside[1];
+        result[0].material = triangle.material;
         {
             Vector direction = outside[0].point - inside[0].point;
             float t = PlaneIntersection(plane, inside[0].point,
@@ -148,6 +157,7 @@ size_t ClipTriangleAganistPlane(const Triangle& triangle, const Vector4& plane,
     {
         result[1].vertices[0] = inside[0];
         result[1].vertices[1] = result[0].vertices[2];
+        result[1].material = triangle.material;
         {
             Vector direction = outside[0].point - inside[1].point;
             float t = PlaneIntersection(plane, inside[1].point,
@@ -190,7 +200,6 @@ Vector Barycentric(const Point2& a, const Point2& b, const Point2& c, const Poin
 struct LightParameters {
     Point position;
     Vector normal;
-    const Matrix& scene_to_camera;
 };
 
 /**
@@ -259,7 +268,8 @@ inline float DistantStrength(const SpotLight& light_source, const float distance
 }
 
 /**
- * Вычисляет интенсивность цвета от заданного источника света
+ * Вычисляет интенсивность цвета от заданного источника света. Источник должен быть переведен в
+ * пространство камеры функцией LightToCamera
  */
 Color LightColor(const LightSource& source, const LightParameters& parameters,
                  const Material& material) {
@@ -270,8 +280,7 @@ Color LightColor(const LightSource& source, const LightParameters& parameters,
     if (std::holds_alternative<DirectionalLight>(source)) {
         const DirectionalLight& light = std::get<DirectionalLight>(source);
 
-        Vector light_direction = -TransformVector(light.direction, parameters.scene_to_camera);
-        light_direction = glm::normalize(light_direction);
+        Vector light_direction = -light.direction;
 
         float diff = glm::max(glm::dot(light_direction, parameters.normal), 0.0f);
 
@@ -287,8 +296,7 @@ Color LightColor(const LightSource& source, const LightParameters& parameters,
     if (std::holds_alternative<PointLight>(source)) {
         const PointLight& light = std::get<PointLight>(source);
 
-        Point light_position = TransformPoint(light.position, parameters.scene_to_camera);
-        Vector light_direction = (light_position - parameters.position);
+        Vector light_direction = (light.position - parameters.position);
 
         float distance = glm::length(light_direction);
         light_direction = glm::normalize(light_direction);
@@ -308,17 +316,13 @@ Color LightColor(const LightSource& source, const LightParameters& parameters,
     if (std::holds_alternative<SpotLight>(source)) {
         const SpotLight& light = std::get<SpotLight>(source);
 
-        Point light_position = TransformPoint(light.position, parameters.scene_to_camera);
-        Vector light_direction = (light_position - parameters.position);
+        Vector light_direction = (light.position - parameters.position);
 
         float distance = glm::length(light_direction);
         light_direction = glm::normalize(light_direction);
 
-        Vector beam_direction = TransformVector(light.direction, parameters.scene_to_camera);
-        beam_direction = glm::normalize(beam_direction);
-
         float distance_strength =
-            glm::pow(glm::max(-glm::dot(beam_direction, light_direction), 0.0f), light.exponent) *
+            glm::pow(glm::max(-glm::dot(light.direction, light_direction), 0.0f), light.exponent) *
             DistantStrength(light, distance);
 
         float diff = glm::max(glm::dot(light_direction, parameters.normal), 0.0f);
@@ -337,79 +341,693 @@ Color LightColor(const LightSource& source, const LightParameters& parameters,
     return Vector{0};
 }
 
+/**
+ * Перевод источника света в пространство камеры. Направления источников нормируются
+ */
+LightSource LightToCamera(LightSource source, const Matrix& scene_to_camera) {
+    if (std::holds_alternative<DirectionalLight>(source)) {
+        DirectionalLight& light = std::get<DirectionalLight>(source);
+        light.direction = glm::normalize(TransformVector(light.direction, scene_to_camera));
+    } else if (std::holds_alternative<PointLight>(source)) {
+        PointLight& light = std::get<PointLight>(source);
+        light.position = TransformPoint(light.position, scene_to_camera);
+    } else if (std::holds_alternative<SpotLight>(source)) {
+        SpotLight& light = std::get<SpotLight>(source);
+        light.position = TransformPoint(light.position, scene_to_camera);
+        light.direction = glm::normalize(TransformVector(light.direction, scene_to_camera));
+    }
+    return source;
+}
+
+/**
+ * Минимальное число экземпляров на одну задачу при пакетном вычислении матриц
+ */
+constexpr size_t kInstancesPerTask = 1024;
+
+/**
+ * Минимальное число сеток на одну задачу при вычислении ограничивающих сфер
+ */
+constexpr size_t kMeshesPerTask = 16;
+
+/**
+ * Относительный запас при отсечении объектов по ограничивающей сфере. Покрывает погрешность
+ * перевода вершин в пространство камеры, чтобы объект не отсекался, пока его грани могут
+ * оставаться внутри пирамиды зрения
+ */
+constexpr float kBoundsSlack = 1e-4f;
+
+/**
+ * Минимальное число строк треугольника на одну задачу при растеризации
+ */
+constexpr size_t kMinRowsPerTask = 8;
+
+/**
+ * Выборочный замер для статистики: время перевода и обрезки замеряется у каждой
+ * kStatsSampleInterval-й грани, время закраски - у пикселей, обе координаты которых кратны
+ * kShadeSampleStep. Остальные грани и пиксели обрабатываются без опроса часов
+ */
+constexpr size_t kStatsSampleInterval = 64;
+constexpr int32_t kShadeSampleStep = 8;
+
+/**
+ * Часы для замера стадий кадра
+ */
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Замер последовательных стадий
+ *
+ * Каждый вызов Lap возвращает время с предыдущего вызова. Если замер отключен, часы не
+ * опрашиваются
+ */
+class StageTimer {
+public:
+    explicit StageTimer(const bool enabled)
+        : enabled_{enabled}, last_{enabled ? Clock::now() : Clock::time_point{}} {
+    }
+
+    std::chrono::nanoseconds Lap() {
+        if (not enabled_) {
+            return std::chrono::nanoseconds{0};
+        }
+        const Clock::time_point now = Clock::now();
+        const std::chrono::nanoseconds elapsed = now - last_;
+        last_ = now;
+        return elapsed;
+    }
+
+private:
+    bool enabled_;
+    Clock::time_point last_;
+};
+
+/**
+ * @brief Оценка общего времени по выборочному замеру
+ *
+ * @param[in] sampled Суммарное время замеренных операций
+ * @param[in] samples Количество замеренных операций
+ * @param[in] total Общее количество операций
+ *
+ * @return Время всех операций в предположении, что замеренные операции типичны
+ */
+std::chrono::nanoseconds ScaleSampled(const std::chrono::nanoseconds sampled,
+                                      const uint64_t samples, const uint64_t total) {
+    if (samples == 0) {
+        return std::chrono::nanoseconds{0};
+    }
+    return std::chrono::nanoseconds{static_cast<int64_t>(static_cast<double>(sampled.count()) *
+                                                         static_cast<double>(total) /
+                                                         static_cast<double>(samples))};
+}
+
+/**
+ * @brief Цвет тепловой карты
+ *
+ * Значение переводится в логарифмическую шкалу: 1 - синий, далее голубой, зеленый, желтый и
+ * красный для max и больших значений. Нулевое значение - черный
+ */
+Image::Pixel HeatmapColor(const uint32_t value, const uint32_t max) {
+    if (value == 0) {
+        return Image::Pixel{.r = 0, .g = 0, .b = 0};
+    }
+    constexpr Image::Pixel kStops[] = {{.r = 0, .g = 0, .b = 255},
+                                       {.r = 0, .g = 255, .b = 255},
+                                       {.r = 0, .g = 255, .b = 0},
+                                       {.r = 255, .g = 255, .b = 0},
+                                       {.r = 255, .g = 0, .b = 0}};
+    constexpr size_t kSegments = std::size(kStops) - 1;
+    const float t = std::min(std::log2(static_cast<float>(value)) /
+                                 std::log2(static_cast<float>(max)),
+                             1.0f);
+    const size_t index = std::min(static_cast<size_t>(t * kSegments), kSegments - 1);
+    const float fraction = t * kSegments - static_cast<float>(index);
+    auto blend = [fraction](const uint8_t from, const uint8_t to) {
+        return static_cast<uint8_t>(std::lround(std::lerp(static_cast<float>(from),
+                                                          static_cast<float>(to), fraction)));
+    };
+    const Image::Pixel& from = kStops[index];
+    const Image::Pixel& to = kStops[index + 1];
+    return Image::Pixel{
+        .r = blend(from.r, to.r), .g = blend(from.g, to.g), .b = blend(from.b, to.b)};
+}
+
+/**
+ * @brief Проверка, изменила ли обрезка треугольник
+ *
+ * Нетронутый треугольник копируется обрезкой без изменений, поэтому достаточно точного сравнения
+ * вершин
+ */
+bool IsClipped(const Triangle& triangle, const Triangle* clipped, const size_t size) {
+    if (size != 1) {
+        return true;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        if (clipped->vertices[i].point != triangle.vertices[i].point) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Матрицы перевода экземпляра объекта в пространство камеры
+ */
+struct InstanceTransform {
+    Matrix object_to_camera;
+    Matrix3 normal_to_camera;
+};
+
+/**
+ * @brief Пакетное вычисление матриц объектов в координатах сцены
+ *
+ * @param[in] thread_pool ThreadPool для вычислений
+ * @param[in] scene Сцена
+ *
+ * @return Матрицы объектов в порядке их следования в сцене
+ */
+std::vector<Matrix> ComputeWorldMatrices(ThreadPool& thread_pool, const Scene& scene) {
+    const size_t objects_count = scene.ObjectsEnd() - scene.ObjectsBegin();
+    std::vector<Matrix> world_matrices(objects_count);
+    auto compute_range = [&scene, &world_matrices](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            world_matrices[i] = scene.GetWorldMatrix(scene.ObjectsBegin()[i]);
+        }
+    };
+    thread_pool.ParallelFor(0, objects_count, kInstancesPerTask, compute_range);
+    return world_matrices;
+}
+
+/**
+ * @brief Пакетное вычисление матриц экземпляров
+ *
+ * Вычисляет матрицы перевода в пространство камеры для всех объектов сцены. При большом числе
+ * объектов вычисление распределяется между потоками ThreadPool
+ *
+ * @param[in] thread_pool ThreadPool для вычислений
+ * @param[in] world_matrices Матрицы объектов в координатах сцены
+ * @param[in] scene_to_camera Матрица перевода из пространства сцены в пространство камеры
+ *
+ * @return Матрицы объектов в порядке их следования в сцене
+ */
+std::vector<InstanceTransform> ComputeInstanceTransforms(ThreadPool& thread_pool,
+                                                         const std::vector<Matrix>& world_matrices,
+                                                         const Matrix& scene_to_camera) {
+    const size_t objects_count = world_matrices.size();
+    std::vector<InstanceTransform> transforms(objects_count);
+    auto compute_range = [&world_matrices, &scene_to_camera, &transforms](const size_t begin,
+                                                                          const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Matrix object_to_camera = scene_to_camera * world_matrices[i];
+            transforms[i].object_to_camera = object_to_camera;
+            transforms[i].normal_to_camera =
+                glm::transpose(glm::inverse(Matrix3{object_to_camera}));
+        }
+    };
+    thread_pool.ParallelFor(0, objects_count, kInstancesPerTask, compute_range);
+    return transforms;
+}
+
+/**
+ * @brief Порядок отрисовки экземпляров
+ *
+ * Возвращает номера объектов сцены, сгруппированные по сеткам, чтобы грани одной сетки читались
+ * подряд для всех ее экземпляров. Внутри группы сохраняется порядок объектов в сцене
+ *
+ * @param[in] scene Сцена
+ *
+ * @return Номера объектов в порядке отрисовки
+ */
+std::vector<size_t> InstancesDrawOrder(const Scene& scene) {
+    const size_t objects_count = scene.ObjectsEnd() - scene.ObjectsBegin();
+    std::vector<size_t> mesh_offsets(scene.MeshesCount() + 1, 0);
+    for (auto it = scene.ObjectsBegin(); it != scene.ObjectsEnd(); ++it) {
+        ++mesh_offsets[scene.MeshIndex(it->Mesh()) + 1];
+    }
+    for (size_t mesh = 0; mesh < scene.MeshesCount(); ++mesh) {
+        mesh_offsets[mesh + 1] += mesh_offsets[mesh];
+    }
+    std::vector<size_t> order(objects_count);
+    for (size_t i = 0; i < objects_count; ++i) {
+        order[mesh_offsets[scene.MeshIndex(scene.ObjectsBegin()[i].Mesh())]++] = i;
+    }
+    return order;
+}
+
+/**
+ * @brief Оценка сверху коэффициента растяжения аффинного преобразования
+ *
+ * Оценка по кругам Гершгорина для матрицы Грама столбцов. Для преобразований без сдвига
+ * (поворот, масштаб, перенос) совпадает с наибольшим масштабом по осям
+ *
+ * @param[in] transform Матрица преобразования
+ *
+ * @return Во сколько раз преобразование может увеличить длину вектора, не меньше точного значения
+ */
+float MaxScale(const Matrix& transform) {
+    const Vector columns[3] = {Vector{transform[0]}, Vector{transform[1]}, Vector{transform[2]}};
+    float max_scale2 = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        float row_sum = 0;
+        for (size_t j = 0; j < 3; ++j) {
+            const float product = glm::dot(columns[i], columns[j]);
+            row_sum += (i == j) ? product : std::abs(product);
+        }
+        max_scale2 = std::max(max_scale2, row_sum);
+    }
+    return std::sqrt(max_scale2);
+}
+
+/**
+ * @brief Ограничивающие сферы объектов
+ *
+ * Сфера сетки строится по ограничивающему параллелепипеду ее граней один раз, грани читаются
+ * через первый объект с этой сеткой в порядке отрисовки. Сферы экземпляров получаются переносом
+ * сферы сетки матрицами объектов
+ *
+ * @param[in] thread_pool ThreadPool для вычислений
+ * @param[in] scene Сцена
+ * @param[in] world_matrices Матрицы объектов в координатах сцены
+ * @param[in] draw_order Порядок отрисовки, в котором объекты сгруппированы по сеткам
+ *
+ * @return Центр и радиус сферы каждого объекта в координатах сцены
+ */
+std::vector<Vector4> ComputeObjectBounds(ThreadPool& thread_pool, const Scene& scene,
+                                         const std::vector<Matrix>& world_matrices,
+                                         const std::vector<size_t>& draw_order) {
+    const size_t objects_count = draw_order.size();
+    std::vector<size_t> group_begins;
+    for (size_t i = 0; i < objects_count; ++i) {
+        if (i == 0 or scene.ObjectsBegin()[draw_order[i]].Mesh() !=
+                          scene.ObjectsBegin()[draw_order[i - 1]].Mesh()) {
+            group_begins.push_back(i);
+        }
+    }
+    group_begins.push_back(objects_count);
+
+    std::vector<Vector4> bounds(objects_count);
+    auto compute_range = [&](const size_t begin, const size_t end) {
+        for (size_t group = begin; group < end; ++group) {
+            const SceneObject& object = scene.ObjectsBegin()[draw_order[group_begins[group]]];
+            Point min{std::numeric_limits<float>::max()};
+            Point max{std::numeric_limits<float>::lowest()};
+            for (size_t triangle_index = 0; triangle_index < object.Size(); ++triangle_index) {
+                const Triangle triangle = scene.GetFacet(object, triangle_index);
+                for (const Vertex& vertex : triangle.vertices) {
+                    min = glm::min(min, vertex.point);
+                    max = glm::max(max, vertex.point);
+                }
+            }
+            const Point center = (object.Size() != 0) ? (min + max) * 0.5f : Point{0};
+            const float radius = (object.Size() != 0) ? glm::length(max - min) * 0.5f : 0.0f;
+            for (size_t i = group_begins[group]; i < group_begins[group + 1]; ++i) {
+                const Matrix& world_matrix = world_matrices[draw_order[i]];
+                bounds[draw_order[i]] = Vector4{TransformPoint(center, world_matrix),
+                                                radius * MaxScale(world_matrix)};
+            }
+        }
+    };
+    thread_pool.ParallelFor(0, group_begins.size() - 1, kMeshesPerTask, compute_range);
+    return bounds;
+}
+
+/**
+ * @brief Проверка, что сфера целиком лежит вне пирамиды зрения
+ *
+ * @param[in] frustum_planes Плоскости пирамиды зрения в пространстве камеры
+ * @param[in] center Центр сферы в пространстве камеры
+ * @param[in] radius Радиус сферы в пространстве камеры
+ *
+ * @return Лежит ли сфера по внешнюю сторону хотя бы одной плоскости
+ */
+bool IsOutsideFrustum(const Vector4 (&frustum_planes)[5], const Point& center,
+                      const float radius) {
+    const float margin = radius + kBoundsSlack * (radius + glm::length(center) + 1.0f);
+    for (const Vector4& plane : frustum_planes) {
+        if (glm::dot(plane, Point4{center, 1}) < -margin) {
+            return true;
+        }
+    }
+    return false;
+}
+
 }  // namespace
 
+size_t RenderContext::GetMemoryBytes() const {
+    return z_buffer_.capacity() * sizeof(float) + heat_buffer_.capacity() * sizeof(uint32_t) +
+           lights_.capacity() * sizeof(LightSource);
+}
+
+Renderer::Renderer() : Renderer(ThreadPool::Get(), ResourcesManager::Get()) {
+}
+
+Renderer::Renderer(ThreadPool& thread_pool, const ResourcesManager& resources_manager)
+    : thread_pool_{&thread_pool}, resources_manager_{&resources_manager} {
+}
+
 Image Renderer::Render(const Scene& scene, const Scene::CameraId camera_id, Image&& image,
-                       const RenderFlags flags) {
+                       const RenderFlags flags, RenderStats* stats, RenderControl* control) {
+    return Render(context_, scene, camera_id, std::move(image), flags, stats, control);
+}
+
+Image Renderer::Render(RenderContext& context, const Scene& scene, const Scene::CameraId camera_id,
+                       Image&& image, const RenderFlags flags, RenderStats* stats,
+                       RenderControl* control) const {
+    if (control != nullptr) {
+        control->status.store(RenderControl::COMPLETED, std::memory_order_relaxed);
+    }
     if (image.GetWidth() != 0 and image.GetHeight() != 0) {
         {
-            assert((image.GetWidth() != 0) and
-                   "Render: ширина переданного изображения не может быть 0");
-            assert((image.GetHeight() != 0) and
-                   "Render: высота переданного изображения не может быть 0");
+            assert((scene.HasCamera(camera_id)) and "Render: камера должна принадлежать сцене");
+        }
+        Tracer::Get().BeginFrame();
+        RenderView(context, scene, PrepareScene(scene), camera_id, image, flags, stats, control);
+    }
+    return image;
+}
 
+std::vector<Image> Renderer::Render(const Scene& scene,
+                                    std::span<const Scene::CameraId> camera_ids,
+                                    std::vector<Image>&& images, const RenderFlags flags,
+                                    std::span<RenderStats> stats, RenderControl* control) {
+    if (batch_contexts_.size() < camera_ids.size()) {
+        batch_contexts_.resize(camera_ids.size());
+    }
+    return Render(batch_contexts_, scene, camera_ids, std::move(images), flags, stats, control);
+}
+
+std::vector<Image> Renderer::Render(std::span<RenderContext> contexts, const Scene& scene,
+                                    std::span<const Scene::CameraId> camera_ids,
+                                    std::vector<Image>&& images, const RenderFlags flags,
+                                    std::span<RenderStats> stats, RenderControl* control) const {
+    {
+        assert((camera_ids.size() == images.size()) and
+               "Render: количество камер и изображений должно совпадать");
+        assert((contexts.size() >= camera_ids.size()) and
+               "Render: контекстов должно быть не меньше, чем камер");
+        assert((stats.empty() or stats.size() == camera_ids.size()) and
+               "Render: количество статистик должно совпадать с количеством камер");
+        for (const Scene::CameraId camera_id : camera_ids) {
             assert((scene.HasCamera(camera_id)) and "Render: камера должна принадлежать сцене");
         }
-        flags_ = flags;
-        UpdateInternalState(image.GetWidth(), image.GetHeight(),
-                            scene.AccessCamera(camera_id).GetFocalLength(),
-                            scene.AccessCamera(camera_id).GetFovX());
-        parameters_.light_begin = scene.LightBegin();
-        parameters_.light_end = scene.LightEnd();
-        parameters_.scene_to_camera = scene.AccessCamera(camera_id).GetViewMatrix();
-        const Object::FacetType* facets_storage = scene.AccessFacetsStorage();
-        for (auto objects_it = scene.ObjectsBegin(); objects_it != scene.ObjectsEnd();
-             ++objects_it) {
-            Matrix object_to_camera = parameters_.scene_to_camera * objects_it->GetObjectMatrix();
-            Matrix3 normal_to_camera = glm::transpose(glm::inverse(Matrix3{object_to_camera}));
-            for (size_t triangle_index = 0; triangle_index < objects_it->Size(); ++triangle_index) {
-                Triangle triangle = facets_storage[objects_it->Begin() + triangle_index];
-                // нормализуем координаты и переводим в координаты камеры
-                for (size_t i = 0; i < 3; ++i) {
-                    triangle.vertices[i].point =
-                        TransformPoint(triangle.vertices[i].point, object_to_camera);
-                    triangle.vertices[i].normal = glm::normalize(
-                        TransformVector(triangle.vertices[i].normal, normal_to_camera));
-                }
-                // находим нормаль к грани
-                Vector triangle_normal =
-                    glm::cross(triangle.vertices[1].point - triangle.vertices[0].point,
-                               triangle.vertices[2].point - triangle.vertices[0].point);
-
-                // отсечение по направлению грани
-                const Material& material =
-                    ResourcesManager::Get().AccessMaterial(triangle.material);
-                if ((flags_ & DISABLE_BACKFACE_CULLING) == 0 and (not material.two_sided)) {
-                    Vector camera_direction = -triangle.vertices[0].point;
-                    if (glm::dot(triangle_normal, camera_direction) < 0.0f) {
-                        continue;
-                    }
-                }
+    }
+    if (control != nullptr) {
+        control->status.store(RenderControl::COMPLETED, std::memory_order_relaxed);
+    }
+    Tracer::Get().BeginFrame();
+    const SceneParameters scene_parameters = PrepareScene(scene);
+    TaskGroup group{*thread_pool_};
+    for (size_t view = 0; view < camera_ids.size(); ++view) {
+        if (images[view].GetWidth() == 0 or images[view].GetHeight() == 0) {
+            continue;
+        }
+        RenderStats* view_stats = stats.empty() ? nullptr : &stats[view];
+        group.Run([this, &contexts, &scene, &scene_parameters, &camera_ids, &images, view, flags,
+                   view_stats, control]() {
+            RenderView(contexts[view], scene, scene_parameters, camera_ids[view], images[view],
+                       flags, view_stats, control);
+        });
+    }
+    group.Wait();
+    return std::move(images);
+}
+
+MemoryUsage Renderer::GetMemoryUsage() const {
+    MemoryUsage usage{.subsystem = "Renderer"};
+    size_t z_buffer_bytes = context_.GetMemoryBytes();
+    for (const RenderContext& context : batch_contexts_) {
+        z_buffer_bytes += context.GetMemoryBytes();
+    }
+    usage.AddPart("z_buffer", z_buffer_bytes);
+    usage.AddPart("contexts", batch_contexts_.capacity() * sizeof(RenderContext));
+    return usage;
+}
 
-                // отсечение по пирамиде зрения
-                Triangle clipped_triangles[63];
-                size_t start;
-                size_t size = ClipTriangle(triangle, clipped_triangles, &start);
+Renderer::SceneParameters Renderer::PrepareScene(const Scene& scene) const {
+    TraceScope trace{"PrepareScene"};
+    SceneParameters scene_parameters;
+    scene_parameters.world_matrices = ComputeWorldMatrices(*thread_pool_, scene);
+    scene_parameters.draw_order = InstancesDrawOrder(scene);
+    scene_parameters.object_bounds =
+        ComputeObjectBounds(*thread_pool_, scene, scene_parameters.world_matrices,
+                            scene_parameters.draw_order);
+    scene_parameters.lights.assign(scene.LightBegin(), scene.LightEnd());
+    return scene_parameters;
+}
 
-                // отрисовка
-                for (size_t i = 0; i < size; ++i) {
-                    DrawTriangle(image, clipped_triangles[start + i]);
+template <typename Consumer>
+void Renderer::ProcessGeometry(const Parameters& parameters, const Scene& scene,
+                               const SceneParameters& scene_parameters,
+                               Consumer&& consumer) const {
+    StatsCollector* const collector = parameters.stats;
+    RenderStats* const stats = (collector != nullptr) ? collector->stats : nullptr;
+    StageTimer timer{stats != nullptr};
+    RenderControl* const control = parameters.control;
+    if (control != nullptr and control->ShouldStop()) {
+        return;
+    }
+    size_t triangles_until_check = kTrianglesPerControlCheck;
+
+    const std::vector<InstanceTransform> transforms =
+        ComputeInstanceTransforms(*thread_pool_, scene_parameters.world_matrices,
+                                  parameters.scene_to_camera);
+    const float camera_scale = MaxScale(parameters.scene_to_camera);
+    // перевод и обрезка замеряются выборочно, растеризация - для каждой грани целиком
+    const std::chrono::nanoseconds setup_time = timer.Lap();
+    std::chrono::nanoseconds sampled_transform_time{0};
+    std::chrono::nanoseconds sampled_clip_time{0};
+    uint64_t transform_samples = 0;
+    uint64_t clip_samples = 0;
+    uint64_t triangles_transformed = 0;
+    uint64_t triangles_clip_tested = 0;
+    size_t triangles_until_sample = 0;
+    // количество граней каждого объекта, попавших в пирамиду зрения
+    std::vector<uint64_t> object_triangles;
+    if (stats != nullptr) {
+        object_triangles.assign(stats->objects.size(), 0);
+    }
+    bool stopped = false;
+    for (size_t object_index : scene_parameters.draw_order) {
+        const SceneObject& object = scene.ObjectsBegin()[object_index];
+        const Matrix& object_to_camera = transforms[object_index].object_to_camera;
+        const Matrix3& normal_to_camera = transforms[object_index].normal_to_camera;
+        const Vector4& bounds = scene_parameters.object_bounds[object_index];
+        // грани объекта вне пирамиды зрения не переводятся в пространство камеры
+        const bool outside = IsOutsideFrustum(
+            parameters.frustum_planes, TransformPoint(Point{bounds}, parameters.scene_to_camera),
+            bounds.w * camera_scale);
+        const size_t triangles_count = outside ? 0 : object.Size();
+
+        uint64_t object_pixels = 0;
+        std::chrono::nanoseconds object_raster_time{0};
+        if (stats != nullptr) {
+            object_pixels = collector->pixels_shaded.load(std::memory_order_relaxed);
+            stats->objects[object_index].mesh = object.Mesh();
+            stats->objects[object_index].triangles = object.Size();
+            stats->triangles_frustum_culled += object.Size() - triangles_count;
+            triangles_transformed += triangles_count;
+            object_triangles[object_index] = triangles_count;
+        }
+        for (size_t triangle_index = 0; triangle_index < triangles_count; ++triangle_index) {
+            if (control != nullptr and triangles_until_check-- == 0) {
+                if (control->ShouldStop()) {
+                    stopped = true;
+                    break;
                 }
+                triangles_until_check = kTrianglesPerControlCheck - 1;
+            }
+            const bool sampled = stats != nullptr and triangles_until_sample-- == 0;
+            if (sampled) {
+                triangles_until_sample = kStatsSampleInterval - 1;
+                timer.Lap();
+            }
+            Triangle triangle = scene.GetFacet(object, triangle_index);
+            // нормализуем координаты и переводим в координаты камеры
+            for (size_t i = 0; i < 3; ++i) {
+                triangle.vertices[i].point =
+                    TransformPoint(triangle.vertices[i].point, object_to_camera);
+                triangle.vertices[i].normal = glm::normalize(
+                    TransformVector(triangle.vertices[i].normal, normal_to_camera));
+            }
+            // находим нормаль к грани
+            Vector triangle_normal =
+                glm::cross(triangle.vertices[1].point - triangle.vertices[0].point,
+                           triangle.vertices[2].point - triangle.vertices[0].point);
+
+            // отсечение по направлению грани
+            const Material& material = resources_manager_->AccessMaterial(triangle.material);
+            bool backface = false;
+            if ((parameters.flags & DISABLE_BACKFACE_CULLING) == 0 and (not material.two_sided)) {
+                Vector camera_direction = -triangle.vertices[0].point;
+                backface = glm::dot(triangle_normal, camera_direction) < 0.0f;
+            }
+            if (sampled) {
+                sampled_transform_time += timer.Lap();
+                ++transform_samples;
+            }
+            if (stats != nullptr) {
+                stats->triangles_backface_culled += backface;
+            }
+            if (backface) {
+                continue;
+            }
+
+            // отсечение по пирамиде зрения
+            Triangle clipped_triangles[63];
+            size_t start;
+            size_t size = ClipTriangle(parameters, triangle, clipped_triangles, &start);
+            if (sampled) {
+                sampled_clip_time += timer.Lap();
+                ++clip_samples;
+            }
+            if (stats != nullptr) {
+                ++triangles_clip_tested;
+                stats->triangles_frustum_culled += (size == 0);
+                stats->triangles_clipped +=
+                    (size != 0 and IsClipped(triangle, clipped_triangles + start, size));
+                stats->triangles_produced += size;
+                stats->objects[object_index].triangles_drawn += size;
+            }
+            if (size == 0) {
+                continue;
+            }
+
+            const Clock::time_point raster_start =
+                (stats != nullptr) ? Clock::now() : Clock::time_point{};
+            for (size_t i = 0; i < size; ++i) {
+                consumer(clipped_triangles[start + i]);
+            }
+            if (stats != nullptr) {
+                object_raster_time += Clock::now() - raster_start;
             }
         }
+        if (stats != nullptr) {
+            RenderStats::ObjectStats& object_stats = stats->objects[object_index];
+            // время перевода и обрезки граней объекта добавляется после оценки по всему кадру
+            object_stats.time = object_raster_time;
+            object_stats.pixels_shaded =
+                collector->pixels_shaded.load(std::memory_order_relaxed) - object_pixels;
+            stats->raster_time += object_raster_time;
+            stats->triangles_submitted += object.Size();
+            stats->objects_culled += (object_stats.triangles_drawn == 0);
+        }
+        if (stopped) {
+            break;
+        }
     }
-    return image;
+    if (stats == nullptr) {
+        return;
+    }
+    const std::chrono::nanoseconds transform_time =
+        ScaleSampled(sampled_transform_time, transform_samples, triangles_transformed);
+    const std::chrono::nanoseconds clip_time =
+        ScaleSampled(sampled_clip_time, clip_samples, triangles_clip_tested);
+    stats->transform_time += setup_time + transform_time;
+    stats->clip_time += clip_time;
+    // время перевода и обрезки делится между объектами пропорционально числу их граней,
+    // попавших в пирамиду зрения
+    const std::chrono::nanoseconds geometry_time = transform_time + clip_time;
+    for (size_t object_index = 0; object_index < object_triangles.size(); ++object_index) {
+        stats->objects[object_index].time +=
+            ScaleSampled(geometry_time, triangles_transformed, object_triangles[object_index]);
+    }
+}
+
+void Renderer::CollectGeometry(const Parameters& parameters, const Scene& scene,
+                               const SceneParameters& scene_parameters,
+                               std::vector<Triangle>& triangles) const {
+    TraceScope trace{"CollectGeometry"};
+    ProcessGeometry(parameters, scene, scene_parameters,
+                    [&triangles](const Triangle& triangle) { triangles.push_back(triangle); });
+}
+
+void Renderer::RenderView(RenderContext& context, const Scene& scene,
+                          const SceneParameters& scene_parameters,
+                          const Scene::CameraId camera_id, Image& image, const RenderFlags flags,
+                          RenderStats* stats, RenderControl* control) const {
+    TraceScope trace{"RenderView"};
+    Parameters parameters =
+        PrepareFrame(scene, camera_id, image.GetWidth(), image.GetHeight(), flags);
+    parameters.control = control;
+    PrepareLights(scene_parameters, parameters, context.lights_);
+    PrepareDepthBuffer(context, parameters);
+
+    StatsCollector collector{.stats = stats};
+    if (stats != nullptr) {
+        // память под статистику объектов переиспользуется между кадрами
+        std::vector<RenderStats::ObjectStats> objects = std::move(stats->objects);
+        *stats = RenderStats{};
+        objects.assign(scene.ObjectsEnd() - scene.ObjectsBegin(), RenderStats::ObjectStats{});
+        stats->objects = std::move(objects);
+        stats->objects_submitted = stats->objects.size();
+        parameters.stats = &collector;
+    }
+
+    {
+        TraceScope draw_trace{"DrawTriangles"};
+        ProcessGeometry(parameters, scene, scene_parameters,
+                        [this, &parameters, &image](const Triangle& triangle) {
+                            DrawTriangle(parameters, image, triangle);
+                        });
+    }
+
+    ResolveHeatmap(parameters, image);
+
+    if (stats != nullptr) {
+        stats->pixels_tested = collector.pixels_tested.load();
+        stats->pixels_passed_depth = collector.pixels_passed_depth.load();
+        stats->pixels_shaded = collector.pixels_shaded.load();
+        stats->shade_time =
+            ScaleSampled(std::chrono::nanoseconds{collector.shade_nanoseconds.load()},
+                         collector.shade_samples.load(), stats->pixels_shaded);
+        const float* z_buffer = parameters.z_buffer;
+        // непокрытые пиксели хранят бесконечность, записанную PrepareDepthBuffer
+        stats->pixels_covered =
+            std::count_if(z_buffer, z_buffer + parameters.width * parameters.height,
+                          [](const float z) { return not std::isinf(z); });
+        if (stats->pixels_covered != 0) {
+            stats->overdraw = static_cast<double>(stats->pixels_passed_depth) /
+                              static_cast<double>(stats->pixels_covered);
+        }
+    }
+}
+
+Renderer::Parameters Renderer::PrepareFrame(const Scene& scene, const Scene::CameraId camera_id,
+                                            const size_t width, const size_t height,
+                                            const RenderFlags flags) const {
+    {
+        assert((width != 0) and "PrepareFrame: ширина изображения не может быть 0");
+        assert((height != 0) and "PrepareFrame: высота изображения не может быть 0");
+        assert(((flags & HEATMAP_OVERDRAW) == 0 or (flags & HEATMAP_SHADING_COST) == 0) and
+               "PrepareFrame: тепловые карты не могут быть включены одновременно");
+    }
+    Parameters parameters;
+    parameters.flags = flags;
+    UpdateInternalState(parameters, width, height, scene.AccessCamera(camera_id).GetFocalLength(),
+                        scene.AccessCamera(camera_id).GetFovX());
+    parameters.scene_to_camera = scene.AccessCamera(camera_id).GetViewMatrix();
+    return parameters;
 }
 
-void Renderer::DrawLine(Image& image, const Point& start, const Point& end) {
+void Renderer::PrepareLights(const SceneParameters& scene_parameters, Parameters& parameters,
+                             std::vector<LightSource>& lights) const {
+    lights.clear();
+    for (const LightSource& light : scene_parameters.lights) {
+        lights.push_back(LightToCamera(light, parameters.scene_to_camera));
+    }
+    parameters.lights = lights;
+}
+
+void Renderer::DrawLine(const Parameters& parameters, Image& image, const Point& start,
+                        const Point& end) const {
     // DDA-Line
-    const size_t half_width = parameters_.width / 2;
-    const size_t half_height = (z_buffer_.size() / parameters_.width) / 2;
+    const size_t half_width = parameters.width / 2;
+    const size_t half_height = parameters.height / 2;
+    float* z_buffer = parameters.z_buffer;
 
-    const int32_t x_start = std::round(start.x * parameters_.x_scale * half_width);
-    const int32_t x_end = std::round(end.x * parameters_.x_scale * half_width);
-    const int32_t y_start = std::round(start.y * parameters_.y_scale * half_height);
-    const int32_t y_end = std::round(end.y * parameters_.y_scale * half_height);
+    const int32_t x_start = std::round(start.x * parameters.x_scale * half_width);
+    const int32_t x_end = std::round(end.x * parameters.x_scale * half_width);
+    const int32_t y_start = std::round(start.y * parameters.y_scale * half_height);
+    const int32_t y_end = std::round(end.y * parameters.y_scale * half_height);
 
     const uint32_t steps = std::max(std::abs(x_start - x_end), std::abs(y_start - y_end)) + 1;
 
@@ -428,69 +1046,70 @@ void Renderer::DrawLine(Image& image, const Point& start, const Point& end) {
         }
         const int32_t screen_x = std::round(current_point.x * half_width) + half_width;
         const int32_t screen_y = half_height - std::round(current_point.y * half_height);
-        if (screen_x < 0 or screen_x >= parameters_.width) {
+        if (screen_x < 0 or screen_x >= parameters.width) {
             continue;
         }
-        if (screen_y < 0 or screen_y >= z_buffer_.size() / parameters_.width) {
+        if (screen_y < 0 or screen_y >= parameters.height) {
             continue;
         }
         current_point.z -= 10 * kEpsilon;  // более четкие границы при совмещении с растеризацией
-        if (z_buffer_[screen_y * parameters_.width + screen_x] <= current_point.z) {
+        if (z_buffer[screen_y * parameters.width + screen_x] <= current_point.z) {
             continue;
         }
-        z_buffer_[screen_y * parameters_.width + screen_x] = current_point.z;
+        z_buffer[screen_y * parameters.width + screen_x] = current_point.z;
         image.AccessPixel(screen_x, screen_y) = {.r = 0, .g = 255, .b = 0};
     }
 }
 
-void Renderer::DrawTriangle(Image& image, const Triangle& triangle) {
-
+void Renderer::DrawTriangle(const Parameters& parameters, Image& image,
+                            const Triangle& triangle) const {
+    DrawParameters draw_parameters;
     Point4 clip_vertices[3];
     for (int i = 0; i < 3; ++i) {
         clip_vertices[i] = Point4{triangle.vertices[i].point, 1};
-        clip_vertices[i] = parameters_.camera_to_clip * clip_vertices[i];
+        clip_vertices[i] = parameters.camera_to_clip * clip_vertices[i];
         {
             assert((glm::epsilonNotEqual(clip_vertices[i].w, 0.0f, kEpsilon)) and
                    "Renderer: после умножения на матрицу перхода в Clip "
                    "пространство координата w стала 0");
         }
-        draw_parameters_.inv_w[i] = 1 / clip_vertices[i].w;
+        draw_parameters.inv_w[i] = 1 / clip_vertices[i].w;
     }
 
     for (int i = 0; i < 3; ++i) {
-        draw_parameters_.vertices[i] = clip_vertices[i] / clip_vertices[i].w;
+        draw_parameters.vertices[i] = clip_vertices[i] / clip_vertices[i].w;
     }
 
-    if (flags_ & DRAW_EDGES) {
-        DrawLine(image, draw_parameters_.vertices[0], draw_parameters_.vertices[1]);
-        DrawLine(image, draw_parameters_.vertices[1], draw_parameters_.vertices[2]);
-        DrawLine(image, draw_parameters_.vertices[2], draw_parameters_.vertices[0]);
+    if (parameters.flags & DRAW_EDGES) {
+        DrawLine(parameters, image, draw_parameters.vertices[0], draw_parameters.vertices[1]);
+        DrawLine(parameters, image, draw_parameters.vertices[1], draw_parameters.vertices[2]);
+        DrawLine(parameters, image, draw_parameters.vertices[2], draw_parameters.vertices[0]);
     }
 
-    if (flags_ & DRAW_FACETS) {
-        int32_t width = parameters_.width;
-        int32_t height = (z_buffer_.size() / parameters_.width);
+    if (parameters.flags & DRAW_FACETS) {
+        int32_t width = parameters.width;
+        int32_t height = parameters.height;
         int32_t half_width = width / 2;
         int32_t half_height = height / 2;
 
         Vector scale_factor{half_width, half_height, 1};  // растяжение вдоль осей
         for (int i = 0; i < 3; ++i) {
-            draw_parameters_.vertices[i] *= scale_factor;
+            draw_parameters.vertices[i] *= scale_factor;
         }
 
         // границы прямоугольника, содержащего треугольник (координаты экрана)
         float min_x =
-            glm::min(draw_parameters_.vertices[0].x,
-                     glm::min(draw_parameters_.vertices[1].x, draw_parameters_.vertices[2].x));
+            glm::min(draw_parameters.vertices[0].x,
+                     glm::min(draw_parameters.vertices[1].x, draw_parameters.vertices[2].x));
         float max_x =
-            glm::max(draw_parameters_.vertices[0].x,
-                     glm::max(draw_parameters_.vertices[1].x, draw_parameters_.vertices[2].x));
+            glm::max(draw_parameters.vertices[0].x,
+                     glm::max(draw_parameters.vertices[1].x, draw_parameters.vertices[2].x));
         float min_y =
-            glm::min(draw_parameters_.vertices[0].y,
-                     glm::min(draw_parameters_.vertices[1].y, draw_parameters_.vertices[2].y));
+            glm::min(draw_parameters.vertices[0].y,
+                     glm::min(draw_parameters.vertices[1].y, draw_parameters.vertices[2].y));
         float max_y =
-            glm::max(draw_parameters_.vertices[0].y,
-                     glm::max(draw_parameters_.vertices[1].y, draw_parameters_.vertices[2].y));
+            glm::max(draw_parameters.vertices[0].y,
+                     glm::max(draw_parameters.vertices[1].y, draw_parameters.vertices[2].y));
 
         // целочисленные границы, также обрезанные до границ экрана
         int32_t min_x_int = glm::round(min_x);
@@ -505,38 +1124,81 @@ void Renderer::DrawTriangle(Image& image, const Triangle& triangle) {
         int32_t max_y_int = glm::round(max_y);
         max_y_int = glm::min(max_y_int, half_height);
 
-        ThreadPool& thread_pool = ThreadPool::Get();
-        size_t threads = ThreadPool::GetThreadsCount();
-
-        int32_t lines_per_thread = (max_y_int - min_y_int + 1) / threads + 1;
-        int32_t current_line = min_y_int;
-        for (size_t i = 0; i < threads and current_line <= max_y_int; ++i) {
-            int32_t end_line = current_line + lines_per_thread - 1;
-            end_line = std::min(end_line, max_y_int);
-            thread_pool.Enqueue(
-                [this, &image, &triangle, min_x_int, current_line, max_x_int, end_line]() {
-                    TriangleRasterizationTask(image, triangle, min_x_int, current_line, max_x_int,
-                                              end_line);
-                });
-            current_line = end_line + 1;
+        if (min_y_int > max_y_int) {
+            return;
         }
-        thread_pool.WaitAll();
+        // время использования текстуры учитывается при вытеснении по бюджету
+        const ResourcesManager& manager = *resources_manager_;
+        manager.MarkTextureUsed(manager.AccessMaterial(triangle.material).texture);
+        // строки делятся между потоками, небольшие треугольники растеризуются без задач
+        size_t lines = max_y_int - min_y_int + 1;
+        size_t lines_per_thread =
+            std::max(lines / thread_pool_->GetWorkersCount() + 1, kMinRowsPerTask);
+        // на временной шкале отмечаются только треугольники, разделенные между потоками
+        const char* trace_name = (lines > lines_per_thread) ? "RasterizeRows" : nullptr;
+        // вариант растеризации выбирается один раз для треугольника: [статистика][тепловая карта]
+        using RasterizationTask = void (Renderer::*)(
+            const Parameters&, const DrawParameters&, Image&, const Triangle&, const int32_t,
+            const int32_t, const int32_t, const int32_t) const;
+        constexpr RasterizationTask kTasks[2][2] = {
+            {&Renderer::TriangleRasterizationTask<false, false>,
+             &Renderer::TriangleRasterizationTask<false, true>},
+            {&Renderer::TriangleRasterizationTask<true, false>,
+             &Renderer::TriangleRasterizationTask<true, true>}};
+        const RasterizationTask task =
+            kTasks[parameters.stats != nullptr][parameters.heat_buffer != nullptr];
+        // остановка проверяется внутри треугольников, разделенных между потоками, небольшие
+        // треугольники проверяются пакетами между гранями
+        RenderControl* const control = (lines > lines_per_thread) ? parameters.control : nullptr;
+        thread_pool_->ParallelFor(
+            0, lines, lines_per_thread,
+            [this, task, &parameters, &draw_parameters, &image, &triangle, min_x_int, min_y_int,
+             max_x_int, trace_name, control](const size_t begin, const size_t end) {
+                TraceScope trace{trace_name};
+                // с управлением кадром полоса рисуется группами строк, между которыми проверяется
+                // остановка. После остановки оставшиеся строки полосы пропускаются
+                const size_t rows_per_check = (control != nullptr) ? kMinRowsPerTask : end - begin;
+                for (size_t row = begin; row < end; row += rows_per_check) {
+                    if (control != nullptr and control->ShouldStop()) {
+                        return;
+                    }
+                    const size_t row_end = std::min(row + rows_per_check, end);
+                    (this->*task)(parameters, draw_parameters, image, triangle, min_x_int,
+                                  min_y_int + row, max_x_int, min_y_int + row_end - 1);
+                }
+            });
     }
 }
 
-void Renderer::TriangleRasterizationTask(Image& image, const Triangle& triangle, const int32_t x0,
-                                         const int32_t y0, const int32_t x1, const int32_t y1) {
-    int32_t width = parameters_.width;
-    int32_t height = (z_buffer_.size() / parameters_.width);
+template <bool kCollectStats, bool kHeatmap>
+void Renderer::TriangleRasterizationTask(const Parameters& parameters,
+                                         const DrawParameters& draw_parameters, Image& image,
+                                         const Triangle& triangle, const int32_t x0,
+                                         const int32_t y0, const int32_t x1,
+                                         const int32_t y1) const {
+    int32_t width = parameters.width;
+    int32_t height = parameters.height;
     int32_t half_width = width / 2;
     int32_t half_height = height / 2;
-    const ResourcesManager& manager = ResourcesManager::Get();
+    float* z_buffer = parameters.z_buffer;
+    const ResourcesManager& manager = *resources_manager_;
+    // счетчики задачи, добавляются в общую статистику один раз в конце
+    uint64_t pixels_tested = 0;
+    uint64_t pixels_passed_depth = 0;
+    uint64_t shade_samples = 0;
+    std::chrono::nanoseconds shade_time{0};
+    // тепловая карта: перерисовка или стоимость закраски - выборка из текстуры и источники света
+    uint32_t* heat_buffer = parameters.heat_buffer;
+    const bool heatmap_overdraw = (parameters.flags & HEATMAP_OVERDRAW) != 0;
+    const uint32_t shading_cost =
+        1 + ((parameters.flags & ENABLE_LIGHT) ? static_cast<uint32_t>(parameters.lights.size())
+                                               : 0);
     // перебор точек ограничивающего многоугольника
     for (int32_t y = y0; y <= y1; ++y) {
         for (int32_t x = x0; x <= x1; ++x) {
             Vector barycentric_coord =
-                Barycentric(draw_parameters_.vertices[0], draw_parameters_.vertices[1],
-                            draw_parameters_.vertices[2], Point2{x, y});
+                Barycentric(draw_parameters.vertices[0], draw_parameters.vertices[1],
+                            draw_parameters.vertices[2], Point2{x, y});
             // если хоть одна координата < 0, то точка вне треугольника. Вычисления
             // приближенные, из-за чего на краях могут появляться непрорисованне пиксели, для
             // чего используется менее строгое условие
@@ -545,18 +1207,43 @@ void Renderer::TriangleRasterizationTask(Image& image, const Triangle& triangle,
                 continue;
             }
             // точка внутри, проверка Z буффера
-            float z = (draw_parameters_.vertices[0] * barycentric_coord.x +
-                       draw_parameters_.vertices[1] * barycentric_coord.y +
-                       draw_parameters_.vertices[2] * barycentric_coord.z)
+            float z = (draw_parameters.vertices[0] * barycentric_coord.x +
+                       draw_parameters.vertices[1] * barycentric_coord.y +
+                       draw_parameters.vertices[2] * barycentric_coord.z)
                           .z;
             int32_t screen_x = x + half_width;
             int32_t screen_y = half_height - y;
-            if (z_buffer_[screen_y * width + screen_x] < z) {
+            if constexpr (kCollectStats) {
+                ++pixels_tested;
+            }
+            if constexpr (kHeatmap) {
+                if (heatmap_overdraw) {
+                    ++heat_buffer[screen_y * width + screen_x];
+                }
+            }
+            if (z_buffer[screen_y * width + screen_x] < z) {
                 continue;
             }
-            z_buffer_[screen_y * width + screen_x] = z;
-            float lambda = 1.0f / glm::dot(barycentric_coord, draw_parameters_.inv_w);
-            Vector coefs = barycentric_coord * draw_parameters_.inv_w;
+            z_buffer[screen_y * width + screen_x] = z;
+            if constexpr (kHeatmap) {
+                if (not heatmap_overdraw) {
+                    heat_buffer[screen_y * width + screen_x] += shading_cost;
+                }
+            }
+            // закраска замеряется только у пикселей сетки с шагом kShadeSampleStep
+            bool shade_sampled = false;
+            Clock::time_point shade_start;
+            if constexpr (kCollectStats) {
+                ++pixels_passed_depth;
+                shade_sampled =
+                    screen_x % kShadeSampleStep == 0 and screen_y % kShadeSampleStep == 0;
+                if (shade_sampled) {
+                    ++shade_samples;
+                    shade_start = Clock::now();
+                }
+            }
+            float lambda = 1.0f / glm::dot(barycentric_coord, draw_parameters.inv_w);
+            Vector coefs = barycentric_coord * draw_parameters.inv_w;
             Point2 uv_coordinates = (coefs[0] * triangle.vertices[0].uv_coordinates +
                                      coefs[1] * triangle.vertices[1].uv_coordinates +
                                      coefs[2] * triangle.vertices[2].uv_coordinates) *
@@ -566,8 +1253,8 @@ void Renderer::TriangleRasterizationTask(Image& image, const Triangle& triangle,
                 manager.AccessMaterial(triangle.material).texture, uv_coordinates);
 
             // вычисление света
-            if (flags_ & ENABLE_LIGHT) {
-                LightParameters light_parameters{.scene_to_camera = parameters_.scene_to_camera};
+            if (parameters.flags & ENABLE_LIGHT) {
+                LightParameters light_parameters;
                 light_parameters.position =
                     (coefs[0] * triangle.vertices[0].point + coefs[1] * triangle.vertices[1].point +
                      coefs[2] * triangle.vertices[2].point) *
@@ -579,8 +1266,8 @@ void Renderer::TriangleRasterizationTask(Image& image, const Triangle& triangle,
 
                 Color total_light_color{0, 0, 0};
                 const Material& material = manager.AccessMaterial(triangle.material);
-                for (auto it = parameters_.light_begin; it != parameters_.light_end; ++it) {
-                    total_light_color += LightColor(*it, light_parameters, material);
+                for (const LightSource& light : parameters.lights) {
+                    total_light_color += LightColor(light, light_parameters, material);
                 }
                 pixel_color *= total_light_color;
             }
@@ -598,12 +1285,27 @@ void Renderer::TriangleRasterizationTask(Image& image, const Triangle& triangle,
                        "TriangleRasterizationTask: компонента b вышла из диапазона");
             }
             image.AccessPixel(screen_x, screen_y) = {r, g, b};
+            if constexpr (kCollectStats) {
+                if (shade_sampled) {
+                    shade_time += Clock::now() - shade_start;
+                }
+            }
         }
     }
+    if constexpr (kCollectStats) {
+        StatsCollector& collector = *parameters.stats;
+        collector.pixels_tested.fetch_add(pixels_tested, std::memory_order_relaxed);
+        collector.pixels_passed_depth.fetch_add(pixels_passed_depth, std::memory_order_relaxed);
+        // каждый прошедший проверку глубины пиксель закрашивается
+        collector.pixels_shaded.fetch_add(pixels_passed_depth, std::memory_order_relaxed);
+        collector.shade_samples.fetch_add(shade_samples, std::memory_order_relaxed);
+        collector.shade_nanoseconds.fetch_add(shade_time.count(), std::memory_order_relaxed);
+    }
 }
 
-void Renderer::UpdateInternalState(const size_t width, const size_t height,
-                                   const float focal_length, const float fov_x) {
+void Renderer::UpdateInternalState(Parameters& parameters, const size_t width,
+                                   const size_t height, const float focal_length,
+                                   const float fov_x) const {
     {
         assert((width != 0) and
                "UpdateInternalState: ширина переданного изображения не может быть 0");
@@ -619,28 +1321,84 @@ void Renderer::UpdateInternalState(const size_t width, const size_t height,
         assert((focal_length <= 10.0) and
                "UpdateInternalState: focal_length должен быть не больше 10.0");
     }
-    parameters_.width = width;
+    parameters.width = width;
+    parameters.height = height;
     const float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
     const float scale_factor = focal_length * std::tan(glm::radians(fov_x) / 2);
 
     const float fov_y = 2.0f * std::atan2(std::tan(glm::radians(fov_x) / 2), aspect_ratio);
 
-    parameters_.x_scale = scale_factor;
-    parameters_.y_scale = aspect_ratio / scale_factor;
-
-    parameters_.camera_to_clip = glm::infinitePerspective(fov_y, aspect_ratio, focal_length);
-    z_buffer_.assign(width * height, std::numeric_limits<float>::infinity());
+    parameters.x_scale = scale_factor;
+    parameters.y_scale = aspect_ratio / scale_factor;
 
+    parameters.camera_to_clip = glm::infinitePerspective(fov_y, aspect_ratio, focal_length);
     // Плоскости пирамиды зрения
     // Порядок: ближняя, левая, правая, нижняя, верхняя
-    parameters_.frustum_planes[0] = {0, 0, -1, -focal_length};
-    parameters_.frustum_planes[1] = {glm::normalize(Vector{focal_length, 0, -1}), 0};
-    parameters_.frustum_planes[2] = {glm::normalize(Vector{-focal_length, 0, -1}), 0};
-    parameters_.frustum_planes[3] = {glm::normalize(Vector{0, focal_length, -aspect_ratio}), 0};
-    parameters_.frustum_planes[4] = {glm::normalize(Vector{0, -focal_length, -aspect_ratio}), 0};
+    parameters.frustum_planes[0] = {0, 0, -1, -focal_length};
+    parameters.frustum_planes[1] = {glm::normalize(Vector{focal_length, 0, -1}), 0};
+    parameters.frustum_planes[2] = {glm::normalize(Vector{-focal_length, 0, -1}), 0};
+    parameters.frustum_planes[3] = {glm::normalize(Vector{0, focal_length, -aspect_ratio}), 0};
+    parameters.frustum_planes[4] = {glm::normalize(Vector{0, -focal_length, -aspect_ratio}), 0};
+}
+
+void Renderer::PrepareDepthBuffer(RenderContext& context, Parameters& parameters) const {
+    TraceScope trace{"PrepareDepthBuffer"};
+    const size_t width = parameters.width;
+    const size_t height = parameters.height;
+    std::vector<float, FirstTouchAllocator<float>>& z_buffer = context.z_buffer_;
+    if (z_buffer.size() != width * height) {
+        // новая память не инициализируется, чтобы страницы размещались на узлах заполняющих потоков
+        z_buffer = {};
+        z_buffer.resize(width * height);
+    }
+    parameters.z_buffer = z_buffer.data();
+    const size_t rows_per_thread = height / thread_pool_->GetWorkersCount() + 1;
+    thread_pool_->ParallelFor(0, height, rows_per_thread,
+                              [&z_buffer, width](const size_t begin, const size_t end) {
+                                  std::fill(z_buffer.begin() + begin * width,
+                                            z_buffer.begin() + end * width,
+                                            std::numeric_limits<float>::infinity());
+                              });
+
+    parameters.heat_buffer = nullptr;
+    if ((parameters.flags & DRAW_FACETS) == 0 or
+        (parameters.flags & (HEATMAP_OVERDRAW | HEATMAP_SHADING_COST)) == 0) {
+        return;
+    }
+    std::vector<uint32_t, FirstTouchAllocator<uint32_t>>& heat_buffer = context.heat_buffer_;
+    if (heat_buffer.size() != width * height) {
+        heat_buffer = {};
+        heat_buffer.resize(width * height);
+    }
+    parameters.heat_buffer = heat_buffer.data();
+    thread_pool_->ParallelFor(0, height, rows_per_thread,
+                              [&heat_buffer, width](const size_t begin, const size_t end) {
+                                  std::fill(heat_buffer.begin() + begin * width,
+                                            heat_buffer.begin() + end * width, 0);
+                              });
+}
+
+void Renderer::ResolveHeatmap(const Parameters& parameters, Image& image) const {
+    if (parameters.heat_buffer == nullptr) {
+        return;
+    }
+    const uint32_t max = (parameters.flags & HEATMAP_OVERDRAW) ? kOverdrawHeatmapMax
+                                                               : kShadingCostHeatmapMax;
+    const size_t width = parameters.width;
+    const uint32_t* heat_buffer = parameters.heat_buffer;
+    Image::Pixel* pixels = image.AccessData();
+    const size_t rows_per_thread = parameters.height / thread_pool_->GetWorkersCount() + 1;
+    thread_pool_->ParallelFor(0, parameters.height, rows_per_thread,
+                              [heat_buffer, pixels, width, max](const size_t begin,
+                                                                const size_t end) {
+                                  for (size_t i = begin * width; i < end * width; ++i) {
+                                      pixels[i] = HeatmapColor(heat_buffer[i], max);
+                                  }
+                              });
 }
 
-size_t Renderer::ClipTriangle(const Triangle& triangle, Triangle* result, size_t* start) {
+size_t Renderer::ClipTriangle(const Parameters& parameters, const Triangle& triangle,
+                              Triangle* result, size_t* start) const {
     {
         assert(result and "ClipTriangle: result не должен быть nullptr");
         assert(start and "ClipTriangle: start не должен быть nullptr");
@@ -670,7 +1428,7 @@ size_t Renderer::ClipTriangle(const Triangle& triangle, Triangle* result, size_t
         size_t next_iteration_size = 0;
         for (size_t i = 0; i < iteration_size; ++i) {
             next_iteration_size += ClipTriangleAganistPlane(
-                result[iteration_start + i], parameters_.frustum_planes[iteration],
+                result[iteration_start + i], parameters.frustum_planes[iteration],
                 result + iteration_start + iteration_size + next_iteration_size);
         }
         iteration_start = iteration_start + iteration_size;
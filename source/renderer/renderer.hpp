@@ -5,15 +5,57 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 #include "image.hpp"
+#include "renderer/memory_report.hpp"
+#include "renderer/numa.hpp"
+#include "renderer/render_control.hpp"
+#include "renderer/render_stats.hpp"
+#include "renderer/resources_manager.hpp"
+#include "renderer/thread_pool.hpp"
 #include "scene.hpp"
 
 namespace renderer {
 
+/**
+ * @brief Контекст рендеринга
+ *
+ * Рабочие буферы, используемые при отрисовке кадра. Буферы переиспользуются между кадрами, пока не
+ * меняется размер изображения. Один контекст нельзя одновременно использовать в нескольких
+ * вызовах Renderer::Render, для параллельного рендеринга каждому потоку нужен свой контекст
+ */
+class RenderContext {
+public:
+    /**
+     * @brief Создание пустого контекста
+     */
+    RenderContext() = default;
+
+    /**
+     * @brief Память контекста
+     *
+     * @return Размер буферов контекста в байтах
+     */
+    size_t GetMemoryBytes() const;
+
+private:
+    friend class Renderer;
+
+    std::vector<float, FirstTouchAllocator<float>> z_buffer_;
+    std::vector<uint32_t, FirstTouchAllocator<uint32_t>> heat_buffer_;  // для тепловых карт
+    std::vector<LightSource> lights_;  // источники света кадра в пространстве камеры
+};
+
 /**
  * @brief Позволяет рендерит изображение с заданной камеры
+ *
+ * Renderer не хранит состояния кадра: все данные отрисовки находятся в RenderContext и на стеке
+ * вызова, поэтому константный метод Render можно одновременно вызывать из нескольких потоков с
+ * разными контекстами и изображениями
  */
 class Renderer {
 public:
@@ -38,13 +80,51 @@ public:
         /**
          * Рассчет освещения. Неактивно, если неактивно DRAW_FACETS
          */
-        ENABLE_LIGHT = 0b1000
+        ENABLE_LIGHT = 0b1000,
+        /**
+         * Вместо закрашенного изображения выводится тепловая карта перерисовки: количество
+         * проверок глубины в каждом пикселе при растеризации граней. Ребра на карте не
+         * отображаются. Неактивно, если неактивно DRAW_FACETS
+         */
+        HEATMAP_OVERDRAW = 0b10000,
+        /**
+         * Вместо закрашенного изображения выводится тепловая карта стоимости закраски: сумма
+         * выборок из текстур и вычисленных источников света по всем закраскам пикселя, включая
+         * закраски, перекрытые позже. Неактивно, если неактивно DRAW_FACETS. Не может быть
+         * установлен вместе с HEATMAP_OVERDRAW
+         */
+        HEATMAP_SHADING_COST = 0b100000
     };
 
+    /**
+     * @brief Значение тепловой карты перерисовки, отображаемое красным цветом
+     *
+     * Цвет тепловой карты зависит от логарифма значения: 1 - синий, далее голубой, зеленый,
+     * желтый и красный для максимального значения и больших. Пиксели с нулевым значением черные
+     */
+    static constexpr uint32_t kOverdrawHeatmapMax = 64;
+
+    /**
+     * @brief Значение тепловой карты стоимости закраски, отображаемое красным цветом
+     */
+    static constexpr uint32_t kShadingCostHeatmapMax = 1024;
+
     /**
      * @brief Создание рендерера
+     *
+     * Рендерер использует глобальные ThreadPool::Get() и ResourcesManager::Get()
      */
-    Renderer() = default;
+    Renderer();
+
+    /**
+     * @brief Создание рендерера с переданными зависимостями
+     *
+     * Объекты должны существовать дольше рендерера
+     *
+     * @param[in] thread_pool ThreadPool для параллельной отрисовки
+     * @param[in] resources_manager Хранилище материалов и текстур сцены
+     */
+    Renderer(ThreadPool& thread_pool, const ResourcesManager& resources_manager);
 
     /**
      * @brief Рендеринг камеры в изображение
@@ -57,55 +137,322 @@ public:
      * @param[in] camera_id ID камеры в сцене
      * @param[in] image Изображение
      * @param[in] flags Флаги отрисовки
+     * @param[out] stats Статистика кадра или nullptr, если она не нужна
+     * @param[in,out] control Отмена и срок кадра или nullptr, если кадр не прерывается. В
+     * control->status записывается результат
      *
-     * @return Срендеренное изображение
+     * @return Срендеренное изображение. Если рендеринг прерван, изображение нарисовано частично,
+     * а статистика описывает только выполненную часть
      *
-     * @note Если ширина или высота изображения равны 0, то оно возвращается без изменений
+     * @note Если ширина или высота изображения равны 0, то оно возвращается без изменений, а
+     * статистика не изменяется
+     * @note Использует внутренний контекст рендерера, поэтому не должен вызываться одновременно
+     * из нескольких потоков
      */
     Image Render(const Scene& scene, const Scene::CameraId camera_id, Image&& image,
-                 const RenderFlags flags = DRAW_FACETS);
+                 const RenderFlags flags = DRAW_FACETS, RenderStats* stats = nullptr,
+                 RenderControl* control = nullptr);
+
+    /**
+     * @brief Рендеринг камеры в изображение с переданным контекстом
+     *
+     * Аналогичен Render без контекста, но использует буферы переданного контекста. Может
+     * вызываться одновременно из нескольких потоков, если у вызовов разные контексты
+     *
+     * @param[in,out] context Контекст рендеринга
+     * @param[in] scene Сцена
+     * @param[in] camera_id ID камеры в сцене
+     * @param[in] image Изображение
+     * @param[in] flags Флаги отрисовки
+     * @param[out] stats Статистика кадра или nullptr, если она не нужна
+     * @param[in,out] control Отмена и срок кадра или nullptr, если кадр не прерывается
+     *
+     * @return Срендеренное изображение
+     */
+    Image Render(RenderContext& context, const Scene& scene, const Scene::CameraId camera_id,
+                 Image&& image, const RenderFlags flags = DRAW_FACETS,
+                 RenderStats* stats = nullptr, RenderControl* control = nullptr) const;
+
+    /**
+     * @brief Рендеринг нескольких камер
+     *
+     * Рендерит сцену через каждую из переданных камер в изображение с тем же индексом. Матрицы
+     * объектов в координатах сцены, их ограничивающие сферы, порядок отрисовки экземпляров и
+     * список источников света вычисляются один раз для всех камер, сами камеры отрисовываются
+     * параллельно в ThreadPool. Требуется, чтобы количество камер и изображений совпадало
+     *
+     * @param[in] scene Сцена
+     * @param[in] camera_ids ID камер в сцене
+     * @param[in] images Изображения
+     * @param[in] flags Флаги отрисовки
+     * @param[out] stats Статистика кадров в порядке камер или пустой span, если она не нужна
+     * @param[in,out] control Отмена и срок, общие для всех камер, или nullptr, если кадры не
+     * прерываются. В control->status записывается результат
+     *
+     * @return Срендеренные изображения в порядке камер. Если рендеринг прерван, изображения
+     * нарисованы частично
+     *
+     * @note Использует внутренние контексты рендерера, поэтому не должен вызываться одновременно
+     * из нескольких потоков
+     */
+    std::vector<Image> Render(const Scene& scene, std::span<const Scene::CameraId> camera_ids,
+                              std::vector<Image>&& images, const RenderFlags flags = DRAW_FACETS,
+                              std::span<RenderStats> stats = {}, RenderControl* control = nullptr);
+
+    /**
+     * @brief Рендеринг нескольких камер с переданными контекстами
+     *
+     * Аналогичен рендерингу нескольких камер без контекстов, камера i использует контекст i.
+     * Требуется, чтобы контекстов было не меньше, чем камер, а статистика либо не запрашивалась,
+     * либо ее было столько же, сколько камер
+     *
+     * @param[in,out] contexts Контексты рендеринга
+     * @param[in] scene Сцена
+     * @param[in] camera_ids ID камер в сцене
+     * @param[in] images Изображения
+     * @param[in] flags Флаги отрисовки
+     * @param[out] stats Статистика кадров в порядке камер или пустой span, если она не нужна
+     * @param[in,out] control Отмена и срок, общие для всех камер, или nullptr, если кадры не
+     * прерываются
+     *
+     * @return Срендеренные изображения в порядке камер
+     */
+    std::vector<Image> Render(std::span<RenderContext> contexts, const Scene& scene,
+                              std::span<const Scene::CameraId> camera_ids,
+                              std::vector<Image>&& images, const RenderFlags flags = DRAW_FACETS,
+                              std::span<RenderStats> stats = {},
+                              RenderControl* control = nullptr) const;
+
+    /**
+     * @brief Память рендерера
+     *
+     * Учитывает буферы внутренних контекстов. Память переданных в Render контекстов и изображений
+     * учитывается вызывающим. Не должен вызываться одновременно с Render
+     *
+     * @return Память рендерера
+     */
+    MemoryUsage GetMemoryUsage() const;
 
 private:
     /**
-     * @brief Подготовка внутренних параметров
+     * Количество граней между проверками отмены и срока кадра
+     */
+    static constexpr size_t kTrianglesPerControlCheck = 64;
+
+    /**
+     * Общие для всех камер данные сцены
+     */
+    struct SceneParameters {
+        std::vector<Matrix> world_matrices;  // матрицы объектов в координатах сцены
+        std::vector<size_t> draw_order;      // порядок отрисовки объектов
+        std::vector<Vector4> object_bounds;  // ограничивающие сферы объектов: центр и радиус
+        std::vector<LightSource> lights;     // источники света в координатах сцены
+    };
+
+    /**
+     * Сбор статистики кадра. Счетчики пикселей обновляются задачами растеризации из разных
+     * потоков, поэтому хранятся отдельно от RenderStats
+     */
+    struct StatsCollector {
+        RenderStats* stats{nullptr};
+        std::atomic<uint64_t> pixels_tested{0};
+        std::atomic<uint64_t> pixels_passed_depth{0};
+        std::atomic<uint64_t> pixels_shaded{0};
+        std::atomic<uint64_t> shade_samples{0};     // пиксели, закраска которых замерялась
+        std::atomic<int64_t> shade_nanoseconds{0};  // суммарное время замеренной закраски
+    };
+
+    /**
+     * Общие данные для процесса рендеринга кадра
+     */
+    struct Parameters {
+        size_t width{0};
+        size_t height{0};
+        float x_scale{0};
+        float y_scale{0};
+        Matrix camera_to_clip;
+        Vector4 frustum_planes[5];
+        std::span<const LightSource> lights;  // источники света в пространстве камеры
+        Matrix scene_to_camera;
+        RenderFlags flags{0};
+        float* z_buffer{nullptr};
+        uint32_t* heat_buffer{nullptr};  // nullptr, если тепловая карта не строится
+        StatsCollector* stats{nullptr};  // nullptr, если статистика не собирается
+        RenderControl* control{nullptr};  // nullptr, если кадр не прерывается
+    };
+
+    /**
+     * Общие данные для процесса отрисовки треугольника
+     */
+    struct DrawParameters {
+        Vector inv_w;         // 1/A.w, 1/B.w, 1/C.w
+        Point vertices[3];    // вершины в clip space
+        MaterialId material;  // материал грани
+    };
+
+    /**
+     * @brief Подготовка общих данных сцены
+     *
+     * @param[in] scene Сцена
+     *
+     * @return Данные, не зависящие от камеры
+     */
+    SceneParameters PrepareScene(const Scene& scene) const;
+
+    /**
+     * @brief Рендеринг одной камеры
+     *
+     * Рендерит сцену через камеру в изображение, используя заранее подготовленные данные сцены.
+     * Требуется, чтобы размеры изображения были больше 0
+     *
+     * @param[in,out] context Контекст рендеринга
+     * @param[in] scene Сцена
+     * @param[in] scene_parameters Данные сцены, подготовленные PrepareScene
+     * @param[in] camera_id ID камеры в сцене
+     * @param[out] image Изображение
+     * @param[in] flags Флаги отрисовки
+     * @param[out] stats Статистика кадра или nullptr
+     * @param[in,out] control Управление кадром или nullptr
+     */
+    void RenderView(RenderContext& context, const Scene& scene,
+                    const SceneParameters& scene_parameters, const Scene::CameraId camera_id,
+                    Image& image, const RenderFlags flags, RenderStats* stats,
+                    RenderControl* control) const;
+
+    /**
+     * @brief Подготовка параметров кадра
      *
-     * Подготавливает внутреннее состояние для отрисовки нового кадра
+     * Вычисляет параметры проекции камеры. Буфер глубины и источники света не подготавливаются,
+     * см. Renderer::PrepareDepthBuffer и Renderer::PrepareLights
      *
+     * @param[in] scene Сцена
+     * @param[in] camera_id ID камеры в сцене
+     * @param[in] width Ширина выходного изображения, должна быть больше 0
+     * @param[in] height Высота выходного изображения, должна быть больше 0
+     * @param[in] flags Флаги отрисовки
+     *
+     * @return Параметры кадра
+     */
+    Parameters PrepareFrame(const Scene& scene, const Scene::CameraId camera_id,
+                            const size_t width, const size_t height,
+                            const RenderFlags flags) const;
+
+    /**
+     * @brief Подготовка параметров проекции
+     *
+     * @param[out] parameters Параметры кадра
      * @param[in] width Ширина выходного изображения, должна быть больше 0
      * @param[in] height Высота выходного изображения, должна быть больше 0
      * @param[in] focal_length Расстояние от камеры до экрана
      * @param[in] fov_x Горизонтальное поле зрения в градусах
      */
-    void UpdateInternalState(const size_t width, const size_t height, const float focal_length,
-                             const float fov_x);
+    void UpdateInternalState(Parameters& parameters, const size_t width, const size_t height,
+                             const float focal_length, const float fov_x) const;
+
+    /**
+     * @brief Подготовка источников света кадра
+     *
+     * Переводит общие источники света сцены в пространство камеры кадра и прописывает их в
+     * параметры кадра. Направления источников нормируются
+     *
+     * @param[in] scene_parameters Данные сцены, подготовленные PrepareScene
+     * @param[in,out] parameters Параметры кадра
+     * @param[out] lights Хранилище источников света кадра, должно существовать до конца отрисовки
+     */
+    void PrepareLights(const SceneParameters& scene_parameters, Parameters& parameters,
+                       std::vector<LightSource>& lights) const;
+
+    /**
+     * @brief Подготовка буфера глубины
+     *
+     * Выделяет при необходимости буфер глубины контекста под размер кадра, заполняет его
+     * бесконечностью и прописывает в параметры кадра. Если в флагах кадра включена тепловая
+     * карта, так же подготавливается буфер ее значений, заполняемый нулями
+     *
+     * @param[in,out] context Контекст рендеринга
+     * @param[in,out] parameters Параметры кадра
+     */
+    void PrepareDepthBuffer(RenderContext& context, Parameters& parameters) const;
+
+    /**
+     * @brief Вывод тепловой карты
+     *
+     * Если в кадре строится тепловая карта, заменяет изображение ее цветами
+     *
+     * @param[in] parameters Параметры кадра
+     * @param[out] image Изображение
+     */
+    void ResolveHeatmap(const Parameters& parameters, Image& image) const;
+
+    /**
+     * @brief Геометрическая стадия кадра
+     *
+     * Переводит грани сцены в пространство камеры, отбрасывает грани, обращенные от камеры, и
+     * обрезает оставшиеся по пирамиде зрения. Объекты, ограничивающая сфера которых целиком лежит
+     * вне пирамиды зрения, отбрасываются без обработки граней. Каждый получившийся треугольник
+     * передается в consumer в порядке отрисовки. Если в параметрах кадра задан сбор статистики,
+     * заполняет счетчики граней и объектов и время стадий, считая время consumer временем
+     * растеризации. Время перевода и обрезки оценивается по выборке граней. Если в параметрах
+     * кадра задано управление, каждые kTrianglesPerControlCheck граней проверяются отмена и срок
+     * кадра, и при остановке обработка прекращается
+     *
+     * @param[in] parameters Параметры кадра
+     * @param[in] scene Сцена
+     * @param[in] scene_parameters Данные сцены, подготовленные PrepareScene
+     * @param[in] consumer Обработчик треугольников, вызывается как consumer(const Triangle&)
+     */
+    template <typename Consumer>
+    void ProcessGeometry(const Parameters& parameters, const Scene& scene,
+                         const SceneParameters& scene_parameters, Consumer&& consumer) const;
+
+    /**
+     * @brief Сохранение результата геометрической стадии
+     *
+     * Выполняет Renderer::ProcessGeometry и дописывает получившиеся треугольники в triangles
+     *
+     * @param[in] parameters Параметры кадра
+     * @param[in] scene Сцена
+     * @param[in] scene_parameters Данные сцены, подготовленные PrepareScene
+     * @param[out] triangles Треугольники в пространстве камеры в порядке отрисовки
+     */
+    void CollectGeometry(const Parameters& parameters, const Scene& scene,
+                         const SceneParameters& scene_parameters,
+                         std::vector<Triangle>& triangles) const;
 
     /**
      * @brief Рисование отрезка
      *
      * Рисует отрезок от точки start до end на image с учетом буффера глубины
      *
+     * @param[in] parameters Параметры кадра
      * @param[out] image Изображение
      * @param[in] start Начало отрезка
      * @param[in] end Конец отрезка
      */
-    void DrawLine(Image& image, const Point& start, const Point& end);
+    void DrawLine(const Parameters& parameters, Image& image, const Point& start,
+                  const Point& end) const;
 
     /**
      * @brief Рисование треугольника
      *
      * Рисует переданный треугольник с учетом буффера глубины. Треугольник передается в camera space
      *
+     * @param[in] parameters Параметры кадра
      * @param[out] image Изображение
      * @param[in] triangle Треугольник
      */
-    void DrawTriangle(Image& image, const Triangle& triangle);
+    void DrawTriangle(const Parameters& parameters, Image& image, const Triangle& triangle) const;
 
     /**
      * @brief Растеризация треугольника
      *
      * Растеризует переданный треугольник в прямоугольнике от точки (x0, y0) до (x1, y1).
-     * Треугольник передается в camera space
+     * Треугольник передается в camera space. При kCollectStats счетчики пикселей и время закраски
+     * добавляются в Parameters::stats, при kHeatmap значения пикселей добавляются в
+     * Parameters::heat_buffer. Без этих параметров соответствующий код не компилируется
      *
+     * @param[in] parameters Параметры кадра
+     * @param[in] draw_parameters Параметры треугольника
      * @param[out] image Изображение
      * @param[in] triangle Треугольник
      * @param[in] x0 x0
@@ -113,8 +460,11 @@ private:
      * @param[in] x1 x1
      * @param[in] y1 y1
      */
-    void TriangleRasterizationTask(Image& image, const Triangle& triangle, const int32_t x0,
-                                   const int32_t y0, const int32_t x1, const int32_t y1);
+    template <bool kCollectStats, bool kHeatmap>
+    void TriangleRasterizationTask(const Parameters& parameters,
+                                   const DrawParameters& draw_parameters, Image& image,
+                                   const Triangle& triangle, const int32_t x0, const int32_t y0,
+                                   const int32_t x1, const int32_t y1) const;
 
     /**
      * @brief Обрезка треугольника относительно пирамиды зрения
@@ -126,41 +476,22 @@ private:
      * треугольника результата данные не изменяются. Гарантируется, что функция модифицирует не
      * больше 63 первых значений
      *
+     * @param[in] parameters Параметры кадра
      * @param[in] triangle Треугольник для обрезки
      * @param[out] result Массив с результатом работы
      * @param[out] start Индекс начала результата в массиве
      *
      * @return Количество треугольников в результате
      */
-    size_t ClipTriangle(const Triangle& triangle, Triangle* result, size_t* start);
+    size_t ClipTriangle(const Parameters& parameters, const Triangle& triangle, Triangle* result,
+                        size_t* start) const;
 
-    /**
-     * Общие данные для процесса рендеринга
-     */
-    struct Parameters {
-        size_t width{0};
-        float x_scale{0};
-        float y_scale{0};
-        Matrix camera_to_clip;
-        Vector4 frustum_planes[5];
-        Scene::LightConstIterator light_begin;
-        Scene::LightConstIterator light_end;
-        Matrix scene_to_camera;
-    };
-
-    /**
-     * Общие данные для процесса отрисовки треугольника
-     */
-    struct DrawParameters {
-        Vector inv_w;         // 1/A.w, 1/B.w, 1/C.w
-        Point vertices[3];    // вершины в clip space
-        MaterialId material;  // материал грани
-    };
+    friend class RenderPipeline;
 
-    Parameters parameters_;
-    DrawParameters draw_parameters_;
-    RenderFlags flags_;
-    std::vector<float> z_buffer_;
+    ThreadPool* thread_pool_;
+    const ResourcesManager* resources_manager_;
+    RenderContext context_;
+    std::vector<RenderContext> batch_contexts_;
 };
 
 };  // namespace renderer
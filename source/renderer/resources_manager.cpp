@@ -1,5 +1,8 @@
 #include "renderer/resources_manager.hpp"
 
+#include <atomic>
+#include <limits>
+
 #include "stb_image.h"
 
 namespace renderer {
@@ -16,9 +19,15 @@ MaterialId ResourcesManager::PushMaterial(const Material& material) {
 }
 
 TextureId ResourcesManager::PushTexture(const std::string& path) {
+    TextureId id = textures_.size();
     for (TextureId i = 0; i < textures_.size(); ++i) {
         if (textures_[i].path == path) {
-            return i;
+            textures_[i].last_use = NextRequestStamp();
+            if (not IsTextureEvicted(i)) {
+                return i;
+            }
+            id = i;
+            break;
         }
     }
     int width, height, nr_channels;
@@ -26,9 +35,15 @@ TextureId ResourcesManager::PushTexture(const std::string& path) {
     if (data == nullptr) {
         return 0;
     }
+    // текстуры вытесняются только после успешного декодирования, под его фактический размер
+    if (not ReserveTextureBytes(static_cast<size_t>(width) * height * sizeof(Image::Pixel), id)) {
+        stbi_image_free(data);
+        return 0;
+    }
     Texture new_texture{
         .path{path},
-        .image{Width{static_cast<size_t>(width)}, Height{static_cast<size_t>(height)}}};
+        .image{Width{static_cast<size_t>(width)}, Height{static_cast<size_t>(height)}},
+        .last_use = NextRequestStamp()};
     for (size_t y = 0; y < height; ++y) {
         for (size_t x = 0; x < width; ++x) {
             size_t index = (x + y * width) * 3;
@@ -38,12 +53,31 @@ TextureId ResourcesManager::PushTexture(const std::string& path) {
             new_texture.image.AccessPixel(x, y) = {r, g, b};
         }
     }
-    TextureId id = textures_.size();
-    textures_.push_back(std::move(new_texture));
+    texture_bytes_ += new_texture.image.GetMemoryBytes();
+    if (id == textures_.size()) {
+        textures_.push_back(std::move(new_texture));
+    } else {
+        textures_[id] = std::move(new_texture);
+    }
     stbi_image_free(data);
     return id;
 }
 
+TextureId ResourcesManager::PushTexture(Image&& image) {
+    {
+        assert((image.GetWidth() != 0 and image.GetHeight() != 0) and
+               "PushTexture: размеры изображения должны быть больше 0");
+    }
+    const size_t bytes = image.GetMemoryBytes();
+    TextureId id = textures_.size();
+    if (not ReserveTextureBytes(bytes, id)) {
+        return 0;
+    }
+    texture_bytes_ += bytes;
+    textures_.push_back(Texture{.path{}, .image{std::move(image)}});
+    return id;
+}
+
 Material& ResourcesManager::AccessMaterial(const MaterialId id) {
     {
         assert(HasMaterial(id) and "AccessMaterial: материал должен быть в хранилище");
@@ -62,7 +96,8 @@ Color ResourcesManager::GetPixelByUV(const TextureId id, const Point2& uv_coordi
     {
         assert(HasTexture(id) and "GetPixelByUV: текстура должна быть в хранилище");
     }
-    const Texture& texture = textures_[id];
+    // вытесненная текстура отображается как текстура по-умолчанию
+    const Texture& texture = IsTextureEvicted(id) ? textures_[0] : textures_[id];
     size_t width = texture.image.GetWidth();
     size_t heigh = texture.image.GetHeight();
     int64_t x = uv_coordinates.x * width;
@@ -81,6 +116,13 @@ Color ResourcesManager::GetPixelByUV(const TextureId id, const Point2& uv_coordi
     return Image::Pixel::ToColor(texture.image.AccessPixel(x, y));
 }
 
+const std::string& ResourcesManager::GetTexturePath(const TextureId id) const {
+    {
+        assert(HasTexture(id) and "GetTexturePath: текстура должна быть в хранилище");
+    }
+    return textures_[id].path;
+}
+
 bool ResourcesManager::HasMaterial(const MaterialId id) const {
     return (0 <= id and id < materials_.size());
 }
@@ -89,10 +131,98 @@ bool ResourcesManager::HasTexture(const TextureId id) const {
     return (0 <= id and id < textures_.size());
 }
 
+bool ResourcesManager::IsTextureEvicted(const TextureId id) const {
+    {
+        assert(HasTexture(id) and "IsTextureEvicted: текстура должна быть в хранилище");
+    }
+    return textures_[id].image.GetWidth() == 0;
+}
+
+void ResourcesManager::MarkTextureUsed(const TextureId id) const {
+    {
+        assert(HasTexture(id) and "MarkTextureUsed: текстура должна быть в хранилище");
+    }
+    // отрисовка отмечается текущим значением счетчика, который меняет только PushTexture, поэтому
+    // запись нужна только первой грани с этой текстурой после очередного запроса
+    std::atomic_ref<uint64_t> last_use{textures_[id].last_use};
+    if (last_use.load(std::memory_order_relaxed) != use_clock_) {
+        last_use.store(use_clock_, std::memory_order_relaxed);
+    }
+}
+
+void ResourcesManager::SetTextureBudget(const size_t bytes, const BudgetPolicy policy) {
+    texture_budget_ = bytes;
+    budget_policy_ = policy;
+}
+
+size_t ResourcesManager::GetTextureBudget() const {
+    return texture_budget_;
+}
+
+size_t ResourcesManager::GetTextureBytes() const {
+    return texture_bytes_;
+}
+
+MemoryUsage ResourcesManager::GetMemoryUsage() const {
+    MemoryUsage usage{.subsystem = "ResourcesManager"};
+    usage.AddPart("materials", materials_.capacity() * sizeof(Material));
+    size_t records_bytes = textures_.capacity() * sizeof(Texture);
+    for (const Texture& texture : textures_) {
+        records_bytes += texture.path.capacity();
+    }
+    usage.AddPart("textures", texture_bytes_);
+    usage.AddPart("texture records", records_bytes);
+    usage.assets.reserve(textures_.size());
+    for (TextureId id = 0; id < textures_.size(); ++id) {
+        const Texture& texture = textures_[id];
+        usage.assets.push_back(MemoryUsage::Entry{
+            .name = texture.path.empty() ? "texture " + std::to_string(id) : texture.path,
+            .bytes = texture.image.GetMemoryBytes()});
+    }
+    return usage;
+}
+
+bool ResourcesManager::ReserveTextureBytes(const size_t bytes, const TextureId keep) {
+    if (texture_budget_ == kNoMemoryBudget) {
+        return true;
+    }
+    if (bytes > texture_budget_) {
+        return false;
+    }
+    while (texture_bytes_ > texture_budget_ - bytes) {
+        if (budget_policy_ == FAIL) {
+            return false;
+        }
+        // вытесняется текстура из файла, дольше всего не использовавшаяся
+        TextureId victim = 0;
+        uint64_t oldest_use = std::numeric_limits<uint64_t>::max();
+        for (TextureId i = 1; i < textures_.size(); ++i) {
+            const Texture& texture = textures_[i];
+            if (i != keep and not texture.path.empty() and not IsTextureEvicted(i) and
+                texture.last_use < oldest_use) {
+                victim = i;
+                oldest_use = texture.last_use;
+            }
+        }
+        if (victim == 0) {
+            return false;
+        }
+        texture_bytes_ -= textures_[victim].image.GetMemoryBytes();
+        textures_[victim].image = Image{Width{0}, Height{0}};
+    }
+    return true;
+}
+
+uint64_t ResourcesManager::NextRequestStamp() {
+    use_clock_ += 2;
+    return use_clock_ - 1;
+}
+
 ResourcesManager::ResourcesManager() {
     materials_.emplace_back();
     Texture default_texture{.path{""}, .image{Width{1}, Height{1}}};
     default_texture.image.AccessPixel(0, 0) = {255, 255, 255};
+    texture_bytes_ += default_texture.image.GetMemoryBytes();
     textures_.push_back(std::move(default_texture));
 }
 
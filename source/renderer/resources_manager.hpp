@@ -4,10 +4,12 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "renderer/image.hpp"
+#include "renderer/memory_report.hpp"
 #include "renderer/resources_types.hpp"
 #include "renderer/types.hpp"
 
@@ -16,11 +18,40 @@ namespace renderer {
 /**
  * @brief Менеджер ресурсов
  *
- * Singleton класс, загружающий и хранящий материалы и текстуры. По индексам 0 содержатся материал и
- * текстура по-умолчанию
+ * Класс, загружающий и хранящий материалы и текстуры. По индексам 0 содержатся материал и
+ * текстура по-умолчанию. Кроме глобального объекта, доступного через Get, можно создавать
+ * независимые хранилища и передавать их в Renderer
+ *
+ * Объем текстур можно ограничить (см. ResourcesManager::SetTextureBudget). Текстура, не
+ * помещающаяся в бюджет, не загружается, либо ради нее вытесняются другие текстуры, загруженные
+ * из файлов. Вытесненная текстура сохраняет свой ID и до повторной загрузки через
+ * ResourcesManager::PushTexture отображается как текстура по-умолчанию
  */
 class ResourcesManager {
 public:
+    /**
+     * @brief Поведение при превышении бюджета текстур
+     */
+    enum BudgetPolicy : uint8_t {
+        /**
+         * Текстура не добавляется
+         */
+        FAIL,
+        /**
+         * Вытесняются текстуры из файлов, дольше всего не использовавшиеся: не отрисовывавшиеся
+         * (см. ResourcesManager::MarkTextureUsed) и не запрашивавшиеся через
+         * ResourcesManager::PushTexture. Если их не хватает, текстура не добавляется
+         */
+        EVICT
+    };
+
+    /**
+     * @brief Создание ResourcesManager
+     *
+     * Создает хранилище, содержащее только материал и текстуру по-умолчанию
+     */
+    ResourcesManager();
+
     /**
      * @brief Получение ResourcesManager
      *
@@ -45,13 +76,27 @@ public:
      * @brief Добавление текстуры
      *
      * Загружает текстуру из файла по переданному пути. Возвращает ID добавленой текстуры. Если файл
-     * уже был загружен раньше, возвращает его ID и не производит повторную загрузку. В случае
-     * ошибки возвращает 0 - ID текстуры по-умолчанию
+     * уже был загружен раньше, возвращает его ID и не производит повторную загрузку, а если
+     * текстура была вытеснена - загружает ее заново с тем же ID. В случае ошибки или если
+     * текстура не помещается в бюджет, возвращает 0 - ID текстуры по-умолчанию
      *
      * @return ID добавленной текстуры
      */
     TextureId PushTexture(const std::string& path);
 
+    /**
+     * @brief Добавление текстуры из изображения
+     *
+     * Сохраняет переданное изображение как новую текстуру. Путь такой текстуры пустой, поэтому
+     * она не вытесняется. Если текстура не помещается в бюджет, возвращает 0 - ID текстуры
+     * по-умолчанию. Требуется, чтобы размеры изображения были больше 0
+     *
+     * @param[in] image Изображение
+     *
+     * @return ID добавленной текстуры
+     */
+    TextureId PushTexture(Image&& image);
+
     /**
      * @brief Получение доступа к материалу
      *
@@ -84,6 +129,19 @@ public:
      */
     Color GetPixelByUV(const TextureId id, const Point2& uv_coordinates) const;
 
+    /**
+     * @brief Получение пути текстуры
+     *
+     * Возвращает путь, по которому была загружена текстура с переданным id. Для текстуры
+     * по-умолчанию и текстур, созданных из изображений, возвращается пустая строка. Требуется,
+     * чтобы текстура была в хранилище
+     *
+     * @param[in] id ID текстуры
+     *
+     * @return Путь до файла текстуры
+     */
+    const std::string& GetTexturePath(const TextureId id) const;
+
     /**
      * @brief Проверка наличия материала
      *
@@ -106,6 +164,63 @@ public:
      */
     bool HasTexture(const TextureId id) const;
 
+    /**
+     * @brief Проверка вытеснения текстуры
+     *
+     * Требуется, чтобы текстура была в хранилище
+     *
+     * @param[in] id ID текстуры
+     *
+     * @return Вытеснена ли текстура
+     */
+    bool IsTextureEvicted(const TextureId id) const;
+
+    /**
+     * @brief Отметка использования текстуры
+     *
+     * Вызывается рендерером для текстуры каждой отрисованной грани и обновляет момент
+     * последнего использования, по которому выбираются вытесняемые текстуры. Может вызываться
+     * одновременно из нескольких потоков, но не одновременно с PushTexture. Требуется, чтобы
+     * текстура была в хранилище
+     *
+     * @param[in] id ID текстуры
+     */
+    void MarkTextureUsed(const TextureId id) const;
+
+    /**
+     * @brief Задание бюджета текстур
+     *
+     * Ограничивает суммарный размер пикселей всех текстур. Уже загруженные текстуры при вызове
+     * не вытесняются. Временный буфер декодирования файла в бюджет не входит
+     *
+     * @param[in] bytes Бюджет в байтах или kNoMemoryBudget
+     * @param[in] policy Поведение при превышении бюджета
+     */
+    void SetTextureBudget(const size_t bytes, const BudgetPolicy policy = FAIL);
+
+    /**
+     * @brief Получение бюджета текстур
+     *
+     * @return Бюджет в байтах или kNoMemoryBudget
+     */
+    size_t GetTextureBudget() const;
+
+    /**
+     * @brief Объем текстур
+     *
+     * @return Суммарный размер пикселей текстур в байтах, учитываемый бюджетом
+     */
+    size_t GetTextureBytes() const;
+
+    /**
+     * @brief Память хранилища
+     *
+     * Ресурсами отчета являются текстуры, названные по пути файла
+     *
+     * @return Память хранилища
+     */
+    MemoryUsage GetMemoryUsage() const;
+
     ResourcesManager(const ResourcesManager& other) = delete;
     ResourcesManager(ResourcesManager&& other) = delete;
 
@@ -115,15 +230,33 @@ public:
 private:
     struct Texture {
         std::string path;
-        Image image;
+        Image image;            // пустое, если текстура вытеснена
+        mutable uint64_t last_use = 0;  // момент последнего запроса или отрисовки
     };
 
     /**
-     * @brief Создание ResourcesManager
+     * @brief Освобождение места под bytes байт текстур
+     *
+     * Вытесняет текстуры по правилам бюджета, кроме текстуры keep
+     *
+     * @return Поместятся ли bytes байт в бюджет
      */
-    ResourcesManager();
+    bool ReserveTextureBytes(const size_t bytes, const TextureId keep);
+
+    /**
+     * @brief Момент запроса текстуры через PushTexture
+     *
+     * Отрисовки после запроса отмечаются большим значением, чем сам запрос, а отрисовки до
+     * него - меньшим
+     */
+    uint64_t NextRequestStamp();
+
     std::vector<Material> materials_;
     std::vector<Texture> textures_;
+    size_t texture_bytes_ = 0;
+    size_t texture_budget_ = kNoMemoryBudget;
+    BudgetPolicy budget_policy_ = FAIL;
+    uint64_t use_clock_ = 0;
 };
 
 }  // namespace renderer
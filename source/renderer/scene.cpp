@@ -1,27 +1,415 @@
 #include "renderer/scene.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <string>
+
 namespace renderer {
 
-Scene::ObjectId Scene::PushObject(const Object& object) {
-    ObjectId id = objects_.size();
-    size_t new_object_start = facets_storage_.size();
-    size_t new_object_size = std::distance(object.Begin(), object.End());
-    facets_storage_.reserve(facets_storage_.size() + new_object_size);
-    for (auto it = object.Begin(); it != object.End(); ++it) {
-        facets_storage_.push_back(*it);
-    }
-    objects_.emplace_back(new_object_start, new_object_size);
+namespace {
+
+/**
+ * @brief Копирование диапазона граней в конец другого хранилища
+ *
+ * @return Индекс начала скопированных граней
+ */
+template <class Facet>
+size_t AppendFacets(const std::vector<Facet>& from, const size_t begin, const size_t size,
+                    std::vector<Facet>& to) {
+    const size_t new_begin = to.size();
+    to.insert(to.end(), from.begin() + begin, from.begin() + begin + size);
+    return new_begin;
+}
+
+/**
+ * @brief Удаление элемента плотного массива перестановкой последнего элемента на его место
+ */
+template <class T>
+void SwapRemove(std::vector<T>& elements, const size_t index) {
+    if (index + 1 != elements.size()) {
+        elements[index] = std::move(elements.back());
+    }
+    elements.pop_back();
+}
+
+}  // namespace
+
+Scene::Scene(const StorageFormat format) : format_{format} {
+}
+
+Scene::StorageFormat Scene::GetStorageFormat() const {
+    return format_;
+}
+
+Scene::MeshId Scene::PushMesh(const Object& object) {
+    return PushMesh(object.Facets());
+}
+
+Scene::MeshId Scene::PushMesh(Object&& object) {
+    if (format_ == FULL_PRECISION and facets_storage_.empty()) {
+        if (not FitsFacetsBudget(object.Facets().size())) {
+            return kNoMesh;
+        }
+        facets_storage_ = object.ReleaseFacets();
+        return RegisterAppendedFacets(facets_storage_.size());
+    }
+    MeshId id = PushMesh(object.Facets());
+    if (id != kNoMesh) {
+        object.ReleaseFacets();
+    }
+    return id;
+}
+
+Scene::MeshId Scene::PushMesh(std::span<const Object::FacetType> facets) {
+    if (not FitsFacetsBudget(facets.size())) {
+        return kNoMesh;
+    }
+    if (format_ == COMPACT) {
+        return PushCompactMesh(facets);
+    }
+    ReserveFacets(facets.size());
+    facets_storage_.insert(facets_storage_.end(), facets.begin(), facets.end());
+    return RegisterAppendedFacets(facets.size());
+}
+
+Scene::MeshId Scene::PushMesh(const size_t facets_count,
+                              const std::function<void(std::span<Object::FacetType>)>& fill) {
+    if (not FitsFacetsBudget(facets_count)) {
+        return kNoMesh;
+    }
+    ReserveFacets(facets_count);
+    const size_t begin = facets_storage_.size();
+    facets_storage_.resize(begin + facets_count);
+    fill(std::span<Object::FacetType>{facets_storage_.data() + begin, facets_count});
+    return RegisterAppendedFacets(facets_count);
+}
+
+Scene::ObjectId Scene::PushInstance(const MeshId mesh_id) {
+    {
+        assert(HasMesh(mesh_id) and "PushInstance: сетки с переданным ID не существует");
+    }
+    Mesh& mesh = meshes_[meshes_table_.IndexOf(mesh_id)];
+    ++mesh.instances;
+    ObjectId id = objects_table_.Push();
+    objects_.emplace_back(mesh_id, mesh.begin, mesh.size);
+    hierarchy_changed_ = true;
     return id;
 }
 
+Scene::ObjectId Scene::PushObject(const Object& object) {
+    MeshId mesh_id = PushMesh(object);
+    if (mesh_id == kNoMesh) {
+        return kNoObject;
+    }
+    meshes_[meshes_table_.IndexOf(mesh_id)].owned = true;
+    return PushInstance(mesh_id);
+}
+
+Scene::ObjectId Scene::PushObject(Object&& object) {
+    MeshId mesh_id = PushMesh(std::move(object));
+    if (mesh_id == kNoMesh) {
+        return kNoObject;
+    }
+    meshes_[meshes_table_.IndexOf(mesh_id)].owned = true;
+    return PushInstance(mesh_id);
+}
+
+void Scene::RemoveMesh(const MeshId id) {
+    {
+        assert(HasMesh(id) and "RemoveMesh: сетки с переданным ID не существует");
+        assert((meshes_[meshes_table_.IndexOf(id)].instances == 0) and
+               "RemoveMesh: у сетки не должно быть экземпляров");
+    }
+    const size_t index = meshes_table_.Remove(id);
+    const Mesh& removed = meshes_[index];
+    garbage_facets_ += removed.size;
+    if (compaction_.active and removed.compacted_begin != kNotCompacted) {
+        compaction_.garbage += removed.size;
+    }
+    SwapRemove(meshes_, index);
+    // на место удаленной сетки могла встать еще не скопированная сетка из конца массива
+    if (compaction_.active and index < compaction_.cursor and index < meshes_.size() and
+        meshes_[index].compacted_begin == kNotCompacted) {
+        CompactMesh(meshes_[index]);
+    }
+    compaction_.cursor = std::min(compaction_.cursor, meshes_.size());
+}
+
+void Scene::RemoveObject(const ObjectId id) {
+    {
+        assert(HasObject(id) and "RemoveObject: объекта с переданным ID не существует");
+    }
+    SceneObject& object = objects_[objects_table_.IndexOf(id)];
+    if (object.children_count_ > 0) {
+        for (SceneObject& child : objects_) {
+            if (child.parent_ == id) {
+                child.parent_ = SceneObject::kNoParent;
+                child.dirty_ = true;
+            }
+        }
+    }
+    if (object.parent_ != SceneObject::kNoParent) {
+        --objects_[ParentIndex(object)].children_count_;
+    }
+    const MeshId mesh_id = object.mesh_;
+    Mesh& mesh = meshes_[meshes_table_.IndexOf(mesh_id)];
+    --mesh.instances;
+    const bool remove_mesh = mesh.owned and mesh.instances == 0;
+
+    SwapRemove(objects_, objects_table_.Remove(id));
+    hierarchy_changed_ = true;
+    if (remove_mesh) {
+        RemoveMesh(mesh_id);
+    }
+}
+
+void Scene::RemoveCamera(const CameraId id) {
+    {
+        assert(HasCamera(id) and "RemoveCamera: камеры с переданным ID не существует");
+    }
+    SwapRemove(cameras_, cameras_table_.Remove(id));
+}
+
+void Scene::RemoveLight(const LightId id) {
+    {
+        assert(HasLight(id) and "RemoveLight: источника света с переданным ID не существует");
+    }
+    SwapRemove(light_sources_, lights_table_.Remove(id));
+}
+
+size_t Scene::GarbageFacets() const {
+    return garbage_facets_;
+}
+
+void Scene::SetFacetsBudget(const size_t bytes) {
+    facets_budget_ = bytes;
+}
+
+size_t Scene::GetFacetsBudget() const {
+    return facets_budget_;
+}
+
+size_t Scene::GetFacetsBytes() const {
+    if (format_ == COMPACT) {
+        return compact_facets_storage_.size() * sizeof(CompactTriangle);
+    }
+    return facets_storage_.size() * sizeof(Object::FacetType);
+}
+
+MemoryUsage Scene::GetMemoryUsage() const {
+    MemoryUsage usage{.subsystem = "Scene"};
+    usage.AddPart("facets", facets_storage_.capacity() * sizeof(Object::FacetType));
+    usage.AddPart("compact facets", compact_facets_storage_.capacity() * sizeof(CompactTriangle));
+    usage.AddPart("compaction", compaction_.facets.capacity() * sizeof(Object::FacetType) +
+                                    compaction_.compact_facets.capacity() *
+                                        sizeof(CompactTriangle));
+    usage.AddPart("meshes", meshes_.capacity() * sizeof(Mesh) + meshes_table_.GetMemoryBytes());
+    size_t hierarchy_bytes = hierarchy_levels_.capacity() * sizeof(std::vector<size_t>);
+    for (const std::vector<size_t>& level : hierarchy_levels_) {
+        hierarchy_bytes += level.capacity() * sizeof(size_t);
+    }
+    usage.AddPart("objects", objects_.capacity() * sizeof(SceneObject) +
+                                 objects_table_.GetMemoryBytes() + hierarchy_bytes);
+    usage.AddPart("cameras", cameras_.capacity() * sizeof(Camera) +
+                                 cameras_table_.GetMemoryBytes());
+    usage.AddPart("lights", light_sources_.capacity() * sizeof(LightSource) +
+                                lights_table_.GetMemoryBytes());
+
+    const size_t facet_bytes =
+        (format_ == COMPACT) ? sizeof(CompactTriangle) : sizeof(Object::FacetType);
+    usage.assets.reserve(meshes_.size() + 1);
+    for (size_t i = 0; i < meshes_.size(); ++i) {
+        usage.assets.push_back(MemoryUsage::Entry{
+            .name = "mesh " + std::to_string(meshes_table_.HandleOf(i)),
+            .bytes = meshes_[i].size * facet_bytes});
+    }
+    if (garbage_facets_ > 0) {
+        usage.assets.push_back(MemoryUsage::Entry{.name = "removed meshes",
+                                                  .bytes = garbage_facets_ * facet_bytes});
+    }
+    return usage;
+}
+
+bool Scene::CompactStorage(const size_t max_facets) {
+    if (not compaction_.active) {
+        if (garbage_facets_ == 0) {
+            return false;
+        }
+        compaction_.active = true;
+        compaction_.cursor = 0;
+        compaction_.garbage = 0;
+    }
+    size_t copied = 0;
+    while (compaction_.cursor < meshes_.size() and (copied == 0 or copied < max_facets)) {
+        Mesh& mesh = meshes_[compaction_.cursor];
+        if (mesh.compacted_begin == kNotCompacted) {
+            CompactMesh(mesh);
+            copied += std::max<size_t>(mesh.size, 1);
+        }
+        ++compaction_.cursor;
+    }
+    return compaction_.cursor == meshes_.size();
+}
+
+void Scene::ApplyCompaction() {
+    {
+        assert((compaction_.active and compaction_.cursor == meshes_.size()) and
+               "ApplyCompaction: уплотнение должно быть завершено");
+    }
+    for (Mesh& mesh : meshes_) {
+        mesh.begin = mesh.compacted_begin;
+        mesh.compacted_begin = kNotCompacted;
+    }
+    for (SceneObject& object : objects_) {
+        object.begin_ = meshes_[meshes_table_.IndexOf(object.mesh_)].begin;
+    }
+    if (format_ == COMPACT) {
+        compact_facets_storage_ = std::move(compaction_.compact_facets);
+    } else {
+        facets_storage_ = std::move(compaction_.facets);
+    }
+    garbage_facets_ = compaction_.garbage;
+    compaction_ = Compaction{};
+}
+
+void Scene::CompactMesh(Mesh& mesh) {
+    if (format_ == COMPACT) {
+        mesh.compacted_begin = AppendFacets(compact_facets_storage_, mesh.begin, mesh.size,
+                                            compaction_.compact_facets);
+    } else {
+        mesh.compacted_begin =
+            AppendFacets(facets_storage_, mesh.begin, mesh.size, compaction_.facets);
+    }
+}
+
+size_t Scene::ParentIndex(const SceneObject& object) const {
+    return objects_table_.IndexOf(object.parent_);
+}
+
+void Scene::SetParent(const ObjectId child_id, const ObjectId parent_id) {
+    {
+        assert(HasObject(child_id) and "SetParent: объекта с переданным ID не существует");
+        assert((parent_id == SceneObject::kNoParent or HasObject(parent_id)) and
+               "SetParent: родителя с переданным ID не существует");
+    }
+    for (ObjectId ancestor = parent_id; ancestor != SceneObject::kNoParent;
+         ancestor = objects_[objects_table_.IndexOf(ancestor)].parent_) {
+        {
+            assert((ancestor != child_id) and "SetParent: иерархия не должна содержать циклов");
+        }
+    }
+    SceneObject& child = objects_[objects_table_.IndexOf(child_id)];
+    if (child.parent_ != SceneObject::kNoParent) {
+        --objects_[ParentIndex(child)].children_count_;
+    }
+    if (parent_id != SceneObject::kNoParent) {
+        ++objects_[objects_table_.IndexOf(parent_id)].children_count_;
+    }
+    child.parent_ = parent_id;
+    child.dirty_ = true;
+    hierarchy_changed_ = true;
+}
+
+void Scene::UpdateTransforms(ThreadPool& thread_pool) {
+    if (hierarchy_changed_) {
+        RebuildHierarchyLevels();
+    }
+    // updated[i] - пересчитана ли матрица объекта i, тогда пересчитываются и его потомки
+    std::vector<uint8_t> updated(objects_.size(), 0);
+    auto update_range = [this, &updated](const std::vector<size_t>& level, const size_t begin,
+                                         const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            SceneObject& object = objects_[level[i]];
+            const bool parent_updated = (object.parent_ != SceneObject::kNoParent) and
+                                        (updated[ParentIndex(object)] != 0);
+            if (not object.dirty_ and not parent_updated and not hierarchy_changed_) {
+                continue;
+            }
+            if (object.dirty_) {
+                object.local_matrix_ = object.ComputeObjectMatrix();
+                object.dirty_ = false;
+            }
+            if (object.parent_ == SceneObject::kNoParent) {
+                object.world_matrix_ = object.local_matrix_;
+            } else {
+                const Matrix& parent_matrix = objects_[ParentIndex(object)].world_matrix_;
+                object.world_matrix_ = parent_matrix * object.local_matrix_;
+            }
+            updated[level[i]] = 1;
+        }
+    };
+
+    constexpr size_t kObjectsPerTask = 1024;
+    for (const std::vector<size_t>& level : hierarchy_levels_) {
+        thread_pool.ParallelFor(0, level.size(), kObjectsPerTask,
+                                [&update_range, &level](const size_t begin, const size_t end) {
+                                    update_range(level, begin, end);
+                                });
+    }
+    hierarchy_changed_ = false;
+}
+
+Matrix Scene::GetWorldMatrix(const SceneObject& object) const {
+    if (IsWorldMatrixCached(object)) {
+        return object.world_matrix_;
+    }
+    if (object.parent_ == SceneObject::kNoParent) {
+        return object.GetObjectMatrix();
+    }
+    return GetWorldMatrix(objects_[ParentIndex(object)]) * object.GetObjectMatrix();
+}
+
+bool Scene::IsWorldMatrixCached(const SceneObject& object) const {
+    if (hierarchy_changed_) {
+        return false;
+    }
+    for (const SceneObject* current = &object; current != nullptr;) {
+        if (current->dirty_) {
+            return false;
+        }
+        current = (current->parent_ == SceneObject::kNoParent) ? nullptr
+                                                                : &objects_[ParentIndex(*current)];
+    }
+    return true;
+}
+
+void Scene::RebuildHierarchyLevels() {
+    constexpr size_t kUnknownDepth = std::numeric_limits<size_t>::max();
+    std::vector<size_t> depth(objects_.size(), kUnknownDepth);
+    std::vector<size_t> chain;
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        // поднимаемся до предка с известной глубиной и проставляем глубины на обратном пути
+        size_t current = i;
+        while (current != SceneObject::kNoParent and depth[current] == kUnknownDepth) {
+            chain.push_back(current);
+            const SceneObject& object = objects_[current];
+            current = (object.parent_ == SceneObject::kNoParent) ? SceneObject::kNoParent
+                                                                 : ParentIndex(object);
+        }
+        size_t current_depth = (current == SceneObject::kNoParent) ? 0 : depth[current] + 1;
+        while (not chain.empty()) {
+            depth[chain.back()] = current_depth;
+            ++current_depth;
+            chain.pop_back();
+        }
+    }
+    hierarchy_levels_.clear();
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        if (hierarchy_levels_.size() <= depth[i]) {
+            hierarchy_levels_.resize(depth[i] + 1);
+        }
+        hierarchy_levels_[depth[i]].push_back(i);
+    }
+}
+
 Scene::CameraId Scene::PushCamera(const Camera& camera) {
-    CameraId id = cameras_.size();
+    CameraId id = cameras_table_.Push();
     cameras_.push_back(camera);
     return id;
 }
 
 Scene::LightId Scene::PushLight(const LightSource& light_source) {
-    LightId id = light_sources_.size();
+    LightId id = lights_table_.Push();
     light_sources_.push_back(light_source);
     return id;
 }
@@ -62,54 +450,132 @@ Camera& Scene::AccessCamera(const CameraId id) {
     {
         assert(HasCamera(id) and "GetCamera: камеры с переданным ID не существует");
     }
-    return cameras_[id];
+    return cameras_[cameras_table_.IndexOf(id)];
 }
 
 const Camera& Scene::AccessCamera(const CameraId id) const {
     {
         assert(HasCamera(id) and "GetCamera: камеры с переданным ID не существует");
     }
-    return cameras_[id];
+    return cameras_[cameras_table_.IndexOf(id)];
 }
 
 SceneObject& Scene::AccessObject(const ObjectId id) {
     {
         assert(HasObject(id) and "AccessObject: объекта с переданным ID не существует");
     }
-    return objects_[id];
+    return objects_[objects_table_.IndexOf(id)];
 }
 
 const SceneObject& Scene::AccessObject(const ObjectId id) const {
     {
         assert(HasObject(id) and "AccessObject: объекта с переданным ID не существует");
     }
-    return objects_[id];
+    return objects_[objects_table_.IndexOf(id)];
 }
 
 LightSource& Scene::AccessLight(const LightId id) {
     {
         assert(HasLight(id) and "AccessLight: источника света с переданным ID не существует");
     }
-    return light_sources_[id];
+    return light_sources_[lights_table_.IndexOf(id)];
 }
 
 const LightSource& Scene::AccessLight(const LightId id) const {
     {
         assert(HasLight(id) and "AccessLight: источника света с переданным ID не существует");
     }
-    return light_sources_[id];
+    return light_sources_[lights_table_.IndexOf(id)];
+}
+
+bool Scene::HasMesh(const MeshId id) const {
+    return meshes_table_.Contains(id);
+}
+
+size_t Scene::MeshesCount() const {
+    return meshes_.size();
+}
+
+size_t Scene::MeshIndex(const MeshId id) const {
+    {
+        assert(HasMesh(id) and "MeshIndex: сетки с переданным ID не существует");
+    }
+    return meshes_table_.IndexOf(id);
 }
 
 bool Scene::HasObject(const ObjectId id) const {
-    return (0 <= id and id < objects_.size());
+    return objects_table_.Contains(id);
 }
 
 bool Scene::HasCamera(const CameraId id) const {
-    return (0 <= id and id < cameras_.size());
+    return cameras_table_.Contains(id);
 }
 
 bool Scene::HasLight(const LightId id) const {
-    return (0 <= id and id < light_sources_.size());
+    return lights_table_.Contains(id);
+}
+
+Scene::MeshId Scene::RegisterAppendedFacets(const size_t facets_count) {
+    {
+        assert((facets_count <= facets_storage_.size()) and
+               "RegisterAppendedFacets: грани должны быть записаны в хранилище");
+    }
+    const size_t begin = facets_storage_.size() - facets_count;
+    if (format_ == COMPACT) {
+        // хранилище FULL_PRECISION в этом формате используется только как временный буфер
+        MeshId id = PushCompactMesh({facets_storage_.data() + begin, facets_count});
+        facets_storage_.clear();
+        facets_storage_.shrink_to_fit();
+        return id;
+    }
+    MeshId id = meshes_table_.Push();
+    meshes_.push_back(Mesh{.begin = begin, .size = facets_count});
+    return id;
+}
+
+bool Scene::FitsFacetsBudget(const size_t facets_count) const {
+    if (facets_budget_ == kNoMemoryBudget) {
+        return true;
+    }
+    const size_t facet_bytes =
+        (format_ == COMPACT) ? sizeof(CompactTriangle) : sizeof(Object::FacetType);
+    const size_t available = facets_budget_ - std::min(facets_budget_, GetFacetsBytes());
+    return facets_count <= available / facet_bytes;
+}
+
+void Scene::ReserveFacets(const size_t facets_count) {
+    const size_t required = facets_storage_.size() + facets_count;
+    if (format_ == COMPACT or facets_budget_ == kNoMemoryBudget or
+        required <= facets_storage_.capacity()) {
+        return;
+    }
+    const size_t limit = facets_budget_ / sizeof(Object::FacetType);
+    facets_storage_.reserve(std::max(required, std::min(2 * facets_storage_.capacity(), limit)));
+}
+
+Scene::MeshId Scene::PushCompactMesh(std::span<const Object::FacetType> facets) {
+    MeshId id = meshes_table_.Push();
+    Mesh mesh{.begin = compact_facets_storage_.size(), .size = facets.size()};
+    mesh.bounds = ComputeQuantizationBounds(facets.data(), facets.data() + facets.size());
+    compact_facets_storage_.reserve(compact_facets_storage_.size() + facets.size());
+    for (const Object::FacetType& facet : facets) {
+        compact_facets_storage_.push_back(EncodeTriangle(facet, mesh.bounds));
+    }
+    meshes_.push_back(mesh);
+    return id;
+}
+
+Object::FacetType Scene::GetFacet(const SceneObject& object, const size_t index) const {
+    {
+        assert((objects_.data() <= &object and &object < objects_.data() + objects_.size()) and
+               "GetFacet: объект должен принадлежать сцене");
+        assert((index < object.Size()) and "GetFacet: номер грани должен быть меньше размера");
+    }
+    if (format_ == COMPACT) {
+        const QuantizationBounds& bounds = meshes_[meshes_table_.IndexOf(object.Mesh())].bounds;
+        return DecodeTriangle(compact_facets_storage_[object.Begin() + index], bounds);
+    }
+    return facets_storage_[object.Begin() + index];
 }
 
 Object::FacetType* Scene::AccessFacetsStorage() {
@@ -5,10 +5,18 @@
 
 #pragma once
 
+#include <functional>
+#include <limits>
+#include <span>
+
 #include "renderer/camera.hpp"
+#include "renderer/compact_primitives.hpp"
+#include "renderer/handle_table.hpp"
 #include "renderer/light.hpp"
+#include "renderer/memory_report.hpp"
 #include "renderer/object.hpp"
 #include "renderer/scene_object.hpp"
+#include "renderer/thread_pool.hpp"
 
 namespace renderer {
 
@@ -16,6 +24,14 @@ namespace renderer {
  * @brief Контейнер для объектов
  *
  * Хранит объекты и матрицы, которые описывают положение объектов в сцене
+ *
+ * Сетки, объекты, камеры и источники света адресуются поколенческими ID (см. HandleTable): ID
+ * удаленного элемента перестает быть действительным и не совпадает с ID элементов, добавленных
+ * позже. Сами элементы хранятся в плотных массивах, поэтому удаление меняет порядок обхода
+ * итераторами
+ *
+ * Объем хранилища граней можно ограничить (см. Scene::SetFacetsBudget): сетки, не помещающиеся в
+ * бюджет, не добавляются
  */
 class Scene {
 public:
@@ -24,19 +40,48 @@ public:
      *
      * Используется для указания на объект в сцене
      */
-    using ObjectId = size_t;
+    using ObjectId = HandleTable::Handle;
+
+    /**
+     * @brief ID сетки
+     *
+     * Используется для указания на сетку - набор граней, хранящийся в сцене один раз и
+     * используемый всеми своими экземплярами
+     */
+    using MeshId = HandleTable::Handle;
 
     /**
      * @brief ID камеры
      *
      * Используется для указания на камеру в сцене
      */
-    using CameraId = size_t;
+    using CameraId = HandleTable::Handle;
 
     /**
      * @brief ID источника света
      */
-    using LightId = size_t;
+    using LightId = HandleTable::Handle;
+
+    /**
+     * @brief ID, возвращаемый при отказе в добавлении сетки
+     *
+     * Не совпадает с ID никакой сетки или объекта
+     */
+    static constexpr MeshId kNoMesh = std::numeric_limits<MeshId>::max();
+
+    /**
+     * @brief ID, возвращаемый при отказе в добавлении объекта
+     *
+     * Не совпадает с ID никакого объекта
+     */
+    static constexpr ObjectId kNoObject = std::numeric_limits<ObjectId>::max();
+
+    /**
+     * @brief Размер шага уплотнения по-умолчанию
+     *
+     * Количество граней, копируемых за один вызов Scene::CompactStorage
+     */
+    static constexpr size_t kCompactionStepFacets = size_t{1} << 16;
 
     /**
      * @brief Итератор объектов в сцене
@@ -50,18 +95,128 @@ public:
     using LightIterator = std::vector<LightSource>::iterator;
     using LightConstIterator = std::vector<LightSource>::const_iterator;
 
+    /**
+     * @brief Формат хранения граней
+     */
+    enum StorageFormat : uint8_t {
+        /**
+         * Грани хранятся без изменений (Object::FacetType)
+         */
+        FULL_PRECISION,
+        /**
+         * Грани хранятся в сжатом виде (CompactTriangle) и распаковываются при чтении. Координаты
+         * квантуются относительно границ объекта, из-за чего теряется точность
+         */
+        COMPACT
+    };
+
+    /**
+     * @brief Создание сцены
+     *
+     * @param[in] format Формат хранения граней
+     */
+    explicit Scene(const StorageFormat format = FULL_PRECISION);
+
+    /**
+     * @brief Получение формата хранения граней
+     *
+     * @return Формат хранения граней
+     */
+    StorageFormat GetStorageFormat() const;
+
+    /**
+     * @brief Добавление сетки в сцену
+     *
+     * Копирует грани переданного объекта в хранилище сцены, не создавая объектов. Сетка
+     * отрисовывается только через свои экземпляры, добавленные с помощью Scene::PushInstance. В
+     * формате COMPACT грани сжимаются относительно границ сетки
+     *
+     * @param[in] object Объект с гранями сетки
+     *
+     * @return ID добавленной сетки или Scene::kNoMesh, если сетка не помещается в бюджет
+     */
+    MeshId PushMesh(const Object& object);
+
+    /**
+     * @brief Добавление сетки в сцену
+     *
+     * Аналогично Scene::PushMesh(const Object&), но забирает грани объекта. Если формат хранения
+     * FULL_PRECISION и хранилище граней еще пусто, массив граней объекта становится хранилищем без
+     * копирования, иначе грани копируются один раз. После вызова объект пуст. Если сетка не
+     * помещается в бюджет, объект не изменяется
+     *
+     * @param[in] object Объект с гранями сетки
+     *
+     * @return ID добавленной сетки или Scene::kNoMesh, если сетка не помещается в бюджет
+     */
+    MeshId PushMesh(Object&& object);
+
+    /**
+     * @brief Добавление сетки в сцену
+     *
+     * Копирует переданный непрерывный диапазон граней в хранилище сцены одним блоком, не требуя
+     * создания Object
+     *
+     * @param[in] facets Грани сетки
+     *
+     * @return ID добавленной сетки или Scene::kNoMesh, если сетка не помещается в бюджет
+     */
+    MeshId PushMesh(std::span<const Object::FacetType> facets);
+
+    /**
+     * @brief Добавление сетки в сцену с заполнением на месте
+     *
+     * Выделяет в хранилище сцены место под facets_count граней и передает его в функцию fill,
+     * которая должна записать все грани сетки. В формате FULL_PRECISION грани записываются прямо в
+     * хранилище сцены, в формате COMPACT - во временный буфер, который затем сжимается. Диапазон,
+     * переданный в fill, действителен только во время ее вызова. Если сетка не помещается в
+     * бюджет, fill не вызывается
+     *
+     * @param[in] facets_count Количество граней сетки
+     * @param[in] fill Функция, заполняющая грани
+     *
+     * @return ID добавленной сетки или Scene::kNoMesh, если сетка не помещается в бюджет
+     */
+    MeshId PushMesh(const size_t facets_count,
+                    const std::function<void(std::span<Object::FacetType>)>& fill);
+
+    /**
+     * @brief Добавление экземпляра сетки в сцену
+     *
+     * Создает объект, использующий грани сетки mesh_id без их копирования. Характеристики объекта
+     * выставляются по-умолчанию для SceneObject. Требуется, чтобы сетка принадлежала сцене
+     *
+     * @param[in] mesh_id ID сетки
+     *
+     * @return ID добавленного объекта
+     */
+    ObjectId PushInstance(const MeshId mesh_id);
+
     /**
      * @brief Добавление объекта в сцену
      *
-     * Копирует переданный объект в контейнер, его характеристики выставляются по-умолчанию для
-     * SceneObject
+     * Копирует переданный объект в контейнер в виде новой сетки и создает ее экземпляр, его
+     * характеристики выставляются по-умолчанию для SceneObject. Для многократного размещения одного
+     * объекта следует использовать Scene::PushMesh и Scene::PushInstance
      *
      * @param[in] object Объект
      *
-     * @return ID добавленного объекта
+     * @return ID добавленного объекта или Scene::kNoObject, если его сетка не помещается в бюджет
      */
     ObjectId PushObject(const Object& object);
 
+    /**
+     * @brief Добавление объекта в сцену
+     *
+     * Аналогично Scene::PushObject(const Object&), но забирает грани объекта по правилам
+     * Scene::PushMesh(Object&&). После вызова объект пуст
+     *
+     * @param[in] object Объект
+     *
+     * @return ID добавленного объекта или Scene::kNoObject, если его сетка не помещается в бюджет
+     */
+    ObjectId PushObject(Object&& object);
+
     /**
      * @brief Добавление камеры в сцену
      *
@@ -84,6 +239,117 @@ public:
      */
     LightId PushLight(const LightSource& light_source);
 
+    /**
+     * @brief Удаление сетки
+     *
+     * Удаляет сетку из сцены. Место, занятое ее гранями, освобождается при уплотнении хранилища.
+     * Требуется, чтобы сетка принадлежала сцене и не имела экземпляров
+     *
+     * @param[in] id ID сетки
+     */
+    void RemoveMesh(const MeshId id);
+
+    /**
+     * @brief Удаление объекта
+     *
+     * Удаляет объект из сцены. Дочерние объекты отсоединяются от него и остаются на месте
+     * относительно своей системы координат. Если объект был добавлен через Scene::PushObject,
+     * вместе с ним удаляется и его сетка. Требуется, чтобы объект принадлежал сцене
+     *
+     * @param[in] id ID объекта
+     */
+    void RemoveObject(const ObjectId id);
+
+    /**
+     * @brief Удаление камеры
+     *
+     * Требуется, чтобы камера принадлежала сцене
+     *
+     * @param[in] id ID камеры
+     */
+    void RemoveCamera(const CameraId id);
+
+    /**
+     * @brief Удаление источника света
+     *
+     * Требуется, чтобы источник света принадлежал сцене
+     *
+     * @param[in] id ID источника света
+     */
+    void RemoveLight(const LightId id);
+
+    /**
+     * @brief Количество неиспользуемых граней
+     *
+     * Возвращает количество граней в хранилище, принадлежавших удаленным сеткам
+     *
+     * @return Количество неиспользуемых граней
+     */
+    size_t GarbageFacets() const;
+
+    /**
+     * @brief Задание бюджета хранилища граней
+     *
+     * Ограничивает объем хранилища граней текущего формата, включая грани удаленных сеток до
+     * уплотнения. Добавление сетки, после которого хранилище превысило бы бюджет, отклоняется, а
+     * емкость хранилища растет не дальше бюджета. Уже добавленные сетки не удаляются. Временная
+     * память уплотнения и буфер сжатия в формате COMPACT в бюджет не входят
+     *
+     * @param[in] bytes Бюджет в байтах или kNoMemoryBudget
+     */
+    void SetFacetsBudget(const size_t bytes);
+
+    /**
+     * @brief Получение бюджета хранилища граней
+     *
+     * @return Бюджет в байтах или kNoMemoryBudget
+     */
+    size_t GetFacetsBudget() const;
+
+    /**
+     * @brief Объем хранилища граней
+     *
+     * @return Размер граней в хранилище текущего формата в байтах, учитываемый бюджетом
+     */
+    size_t GetFacetsBytes() const;
+
+    /**
+     * @brief Память сцены
+     *
+     * Ресурсами отчета являются сетки, их размер - размер их граней в хранилище
+     *
+     * @return Память сцены
+     */
+    MemoryUsage GetMemoryUsage() const;
+
+    /**
+     * @brief Шаг уплотнения хранилища граней
+     *
+     * Копирует грани следующих сеток в новое хранилище без неиспользуемых граней, пока не будет
+     * скопировано max_facets граней (хотя бы одна сетка за вызов). Текущее хранилище при этом
+     * только читается, поэтому шаг можно выполнять в отдельном потоке одновременно с рендерингом
+     * этой сцены, но не одновременно с другими изменениями сцены. Добавленные и удаленные во
+     * время уплотнения сетки учитываются
+     *
+     * Новое хранилище начинает использоваться только после вызова Scene::ApplyCompaction
+     *
+     * @param[in] max_facets Количество граней, копируемых за шаг
+     *
+     * @return Готово ли новое хранилище. Если неиспользуемых граней нет и уплотнение не начато,
+     * возвращается false
+     */
+    bool CompactStorage(const size_t max_facets = kCompactionStepFacets);
+
+    /**
+     * @brief Применение уплотнения
+     *
+     * Заменяет хранилище граней на построенное в Scene::CompactStorage и обновляет индексы граней
+     * сеток и объектов. Грани не копируются, время работы пропорционально количеству сеток и
+     * объектов. Не должно выполняться одновременно с рендерингом. Требуется, чтобы последний вызов
+     * Scene::CompactStorage вернул true и после него не добавлялись сетки
+     */
+    void ApplyCompaction();
+
     /**
      * @brief Получение доступа к объекту
      *
@@ -154,6 +420,75 @@ public:
      */
     const LightSource& AccessLight(const LightId id) const;
 
+    /**
+     * @brief Задание родителя объекта
+     *
+     * Делает объект parent_id родителем объекта child_id: положение, поворот и масштаб дочернего
+     * объекта задаются относительно родителя. Если parent_id равен SceneObject::kNoParent, объект
+     * отсоединяется от родителя. Требуется, чтобы оба объекта принадлежали сцене, а parent_id не
+     * был потомком child_id
+     *
+     * @param[in] child_id ID дочернего объекта
+     * @param[in] parent_id ID родителя
+     */
+    void SetParent(const ObjectId child_id, const ObjectId parent_id);
+
+    /**
+     * @brief Пересчет матриц объектов
+     *
+     * Пересчитывает кэшированные матрицы измененных объектов и их потомков. Объекты одного уровня
+     * иерархии обрабатываются параллельно. Неизмененные поддеревья не пересчитываются. Следует
+     * вызывать после изменения объектов и перед рендерингом, иначе матрицы измененных объектов
+     * будут вычисляться при каждом обращении
+     *
+     * @param[in] thread_pool ThreadPool, в котором выполняется пересчет
+     */
+    void UpdateTransforms(ThreadPool& thread_pool = ThreadPool::Get());
+
+    /**
+     * @brief Матрица объекта в координатах сцены
+     *
+     * Возвращает матрицу перевода координат объекта в координаты сцены с учетом всех его предков.
+     * Если матрица объекта и его предков не менялась после последнего Scene::UpdateTransforms,
+     * используется кэшированное значение, иначе матрица вычисляется без изменения кэша. Требуется,
+     * чтобы object был объектом этой сцены
+     *
+     * @param[in] object Объект сцены
+     *
+     * @return Матрица перевода координат
+     */
+    Matrix GetWorldMatrix(const SceneObject& object) const;
+
+    /**
+     * @brief Проверка существования сетки
+     *
+     * Проверяет, существует ли в сцене сетка с заданным ID
+     *
+     * @param[in] id ID сетки
+     *
+     * @return Существует ли сетка
+     */
+    bool HasMesh(const MeshId id) const;
+
+    /**
+     * @brief Количество сеток
+     *
+     * @return Количество сеток в сцене
+     */
+    size_t MeshesCount() const;
+
+    /**
+     * @brief Номер сетки
+     *
+     * Возвращает номер сетки среди сеток сцены, меньший Scene::MeshesCount. Номер может измениться
+     * после удаления других сеток. Требуется, чтобы сетка принадлежала сцене
+     *
+     * @param[in] id ID сетки
+     *
+     * @return Номер сетки
+     */
+    size_t MeshIndex(const MeshId id) const;
+
     /**
      * @brief Проверка существования объекта
      *
@@ -259,10 +594,25 @@ public:
      */
     LightConstIterator LightEnd() const;
 
+    /**
+     * @brief Получение грани объекта
+     *
+     * Возвращает грань с номером index объекта object в том виде, в котором она была добавлена.
+     * Работает для любого формата хранения, в формате COMPACT грань распаковывается. Требуется,
+     * чтобы object был объектом этой сцены, а index был меньше количества граней объекта
+     *
+     * @param[in] object Объект сцены
+     * @param[in] index Номер грани в объекте
+     *
+     * @return Грань
+     */
+    Object::FacetType GetFacet(const SceneObject& object, const size_t index) const;
+
     /**
      * @brief Доступ к хранилищу граней
      *
-     * Возвращает указатель на хранилище граней
+     * Возвращает указатель на хранилище граней. В формате COMPACT это хранилище пусто, для чтения
+     * граней используется Scene::GetFacet
      *
      * Гарантируется корректность указателя до любых,
      * изменяющих объект сцены
@@ -278,7 +628,8 @@ public:
     /**
      * @brief Доступ к хранилищу граней
      *
-     * Возвращает константный указатель на хранилище граней
+     * Возвращает константный указатель на хранилище граней. В формате COMPACT это хранилище пусто,
+     * для чтения граней используется Scene::GetFacet
      *
      * Гарантируется корректность указателя до любых,
      * изменяющих объект сцены
@@ -292,8 +643,93 @@ public:
     const Object::FacetType* AccessFacetsStorage() const;
 
 private:
+    /**
+     * @brief Сетка в хранилище граней
+     */
+    struct Mesh {
+        size_t begin;
+        size_t size;
+        QuantizationBounds bounds{};  // границы сжатия, используются в формате COMPACT
+        size_t instances = 0;         // количество объектов-экземпляров
+        bool owned = false;           // создана Scene::PushObject и удаляется вместе с объектом
+        size_t compacted_begin = kNotCompacted;  // начало граней в новом хранилище
+    };
+
+    static constexpr size_t kNotCompacted = std::numeric_limits<size_t>::max();
+
+    /**
+     * @brief Состояние уплотнения хранилища граней
+     */
+    struct Compaction {
+        bool active = false;
+        size_t cursor = 0;   // сетки с меньшими номерами уже скопированы
+        size_t garbage = 0;  // грани сеток, удаленных после копирования
+        std::vector<Object::FacetType> facets;
+        std::vector<CompactTriangle> compact_facets;
+    };
+
+    /**
+     * @brief Копирование граней сетки в новое хранилище
+     */
+    void CompactMesh(Mesh& mesh);
+
+    /**
+     * @brief Номер объекта в плотном массиве по ID родителя
+     */
+    size_t ParentIndex(const SceneObject& object) const;
+
+    /**
+     * @brief Регистрация сетки
+     *
+     * Регистрирует сетку из facets_count граней, которые уже записаны в конец хранилища
+     * FULL_PRECISION. В формате COMPACT эти грани сжимаются и удаляются из хранилища FULL_PRECISION
+     */
+    MeshId RegisterAppendedFacets(const size_t facets_count);
+
+    /**
+     * @brief Проверка, помещаются ли facets_count новых граней в бюджет
+     */
+    bool FitsFacetsBudget(const size_t facets_count) const;
+
+    /**
+     * @brief Резервирование места под facets_count граней в хранилище FULL_PRECISION
+     *
+     * При заданном бюджете емкость растет вдвое, но не дальше бюджета
+     */
+    void ReserveFacets(const size_t facets_count);
+
+    /**
+     * @brief Сжатие и добавление сетки в хранилище COMPACT
+     */
+    MeshId PushCompactMesh(std::span<const Object::FacetType> facets);
+
+    /**
+     * @brief Проверка актуальности кэша матрицы в координатах сцены
+     */
+    bool IsWorldMatrixCached(const SceneObject& object) const;
+
+    /**
+     * @brief Построение уровней иерархии
+     *
+     * Разбивает объекты на уровни по глубине в иерархии. Родитель объекта всегда находится на
+     * предыдущем уровне
+     */
+    void RebuildHierarchyLevels();
+
+    StorageFormat format_;
+    HandleTable meshes_table_;
+    HandleTable objects_table_;
+    HandleTable cameras_table_;
+    HandleTable lights_table_;
+    size_t garbage_facets_ = 0;
+    size_t facets_budget_ = kNoMemoryBudget;
+    Compaction compaction_;
     std::vector<Object::FacetType> facets_storage_;
+    std::vector<CompactTriangle> compact_facets_storage_;
+    std::vector<Mesh> meshes_;
     std::vector<SceneObject> objects_;
+    std::vector<std::vector<size_t>> hierarchy_levels_;  // номера объектов по уровням иерархии
+    bool hierarchy_changed_ = true;  // уровни и кэш матриц устарели после изменения иерархии
     std::vector<Camera> cameras_;
     std::vector<LightSource> light_sources_;
 };
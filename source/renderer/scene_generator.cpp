@@ -0,0 +1,506 @@
+#include "renderer/scene_generator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+namespace renderer::utils {
+
+namespace {
+
+/**
+ * Минимальное число строк или граней на одну задачу при генерации
+ */
+constexpr size_t kRowsPerTask = 16;
+constexpr size_t kFacetsPerTask = 1 << 14;
+
+/**
+ * @brief Перемешивание 64-битного значения (финализатор SplitMix64)
+ */
+uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Генератор случайных чисел SplitMix64
+ *
+ * Последовательность задается зерном и номером потока, поэтому элементы можно генерировать
+ * независимо и параллельно. В отличие от распределений стандартной библиотеки результат не
+ * зависит от ее реализации
+ */
+class Random {
+public:
+    Random(const uint64_t seed, const uint64_t stream) : state_{Mix(seed) ^ Mix(~stream)} {
+    }
+
+    uint64_t Next() {
+        state_ += 0x9e3779b97f4a7c15ull;
+        return Mix(state_);
+    }
+
+    /**
+     * @brief Равномерное число в [min, max)
+     */
+    float Uniform(const float min, const float max) {
+        const float unit = static_cast<float>(Next() >> 40) / static_cast<float>(1ull << 24);
+        return min + (max - min) * unit;
+    }
+
+private:
+    uint64_t state_;
+};
+
+/**
+ * @brief Значение шума в целочисленной точке решетки, от 0 до 1
+ */
+float LatticeValue(const uint64_t seed, const int64_t x, const int64_t y) {
+    const uint64_t hash = Mix(seed ^ Mix(static_cast<uint64_t>(x) * 0x9e3779b97f4a7c15ull +
+                                         static_cast<uint64_t>(y)));
+    return static_cast<float>(hash >> 40) / static_cast<float>(1ull << 24);
+}
+
+/**
+ * @brief Шум значений с гладкой интерполяцией между узлами решетки
+ */
+float ValueNoise(const uint64_t seed, const float x, const float y) {
+    const float x_floor = std::floor(x);
+    const float y_floor = std::floor(y);
+    const int64_t x0 = static_cast<int64_t>(x_floor);
+    const int64_t y0 = static_cast<int64_t>(y_floor);
+    auto smooth = [](const float t) { return t * t * (3 - 2 * t); };
+    const float tx = smooth(x - x_floor);
+    const float ty = smooth(y - y_floor);
+    const float bottom = std::lerp(LatticeValue(seed, x0, y0), LatticeValue(seed, x0 + 1, y0), tx);
+    const float top =
+        std::lerp(LatticeValue(seed, x0, y0 + 1), LatticeValue(seed, x0 + 1, y0 + 1), tx);
+    return std::lerp(bottom, top, ty);
+}
+
+/**
+ * @brief Грань по трем вершинам с нормалями
+ */
+Triangle MakeTriangle(const Vertex& a, const Vertex& b, const Vertex& c,
+                      const MaterialId material) {
+    Triangle triangle;
+    triangle.vertices[0] = a;
+    triangle.vertices[1] = b;
+    triangle.vertices[2] = c;
+    triangle.material = material;
+    return triangle;
+}
+
+/**
+ * Вершины икосаэдра, вписанного в единичную сферу после нормализации
+ */
+constexpr float kGoldenRatio = 1.6180339887f;
+constexpr Point kIcosahedronVertices[12] = {
+    {-1, kGoldenRatio, 0}, {1, kGoldenRatio, 0}, {-1, -kGoldenRatio, 0}, {1, -kGoldenRatio, 0},
+    {0, -1, kGoldenRatio}, {0, 1, kGoldenRatio}, {0, -1, -kGoldenRatio}, {0, 1, -kGoldenRatio},
+    {kGoldenRatio, 0, -1}, {kGoldenRatio, 0, 1}, {-kGoldenRatio, 0, -1}, {-kGoldenRatio, 0, 1}};
+
+/**
+ * Грани икосаэдра, вершины перечислены против часовой стрелки при взгляде снаружи
+ */
+constexpr uint8_t kIcosahedronFaces[20][3] = {
+    {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11}, {1, 5, 9},  {5, 11, 4},
+    {11, 10, 2}, {10, 7, 6}, {7, 1, 8},   {3, 9, 4},  {3, 4, 2},   {3, 2, 6},  {3, 6, 8},
+    {3, 8, 9},  {4, 9, 5},  {2, 4, 11},  {6, 2, 10}, {8, 6, 7},   {9, 8, 1}};
+
+}  // namespace
+
+float TerrainHeight(const TerrainParameters& parameters, const float x, const float y) {
+    // 4 холма на сторону ландшафта на первой октаве
+    float frequency = 4.0f / parameters.size;
+    float amplitude = 1;
+    float total_amplitude = 0;
+    float height = 0;
+    for (size_t octave = 0; octave < std::max<size_t>(parameters.octaves, 1); ++octave) {
+        height += amplitude * ValueNoise(parameters.seed + octave, x * frequency, y * frequency);
+        total_amplitude += amplitude;
+        frequency *= 2;
+        amplitude /= 2;
+    }
+    return parameters.height * height / total_amplitude;
+}
+
+Scene::MeshId PushTerrainMesh(Scene& scene, const TerrainParameters& parameters,
+                              ThreadPool& thread_pool) {
+    {
+        assert((parameters.cells > 0) and "PushTerrainMesh: cells должно быть больше 0");
+        assert((parameters.size > 0) and "PushTerrainMesh: size должен быть больше 0");
+    }
+    const size_t cells = parameters.cells;
+    const size_t side = cells + 1;
+    const float step = parameters.size / cells;
+    const float origin = -parameters.size / 2;
+
+    std::vector<float> heights(side * side);
+    thread_pool.ParallelFor(0, side, kRowsPerTask, [&](const size_t begin, const size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            for (size_t i = 0; i < side; ++i) {
+                heights[j * side + i] =
+                    TerrainHeight(parameters, origin + i * step, origin + j * step);
+            }
+        }
+    });
+
+    auto vertex = [&](const size_t i, const size_t j) {
+        // нормаль по центральным разностям, на краях - односторонним
+        const size_t left = (i > 0) ? i - 1 : i;
+        const size_t right = (i + 1 < side) ? i + 1 : i;
+        const size_t down = (j > 0) ? j - 1 : j;
+        const size_t up = (j + 1 < side) ? j + 1 : j;
+        const float dx = (heights[j * side + right] - heights[j * side + left]) /
+                         (static_cast<float>(right - left) * step);
+        const float dy = (heights[up * side + i] - heights[down * side + i]) /
+                         (static_cast<float>(up - down) * step);
+        return Vertex{.point = {origin + i * step, origin + j * step, heights[j * side + i]},
+                      .normal = glm::normalize(Vector{-dx, -dy, 1}),
+                      .uv_coordinates = Point2{i, j} / static_cast<float>(cells)};
+    };
+
+    return scene.PushMesh(2 * cells * cells, [&](std::span<Object::FacetType> facets) {
+        thread_pool.ParallelFor(0, cells, kRowsPerTask, [&](const size_t begin, const size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                for (size_t i = 0; i < cells; ++i) {
+                    const Vertex a = vertex(i, j);
+                    const Vertex b = vertex(i + 1, j);
+                    const Vertex c = vertex(i + 1, j + 1);
+                    const Vertex d = vertex(i, j + 1);
+                    const size_t index = 2 * (j * cells + i);
+                    facets[index] = MakeTriangle(a, b, c, parameters.material);
+                    facets[index + 1] = MakeTriangle(a, c, d, parameters.material);
+                }
+            }
+        });
+    });
+}
+
+Scene::MeshId PushSphereMesh(Scene& scene, const SphereParameters& parameters,
+                             ThreadPool& thread_pool) {
+    {
+        assert((parameters.subdivisions < 16) and
+               "PushSphereMesh: subdivisions должно быть меньше 16");
+    }
+    // каждая грань икосаэдра разбивается на n^2 граней треугольной решеткой
+    const size_t n = size_t{1} << parameters.subdivisions;
+    const size_t facets_per_face = n * n;
+
+    auto vertex = [&](const size_t face, const size_t row, const size_t column) {
+        const Point& a = kIcosahedronVertices[kIcosahedronFaces[face][0]];
+        const Point& b = kIcosahedronVertices[kIcosahedronFaces[face][1]];
+        const Point& c = kIcosahedronVertices[kIcosahedronFaces[face][2]];
+        const float u = static_cast<float>(row - column) / n;
+        const float v = static_cast<float>(column) / n;
+        const Vector normal = glm::normalize(a + (b - a) * u + (c - a) * v);
+        const Point2 uv{0.5f + std::atan2(normal.y, normal.x) / (2 * glm::pi<float>()),
+                        0.5f - std::asin(normal.z) / glm::pi<float>()};
+        return Vertex{.point = normal * parameters.radius, .normal = normal, .uv_coordinates = uv};
+    };
+
+    return scene.PushMesh(20 * facets_per_face, [&](std::span<Object::FacetType> facets) {
+        // строка row решетки содержит 2 * row + 1 граней и начинается с грани row^2
+        thread_pool.ParallelFor(0, 20 * n, kRowsPerTask, [&](const size_t begin, const size_t end) {
+            for (size_t line = begin; line < end; ++line) {
+                const size_t face = line / n;
+                const size_t row = line % n;
+                size_t index = face * facets_per_face + row * row;
+                for (size_t column = 0; column <= row; ++column) {
+                    facets[index++] = MakeTriangle(vertex(face, row, column),
+                                                   vertex(face, row + 1, column),
+                                                   vertex(face, row + 1, column + 1),
+                                                   parameters.material);
+                    if (column < row) {
+                        facets[index++] = MakeTriangle(vertex(face, row, column),
+                                                       vertex(face, row + 1, column + 1),
+                                                       vertex(face, row, column + 1),
+                                                       parameters.material);
+                    }
+                }
+            }
+        });
+    });
+}
+
+Scene::MeshId PushTriangleSoupMesh(Scene& scene, const TriangleSoupParameters& parameters,
+                                   ThreadPool& thread_pool) {
+    const float half_extent = parameters.extent / 2;
+    const float half_size = parameters.facet_size;
+
+    // грань определяется только своим номером, поэтому разбиение на задачи не влияет на результат
+    auto generate = [&](const size_t index, Triangle& facet) {
+        Random random{parameters.seed, index};
+        const Point center{random.Uniform(-half_extent, half_extent),
+                           random.Uniform(-half_extent, half_extent),
+                           random.Uniform(-half_extent, half_extent)};
+        for (Vertex& vertex : facet.vertices) {
+            const Vector offset{random.Uniform(-1, 1), random.Uniform(-1, 1),
+                                random.Uniform(-1, 1)};
+            vertex.point = center + offset * half_size;
+            vertex.uv_coordinates = Point2{random.Uniform(0, 1), random.Uniform(0, 1)};
+        }
+        const Vector normal = glm::cross(facet.vertices[1].point - facet.vertices[0].point,
+                                         facet.vertices[2].point - facet.vertices[0].point);
+        const float length = glm::length(normal);
+        for (Vertex& vertex : facet.vertices) {
+            vertex.normal = (length > 0) ? normal / length : Vector{0, 0, 1};
+        }
+        facet.material = parameters.material;
+    };
+
+    return scene.PushMesh(parameters.facets, [&](std::span<Object::FacetType> facets) {
+        thread_pool.ParallelFor(0, facets.size(), kFacetsPerTask,
+                                [&](const size_t begin, const size_t end) {
+                                    for (size_t i = begin; i < end; ++i) {
+                                        generate(i, facets[i]);
+                                    }
+                                });
+    });
+}
+
+Scene::MeshId PushForest(Scene& scene, const ForestParameters& parameters) {
+    {
+        assert((parameters.segments >= 3) and "PushForest: segments должно быть не меньше 3");
+    }
+    const size_t segments = parameters.segments;
+    const float height = parameters.tree_height;
+    const float trunk_radius = 0.08f * height;
+    const float trunk_top = 0.3f * height;
+    const float crown_radius = 0.35f * height;
+    const float crown_bottom = 0.25f * height;
+    const float crown_slope = crown_radius / (height - crown_bottom);
+
+    std::vector<Triangle> tree;
+    tree.reserve(4 * segments);
+    for (size_t i = 0; i < segments; ++i) {
+        const float angle0 = 2 * glm::pi<float>() * i / segments;
+        const float angle1 = 2 * glm::pi<float>() * (i + 1) / segments;
+        const Vector radial0{std::cos(angle0), std::sin(angle0), 0};
+        const Vector radial1{std::cos(angle1), std::sin(angle1), 0};
+        const Point2 uv0{static_cast<float>(i) / segments, 0};
+        const Point2 uv1{static_cast<float>(i + 1) / segments, 0};
+        // ствол
+        {
+            const Vertex bottom0{radial0 * trunk_radius, radial0, uv0};
+            const Vertex bottom1{radial1 * trunk_radius, radial1, uv1};
+            const Vertex top0{radial0 * trunk_radius + Vector{0, 0, trunk_top}, radial0,
+                              uv0 + Point2{0, 1}};
+            const Vertex top1{radial1 * trunk_radius + Vector{0, 0, trunk_top}, radial1,
+                              uv1 + Point2{0, 1}};
+            tree.push_back(MakeTriangle(bottom0, bottom1, top1, parameters.trunk_material));
+            tree.push_back(MakeTriangle(bottom0, top1, top0, parameters.trunk_material));
+        }
+        // крона: боковая поверхность конуса и основание
+        {
+            const Vector normal0 = glm::normalize(radial0 + Vector{0, 0, crown_slope});
+            const Vector normal1 = glm::normalize(radial1 + Vector{0, 0, crown_slope});
+            const Vertex base0{radial0 * crown_radius + Vector{0, 0, crown_bottom}, normal0, uv0};
+            const Vertex base1{radial1 * crown_radius + Vector{0, 0, crown_bottom}, normal1, uv1};
+            const Vertex apex{Point{0, 0, height}, glm::normalize(normal0 + normal1),
+                              (uv0 + uv1) / 2.0f + Point2{0, 1}};
+            tree.push_back(MakeTriangle(base0, base1, apex, parameters.crown_material));
+
+            const Vector down{0, 0, -1};
+            const Vertex center{Point{0, 0, crown_bottom}, down, Point2{0.5f, 0.5f}};
+            tree.push_back(MakeTriangle(center, Vertex{base1.point, down, uv1},
+                                        Vertex{base0.point, down, uv0},
+                                        parameters.crown_material));
+        }
+    }
+
+    const Scene::MeshId mesh = scene.PushMesh(std::span<const Triangle>{tree});
+    if (mesh == Scene::kNoMesh) {
+        return mesh;
+    }
+    const float half_area = parameters.area / 2;
+    for (size_t i = 0; i < parameters.trees; ++i) {
+        Random random{parameters.seed, i};
+        const float x = random.Uniform(-half_area, half_area);
+        const float y = random.Uniform(-half_area, half_area);
+        const float z =
+            (parameters.terrain != nullptr) ? TerrainHeight(*parameters.terrain, x, y) : 0;
+        SceneObject& object = scene.AccessObject(scene.PushInstance(mesh));
+        object.AccessPosition() = Point{x, y, z};
+        object.AccessZAngle() = random.Uniform(0, 360);
+        object.AccessScale() = random.Uniform(0.7f, 1.3f);
+    }
+    return mesh;
+}
+
+void PushLightGrid(Scene& scene, const LightGridParameters& parameters) {
+    const float x_origin = -parameters.spacing * (parameters.columns - 1) / 2.0f;
+    const float y_origin = -parameters.spacing * (parameters.rows - 1) / 2.0f;
+    for (size_t row = 0; row < parameters.rows; ++row) {
+        for (size_t column = 0; column < parameters.columns; ++column) {
+            Random random{parameters.seed, row * parameters.columns + column};
+            const Color color{random.Uniform(0.5f, 1), random.Uniform(0.5f, 1),
+                              random.Uniform(0.5f, 1)};
+            scene.PushLight(PointLight{.strength = parameters.strength,
+                                       .color = color,
+                                       .position = {x_origin + column * parameters.spacing,
+                                                    y_origin + row * parameters.spacing,
+                                                    parameters.height}});
+        }
+    }
+}
+
+Scene::MeshId PushGridMesh(Scene& scene, const GridParameters& parameters) {
+    {
+        assert((parameters.cells > 0) and "PushGridMesh: cells должно быть больше 0");
+    }
+    const size_t cells = parameters.cells;
+    const float size = parameters.size;
+    const float step = size / cells;
+    const Vector normal{0, -1, 0};
+    auto vertex = [&](const size_t i, const size_t j) {
+        return Vertex{.point = {-size / 2 + i * step, 0, -size / 2 + j * step},
+                      .normal = normal,
+                      .uv_coordinates = Point2{i, j} * (parameters.uv_repeat / cells)};
+    };
+
+    std::vector<Triangle> facets;
+    facets.reserve(2 * cells * cells);
+    for (size_t j = 0; j < cells; ++j) {
+        for (size_t i = 0; i < cells; ++i) {
+            facets.push_back(MakeTriangle(vertex(i, j), vertex(i + 1, j), vertex(i + 1, j + 1),
+                                          parameters.material));
+            facets.push_back(MakeTriangle(vertex(i, j), vertex(i + 1, j + 1), vertex(i, j + 1),
+                                          parameters.material));
+        }
+    }
+    return scene.PushMesh(std::span<const Triangle>{facets});
+}
+
+void PushDefaultLights(Scene& scene) {
+    scene.PushLight(AmbientLight{});
+    scene.PushLight(DirectionalLight{.strength = 0.5, .direction = {1, 1, -1}});
+    scene.PushLight(PointLight{.strength = 3, .position = {2, -4, 2}});
+}
+
+Scene::CameraId PushFrontCamera(Scene& scene, const float distance, const float fov_x) {
+    return scene.PushCamera(Camera{Point{0, -distance, 0}, 90, 0, fov_x});
+}
+
+Scene::CameraId PushTexturedScene(Scene& scene, const TexturedSceneParameters& parameters,
+                                  ResourcesManager& resources) {
+    {
+        assert((parameters.checker_size > 0) and
+               "PushTexturedScene: checker_size должен быть больше 0");
+    }
+    const size_t texture_size = parameters.texture_size;
+    Image texture{Width{texture_size}, Height{texture_size}};
+    for (size_t y = 0; y < texture_size; ++y) {
+        for (size_t x = 0; x < texture_size; ++x) {
+            const bool dark =
+                ((x / parameters.checker_size) + (y / parameters.checker_size)) % 2 == 0;
+            texture.AccessPixel(x, y) =
+                dark ? Image::Pixel{40, 40, 120}
+                     : Image::Pixel{static_cast<uint8_t>(x * 256 / texture_size),
+                                    static_cast<uint8_t>(y * 256 / texture_size), 200};
+        }
+    }
+    Material material;
+    material.texture = resources.PushTexture(std::move(texture));
+
+    const Scene::MeshId mesh =
+        PushGridMesh(scene, GridParameters{.cells = parameters.cells,
+                                           .size = 4,
+                                           .uv_repeat = parameters.uv_repeat,
+                                           .material = resources.PushMaterial(material)});
+    if (mesh != Scene::kNoMesh) {
+        scene.AccessObject(scene.PushInstance(mesh)).AccessXAngle() = parameters.x_angle;
+    }
+    return PushFrontCamera(scene, 2);
+}
+
+Scene::CameraId PushClippingScene(Scene& scene, const size_t cells, ResourcesManager& resources) {
+    Material material;
+    material.two_sided = true;
+    const Scene::MeshId mesh =
+        PushGridMesh(scene, GridParameters{.cells = cells,
+                                           .size = 6,
+                                           .material = resources.PushMaterial(material)});
+    // 6 стенок коробки со стороной 6 вокруг начала координат
+    const float angles[6][2] = {{0, 0}, {0, 180}, {0, 90}, {0, 270}, {90, 0}, {270, 0}};
+    for (size_t i = 0; mesh != Scene::kNoMesh and i < std::size(angles); ++i) {
+        const auto& [x_angle, z_angle] = angles[i];
+        SceneObject& wall = scene.AccessObject(scene.PushInstance(mesh));
+        wall.AccessXAngle() = x_angle;
+        wall.AccessZAngle() = z_angle;
+        const float x = glm::radians(x_angle);
+        const float z = glm::radians(z_angle);
+        wall.AccessPosition() = Point{-3 * glm::sin(z) * glm::cos(x), 3 * glm::cos(z) * glm::cos(x),
+                                      3 * glm::sin(x)};
+    }
+    return scene.PushCamera(Camera{Point{0.5, -0.5, 0.3}, 60, 10, 120, 0.1});
+}
+
+Scene::CameraId PushStressScene(Scene& scene, const StressSceneParameters& parameters,
+                                ThreadPool& thread_pool) {
+    const float size = parameters.size;
+    const TerrainParameters terrain{.cells = std::max<size_t>(parameters.terrain_cells, 1),
+                                    .size = size,
+                                    .height = size / 20,
+                                    .seed = parameters.seed};
+    if (const Scene::MeshId mesh = PushTerrainMesh(scene, terrain, thread_pool);
+        mesh != Scene::kNoMesh) {
+        scene.PushInstance(mesh);
+    }
+
+    PushForest(scene, ForestParameters{.trees = parameters.trees,
+                                       .area = size * 0.9f,
+                                       .tree_height = size / 60,
+                                       .segments = std::max<size_t>(parameters.tree_segments, 3),
+                                       .seed = Mix(parameters.seed + 1),
+                                       .terrain = &terrain});
+
+    if (parameters.spheres > 0) {
+        const float radius = size / 40;
+        const Scene::MeshId sphere = PushSphereMesh(
+            scene, SphereParameters{.subdivisions = parameters.sphere_subdivisions,
+                                    .radius = radius},
+            thread_pool);
+        // кольцо сфер над ландшафтом
+        for (size_t i = 0; sphere != Scene::kNoMesh and i < parameters.spheres; ++i) {
+            const float angle = 2 * glm::pi<float>() * i / parameters.spheres;
+            const float x = size / 4 * std::cos(angle);
+            const float y = size / 4 * std::sin(angle);
+            SceneObject& object = scene.AccessObject(scene.PushInstance(sphere));
+            object.AccessPosition() = Point{x, y, TerrainHeight(terrain, x, y) + 2 * radius};
+        }
+    }
+
+    if (parameters.soup_facets > 0) {
+        const Scene::MeshId soup = PushTriangleSoupMesh(
+            scene,
+            TriangleSoupParameters{.facets = parameters.soup_facets,
+                                   .extent = size / 8,
+                                   .facet_size = size / 400,
+                                   .seed = Mix(parameters.seed + 2)},
+            thread_pool);
+        if (soup != Scene::kNoMesh) {
+            SceneObject& object = scene.AccessObject(scene.PushInstance(soup));
+            object.AccessPosition() = Point{0, 0, TerrainHeight(terrain, 0, 0) + size / 8};
+        }
+    }
+
+    scene.PushLight(AmbientLight{});
+    scene.PushLight(DirectionalLight{.strength = 0.6, .direction = {1, 1, -2}});
+    PushLightGrid(scene, LightGridParameters{.rows = parameters.light_rows,
+                                             .columns = parameters.light_columns,
+                                             .spacing = size / (parameters.light_columns + 1),
+                                             .height = size / 8,
+                                             .strength = 1,
+                                             .seed = Mix(parameters.seed + 3)});
+
+    return scene.PushCamera(Camera{Point{-size / 2, -size / 2, size / 4}, 45, -20});
+}
+
+}  // namespace renderer::utils
@@ -0,0 +1,414 @@
+/**
+ * @file
+ * @brief Процедурная генерация сцен для нагрузочного тестирования
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "renderer/resources_manager.hpp"
+#include "renderer/scene.hpp"
+#include "renderer/thread_pool.hpp"
+
+namespace renderer {
+namespace utils {
+
+/**
+ * @brief Параметры плоской сетки
+ *
+ * Сетка - квадрат в плоскости XZ с центром в начале координат, обращенный к -Y. Количество граней
+ * 2 * cells^2
+ */
+struct GridParameters {
+    /**
+     * Количество ячеек вдоль стороны
+     */
+    size_t cells = 16;
+    /**
+     * Длина стороны
+     */
+    float size = 4;
+    /**
+     * Сколько раз текстура повторяется вдоль стороны
+     */
+    float uv_repeat = 1;
+    /**
+     * Материал граней
+     */
+    MaterialId material = 0;
+};
+
+/**
+ * @brief Параметры ландшафта
+ *
+ * Ландшафт - квадратная сетка в плоскости XY с центром в начале координат, высоты вершин задаются
+ * шумом значений. Количество граней 2 * cells^2
+ */
+struct TerrainParameters {
+    /**
+     * Количество ячеек вдоль стороны
+     */
+    size_t cells = 256;
+    /**
+     * Длина стороны
+     */
+    float size = 100;
+    /**
+     * Максимальная высота
+     */
+    float height = 10;
+    /**
+     * Количество октав шума
+     */
+    size_t octaves = 4;
+    /**
+     * Зерно генерации
+     */
+    uint64_t seed = 1;
+    /**
+     * Материал граней
+     */
+    MaterialId material = 0;
+};
+
+/**
+ * @brief Параметры сферы
+ *
+ * Сфера строится разбиением граней икосаэдра, количество граней 20 * 4^subdivisions
+ */
+struct SphereParameters {
+    /**
+     * Количество уровней разбиения
+     */
+    size_t subdivisions = 4;
+    /**
+     * Радиус
+     */
+    float radius = 1;
+    /**
+     * Материал граней
+     */
+    MaterialId material = 0;
+};
+
+/**
+ * @brief Параметры набора случайных граней
+ */
+struct TriangleSoupParameters {
+    /**
+     * Количество граней
+     */
+    size_t facets = 1 << 16;
+    /**
+     * Длина стороны куба с центром в начале координат, в котором лежат центры граней
+     */
+    float extent = 100;
+    /**
+     * Максимальное отклонение вершин грани от ее центра
+     */
+    float facet_size = 1;
+    /**
+     * Зерно генерации
+     */
+    uint64_t seed = 1;
+    /**
+     * Материал граней
+     */
+    MaterialId material = 0;
+};
+
+/**
+ * @brief Параметры леса
+ *
+ * Лес - экземпляры одной сетки дерева (ствол и конусообразная крона), случайно расставленные на
+ * квадрате со стороной area с центром в начале координат. Сетка дерева содержит 4 * segments
+ * граней
+ */
+struct ForestParameters {
+    /**
+     * Количество деревьев
+     */
+    size_t trees = 10000;
+    /**
+     * Длина стороны квадрата
+     */
+    float area = 100;
+    /**
+     * Высота дерева до масштабирования
+     */
+    float tree_height = 3;
+    /**
+     * Количество боковых граней ствола и кроны
+     */
+    size_t segments = 8;
+    /**
+     * Зерно генерации
+     */
+    uint64_t seed = 1;
+    /**
+     * Ландшафт, на который ставятся деревья, или nullptr для плоскости z = 0
+     */
+    const TerrainParameters* terrain = nullptr;
+    /**
+     * Материал ствола
+     */
+    MaterialId trunk_material = 0;
+    /**
+     * Материал кроны
+     */
+    MaterialId crown_material = 0;
+};
+
+/**
+ * @brief Параметры сетки источников света
+ *
+ * Точечные источники расставляются сеткой rows x columns с центром над началом координат
+ */
+struct LightGridParameters {
+    size_t rows = 4;
+    size_t columns = 4;
+    /**
+     * Расстояние между соседними источниками
+     */
+    float spacing = 10;
+    /**
+     * Высота источников
+     */
+    float height = 10;
+    /**
+     * Яркость каждого источника
+     */
+    float strength = 1;
+    /**
+     * Зерно генерации цветов
+     */
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief Параметры сцены с текстурированной сеткой
+ *
+ * Шахматная текстура с градиентом в светлых клетках, повторяющаяся uv_repeat раз вдоль стороны
+ * сетки со стороной 4
+ */
+struct TexturedSceneParameters {
+    /**
+     * Размер стороны текстуры в пикселях
+     */
+    size_t texture_size = 1024;
+    /**
+     * Размер стороны клетки в пикселях
+     */
+    size_t checker_size = 32;
+    /**
+     * Количество ячеек сетки вдоль стороны
+     */
+    size_t cells = 32;
+    /**
+     * Сколько раз текстура повторяется вдоль стороны
+     */
+    float uv_repeat = 8;
+    /**
+     * Наклон сетки вокруг оси X в градусах
+     */
+    float x_angle = 0;
+};
+
+/**
+ * @brief Параметры нагрузочной сцены
+ */
+struct StressSceneParameters {
+    /**
+     * Зерно генерации
+     */
+    uint64_t seed = 1;
+    /**
+     * Длина стороны сцены
+     */
+    float size = 200;
+    /**
+     * Количество ячеек ландшафта вдоль стороны
+     */
+    size_t terrain_cells = 512;
+    /**
+     * Количество деревьев
+     */
+    size_t trees = 10000;
+    /**
+     * Количество боковых граней деревьев
+     */
+    size_t tree_segments = 8;
+    /**
+     * Количество экземпляров сферы
+     */
+    size_t spheres = 16;
+    /**
+     * Уровень разбиения сферы
+     */
+    size_t sphere_subdivisions = 5;
+    /**
+     * Количество случайных граней, 0 - без них
+     */
+    size_t soup_facets = 0;
+    /**
+     * Размеры сетки источников света
+     */
+    size_t light_rows = 4;
+    size_t light_columns = 4;
+};
+
+/**
+ * @brief Высота ландшафта
+ *
+ * Возвращает высоту ландшафта с переданными параметрами в точке (x, y). Вне ландшафта шум
+ * продолжается
+ *
+ * @param[in] parameters Параметры ландшафта
+ * @param[in] x Координата x
+ * @param[in] y Координата y
+ *
+ * @return Высота
+ */
+float TerrainHeight(const TerrainParameters& parameters, const float x, const float y);
+
+/**
+ * @brief Добавление сетки ландшафта
+ *
+ * Грани записываются прямо в хранилище сцены, вершины считаются параллельно в ThreadPool
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры ландшафта
+ * @param[in] thread_pool ThreadPool для генерации
+ *
+ * @return ID сетки или Scene::kNoMesh, если сетка не помещается в бюджет сцены
+ */
+Scene::MeshId PushTerrainMesh(Scene& scene, const TerrainParameters& parameters,
+                              ThreadPool& thread_pool = ThreadPool::Get());
+
+/**
+ * @brief Добавление сетки сферы с центром в начале координат
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры сферы
+ * @param[in] thread_pool ThreadPool для генерации
+ *
+ * @return ID сетки или Scene::kNoMesh, если сетка не помещается в бюджет сцены
+ */
+Scene::MeshId PushSphereMesh(Scene& scene, const SphereParameters& parameters,
+                             ThreadPool& thread_pool = ThreadPool::Get());
+
+/**
+ * @brief Добавление сетки из случайных граней
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры граней
+ * @param[in] thread_pool ThreadPool для генерации
+ *
+ * @return ID сетки или Scene::kNoMesh, если сетка не помещается в бюджет сцены
+ */
+Scene::MeshId PushTriangleSoupMesh(Scene& scene, const TriangleSoupParameters& parameters,
+                                   ThreadPool& thread_pool = ThreadPool::Get());
+
+/**
+ * @brief Добавление леса
+ *
+ * Добавляет сетку дерева и trees ее экземпляров со случайными положением, поворотом вокруг
+ * вертикали и масштабом
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры леса
+ *
+ * @return ID сетки дерева или Scene::kNoMesh, если сетка не помещается в бюджет сцены. В
+ * последнем случае деревья не добавляются
+ */
+Scene::MeshId PushForest(Scene& scene, const ForestParameters& parameters);
+
+/**
+ * @brief Добавление сетки точечных источников света
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры сетки
+ */
+void PushLightGrid(Scene& scene, const LightGridParameters& parameters);
+
+/**
+ * @brief Добавление плоской сетки
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры сетки
+ *
+ * @return ID сетки или Scene::kNoMesh, если сетка не помещается в бюджет сцены
+ */
+Scene::MeshId PushGridMesh(Scene& scene, const GridParameters& parameters);
+
+/**
+ * @brief Добавление стандартного освещения
+ *
+ * Фоновый свет, направленный и точечный источники
+ *
+ * @param[in,out] scene Сцена
+ */
+void PushDefaultLights(Scene& scene);
+
+/**
+ * @brief Добавление камеры в точке (0, -distance, 0), направленной вдоль +Y
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] distance Расстояние от начала координат
+ * @param[in] fov_x Угол обзора по горизонтали в градусах
+ *
+ * @return ID камеры
+ */
+Scene::CameraId PushFrontCamera(Scene& scene, const float distance, const float fov_x = 90);
+
+/**
+ * @brief Заполнение сцены с текстурированной сеткой
+ *
+ * Добавляет текстуру и материал в ResourcesManager, а в сцену - сетку с этим материалом и камеру
+ * на расстоянии 2 от ее центра. Источники света не добавляются
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры сцены
+ * @param[in,out] resources ResourcesManager для текстуры и материала
+ *
+ * @return ID камеры
+ */
+Scene::CameraId PushTexturedScene(Scene& scene, const TexturedSceneParameters& parameters,
+                                  ResourcesManager& resources = ResourcesManager::Get());
+
+/**
+ * @brief Заполнение сцены с камерой внутри коробки
+ *
+ * Добавляет 6 экземпляров двусторонней сетки - стенки куба со стороной 6 с центром в начале
+ * координат - и камеру внутри него, поэтому почти каждая видимая грань обрезается пирамидой
+ * зрения. Источники света не добавляются
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] cells Количество ячеек стенки вдоль стороны
+ * @param[in,out] resources ResourcesManager для материала стенок
+ *
+ * @return ID камеры
+ */
+Scene::CameraId PushClippingScene(Scene& scene, const size_t cells,
+                                  ResourcesManager& resources = ResourcesManager::Get());
+
+/**
+ * @brief Заполнение нагрузочной сцены
+ *
+ * Добавляет в сцену ландшафт, лес на нем, кольцо сфер, случайные грани над центром, сетку
+ * точечных источников, фоновый и направленный свет, а также камеру, обозревающую сцену. При
+ * одинаковых параметрах результат не зависит от платформы и количества потоков. Сетки, не
+ * поместившиеся в бюджет сцены, пропускаются
+ *
+ * @param[in,out] scene Сцена
+ * @param[in] parameters Параметры сцены
+ * @param[in] thread_pool ThreadPool для генерации
+ *
+ * @return ID камеры
+ */
+Scene::CameraId PushStressScene(Scene& scene, const StressSceneParameters& parameters,
+                                ThreadPool& thread_pool = ThreadPool::Get());
+
+};  // namespace utils
+};  // namespace renderer
@@ -4,19 +4,35 @@
 
 namespace renderer {
 
-SceneObject::SceneObject(const size_t begin, const size_t size, const Point& position,
-                         const float x_angle, const float y_angle, const float z_angle,
-                         const float scale)
+SceneObject::SceneObject(const size_t mesh, const size_t begin, const size_t size,
+                         const Point& position, const float x_angle, const float y_angle,
+                         const float z_angle, const float scale)
     : position_{position},
       x_angle_{x_angle},
       y_angle_{y_angle},
       z_angle_{z_angle},
       scale_{scale},
+      mesh_{mesh},
       begin_{begin},
       size_{size} {
 }
 
 Matrix SceneObject::GetObjectMatrix() const {
+    if (dirty_) {
+        return ComputeObjectMatrix();
+    }
+    return local_matrix_;
+}
+
+bool SceneObject::IsDirty() const {
+    return dirty_;
+}
+
+size_t SceneObject::GetParent() const {
+    return parent_;
+}
+
+Matrix SceneObject::ComputeObjectMatrix() const {
     Matrix object_matrix{1};
     object_matrix = glm::translate(object_matrix, position_);
     object_matrix = glm::rotate(object_matrix, glm::radians(x_angle_), Vector{1, 0, 0});
@@ -27,6 +43,7 @@ Matrix SceneObject::GetObjectMatrix() const {
 }
 
 Point& SceneObject::AccessPosition() {
+    dirty_ = true;
     return position_;
 }
 
@@ -35,6 +52,7 @@ const Point& SceneObject::AccessPosition() const {
 }
 
 float& SceneObject::AccessXAngle() {
+    dirty_ = true;
     return x_angle_;
 }
 
@@ -43,6 +61,7 @@ const float& SceneObject::AccessXAngle() const {
 }
 
 float& SceneObject::AccessYAngle() {
+    dirty_ = true;
     return y_angle_;
 }
 
@@ -51,6 +70,7 @@ const float& SceneObject::AccessYAngle() const {
 }
 
 float& SceneObject::AccessZAngle() {
+    dirty_ = true;
     return z_angle_;
 }
 
@@ -59,6 +79,7 @@ const float& SceneObject::AccessZAngle() const {
 }
 
 float& SceneObject::AccessScale() {
+    dirty_ = true;
     return scale_;
 }
 
@@ -66,6 +87,10 @@ const float& SceneObject::AccessScale() const {
     return scale_;
 }
 
+size_t SceneObject::Mesh() const {
+    return mesh_;
+}
+
 size_t SceneObject::Begin() const {
     return begin_;
 }
@@ -5,16 +5,27 @@
 
 #pragma once
 
+#include <limits>
+
 #include "renderer/types.hpp"
 
 namespace renderer {
 
+class Scene;
+
 /**
  * @brief Класс с информацией о положении объекта в сцене, его трансформации и расположении граней в
  * хранилище сцены
  */
 class SceneObject {
 public:
+    /**
+     * @brief Отсутствие родителя
+     *
+     * Значение ID родителя у объектов, не имеющих родителя
+     */
+    static constexpr size_t kNoParent = std::numeric_limits<size_t>::max();
+
     /**
      * @brief Создание SceneObject
      *
@@ -26,6 +37,7 @@ public:
      * - Углы поворота вокруг всех осей равны 0
      * - Масштаб 1
      *
+     * @param[in] mesh ID сетки, экземпляром которой является объект
      * @param[in] begin Индекс начала граней объекта в хранилище сцены
      * @param[in] size Количество граней
      * @param[in] position Начальная позиция объекта
@@ -34,9 +46,9 @@ public:
      * @param[in] z_angle Начальный поворот вокруг оси z
      * @param[in] scale Начальный масштаб
      */
-    SceneObject(const size_t begin, const size_t size, const Point& position = Point{0, 0, 0},
-                const float x_angle = 0, const float y_angle = 0, const float z_angle = 0,
-                const float scale = 1);
+    SceneObject(const size_t mesh, const size_t begin, const size_t size,
+                const Point& position = Point{0, 0, 0}, const float x_angle = 0,
+                const float y_angle = 0, const float z_angle = 0, const float scale = 1);
 
     /**
      * @brief Матрица перевода координат объекта в координаты сцены
@@ -49,14 +61,38 @@ public:
      * - Объект поворачивается вокруг координатных осей объекта на заданные углы
      * - Начало координат переносится в заданную точку
      *
+     * Матрица кэшируется и пересчитывается только после изменения объекта через неконстантные
+     * методы Access*. Для объекта с родителем матрица задает положение относительно родителя,
+     * итоговая матрица возвращается Scene::GetWorldMatrix
+     *
      * @return Матрица перевода координат
      */
     Matrix GetObjectMatrix() const;
 
+    /**
+     * @brief Проверка изменения объекта
+     *
+     * Объект считается измененным после вызова любого неконстантного метода Access* и до
+     * пересчета матриц в Scene::UpdateTransforms
+     *
+     * @return Изменялся ли объект
+     */
+    bool IsDirty() const;
+
+    /**
+     * @brief ID родителя
+     *
+     * Возвращает ID родительского объекта в сцене или SceneObject::kNoParent. Родитель задается
+     * с помощью Scene::SetParent
+     *
+     * @return ID родителя
+     */
+    size_t GetParent() const;
+
     /**
      * @brief Доступ к позиции
      *
-     * Возвращает ссылку на позицию объекта
+     * Возвращает ссылку на позицию объекта и помечает объект измененным
      *
      * @return Ссылка на позицию объекта
      */
@@ -74,7 +110,7 @@ public:
     /**
      * @brief Доступ к углу X
      *
-     * Возвращает ссылку на угол объекта по оси X
+     * Возвращает ссылку на угол объекта по оси X и помечает объект измененным
      *
      * @return Ссылка на угол X
      */
@@ -92,7 +128,7 @@ public:
     /**
      * @brief Доступ к углу Y
      *
-     * Возвращает ссылку на угол объекта по оси Y
+     * Возвращает ссылку на угол объекта по оси Y и помечает объект измененным
      *
      * @return Ссылка на угол Y
      */
@@ -110,7 +146,7 @@ public:
     /**
      * @brief Доступ к углу Z
      *
-     * Возвращает ссылку на угол объекта по оси Z
+     * Возвращает ссылку на угол объекта по оси Z и помечает объект измененным
      *
      * @return Ссылка на угол Z
      */
@@ -128,7 +164,7 @@ public:
     /**
      * @brief Доступ к масштабу
      *
-     * Возвращает ссылку на масштаб объекта
+     * Возвращает ссылку на масштаб объекта и помечает объект измененным
      *
      * @return Ссылка на масштаб
      */
@@ -143,10 +179,21 @@ public:
      */
     const float& AccessScale() const;
 
+    /**
+     * @brief ID сетки объекта
+     *
+     * Возвращает ID сетки сцены, экземпляром которой является объект. Объекты с одинаковой сеткой
+     * используют одни и те же грани в хранилище сцены
+     *
+     * @return ID сетки
+     */
+    size_t Mesh() const;
+
     /**
      * @brief Индекс начала граней объекта
      *
-     * Возвращает индекс начала граней объекта
+     * Возвращает индекс начала граней объекта. Индекс может измениться после уплотнения хранилища
+     * граней в Scene::ApplyCompaction
      *
      * @return Индекс начала граней объекта
      */
@@ -162,13 +209,28 @@ public:
     size_t Size() const;
 
 private:
+    friend class Scene;
+
+    /**
+     * @brief Вычисление матрицы объекта
+     *
+     * Вычисляет матрицу перевода координат объекта без использования кэша
+     */
+    Matrix ComputeObjectMatrix() const;
+
     Point position_{0, 0, 0};
     float x_angle_{0};
     float y_angle_{0};
     float z_angle_{0};
     float scale_{1};
+    size_t mesh_;
     size_t begin_;
     size_t size_;
+    size_t parent_{kNoParent};
+    size_t children_count_{0};  // количество объектов, для которых этот объект - родитель
+    Matrix local_matrix_{1};  // кэш GetObjectMatrix, действителен при dirty_ == false
+    Matrix world_matrix_{1};  // кэш матрицы в координатах сцены, обновляется Scene
+    bool dirty_{true};
 };
 
 };  // namespace renderer
@@ -0,0 +1,45 @@
+#include "renderer/task.hpp"
+
+#include <cassert>
+
+namespace renderer {
+
+Task::Task(Task&& other) noexcept : operations_{other.operations_} {
+    if (operations_ != nullptr) {
+        operations_->move(other.storage_, storage_);
+        other.operations_ = nullptr;
+    }
+}
+
+Task& Task::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (operations_ != nullptr) {
+            operations_->destroy(storage_);
+        }
+        operations_ = other.operations_;
+        if (operations_ != nullptr) {
+            operations_->move(other.storage_, storage_);
+            other.operations_ = nullptr;
+        }
+    }
+    return *this;
+}
+
+Task::~Task() {
+    if (operations_ != nullptr) {
+        operations_->destroy(storage_);
+    }
+}
+
+void Task::operator()() {
+    {
+        assert((operations_ != nullptr) and "Task: задача не должна быть пустой");
+    }
+    operations_->invoke(storage_);
+}
+
+Task::operator bool() const {
+    return operations_ != nullptr;
+}
+
+}  // namespace renderer
@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief Задача для ThreadPool
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace renderer {
+
+/**
+ * @brief Задача для ThreadPool
+ *
+ * Перемещаемая обертка над вызываемым объектом без аргументов, аналог std::function без
+ * копирования. Объекты размером не больше Task::kInlineSize с перемещающим конструктором noexcept
+ * хранятся внутри задачи без выделения памяти, остальные - в куче
+ */
+class Task {
+public:
+    /**
+     * @brief Размер встроенного буфера
+     *
+     * Лямбда-функция, захватывающая до 6 указателей или ссылок, хранится без выделения памяти
+     */
+    static constexpr size_t kInlineSize = 6 * sizeof(void*);
+
+    /**
+     * @brief Создание пустой задачи
+     */
+    Task() = default;
+
+    /**
+     * @brief Создание задачи из вызываемого объекта
+     *
+     * @param[in] function Вызываемый объект без аргументов
+     */
+    template <class Function>
+        requires(not std::is_same_v<std::decay_t<Function>, Task> and
+                 std::is_invocable_v<std::decay_t<Function>&>)
+    Task(Function&& function) {
+        using Stored = std::decay_t<Function>;
+        if constexpr (kFitsInline<Stored>) {
+            new (storage_) Stored(std::forward<Function>(function));
+            operations_ = &kInlineOperations<Stored>;
+        } else {
+            *reinterpret_cast<Stored**>(storage_) = new Stored(std::forward<Function>(function));
+            operations_ = &kHeapOperations<Stored>;
+        }
+    }
+
+    Task(const Task& other) = delete;
+    Task& operator=(const Task& other) = delete;
+
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+
+    ~Task();
+
+    /**
+     * @brief Выполнение задачи
+     *
+     * Требуется, чтобы задача была не пустой
+     */
+    void operator()();
+
+    /**
+     * @brief Проверка на пустоту
+     *
+     * @return Содержит ли задача вызываемый объект
+     */
+    explicit operator bool() const;
+
+private:
+    /**
+     * @brief Операции над хранимым объектом
+     */
+    struct Operations {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to);  // перемещение с разрушением исходного объекта
+        void (*destroy)(void* storage);
+    };
+
+    template <class Stored>
+    static constexpr bool kFitsInline = sizeof(Stored) <= kInlineSize and
+                                        alignof(Stored) <= alignof(std::max_align_t) and
+                                        std::is_nothrow_move_constructible_v<Stored>;
+
+    template <class Stored>
+    static constexpr Operations kInlineOperations{
+        .invoke = [](void* storage) { (*static_cast<Stored*>(storage))(); },
+        .move =
+            [](void* from, void* to) {
+                new (to) Stored(std::move(*static_cast<Stored*>(from)));
+                static_cast<Stored*>(from)->~Stored();
+            },
+        .destroy = [](void* storage) { static_cast<Stored*>(storage)->~Stored(); }};
+
+    template <class Stored>
+    static constexpr Operations kHeapOperations{
+        .invoke = [](void* storage) { (**static_cast<Stored**>(storage))(); },
+        .move =
+            [](void* from, void* to) {
+                *static_cast<Stored**>(to) = *static_cast<Stored**>(from);
+            },
+        .destroy = [](void* storage) { delete *static_cast<Stored**>(storage); }};
+
+    alignas(std::max_align_t) std::byte storage_[kInlineSize];
+    const Operations* operations_ = nullptr;
+};
+
+};  // namespace renderer
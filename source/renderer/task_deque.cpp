@@ -0,0 +1,90 @@
+#include "renderer/task_deque.hpp"
+
+#include <bit>
+
+namespace renderer {
+
+TaskDeque::Buffer::Buffer(const size_t capacity)
+    : mask{capacity - 1}, items{std::make_unique<std::atomic<Item>[]>(capacity)} {
+}
+
+TaskDeque::Item TaskDeque::Buffer::Get(const int64_t index) const {
+    return items[index & mask].load(std::memory_order_relaxed);
+}
+
+void TaskDeque::Buffer::Put(const int64_t index, const Item item) {
+    items[index & mask].store(item, std::memory_order_relaxed);
+}
+
+TaskDeque::TaskDeque(const size_t capacity) {
+    buffers_.push_back(std::make_unique<Buffer>(std::bit_ceil(std::max<size_t>(capacity, 2))));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+void TaskDeque::Push(const Item item) {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    if (static_cast<size_t>(bottom - top) > buffer->mask) {
+        buffer = Grow(buffer, top, bottom);
+    }
+    buffer->Put(bottom, item);
+    bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+TaskDeque::Item TaskDeque::Pop() {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        // очередь пуста
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Item item = buffer->Get(bottom);
+    if (top == bottom) {
+        // последняя задача, возможна гонка с перехватывающим потоком
+        if (not top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+TaskDeque::Item TaskDeque::Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Buffer* buffer = buffer_.load(std::memory_order_acquire);
+    Item item = buffer->Get(top);
+    if (not top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+size_t TaskDeque::SizeEstimate() const {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+}
+
+TaskDeque::Buffer* TaskDeque::Grow(Buffer* buffer, const int64_t top, const int64_t bottom) {
+    buffers_.push_back(std::make_unique<Buffer>((buffer->mask + 1) * 2));
+    Buffer* new_buffer = buffers_.back().get();
+    for (int64_t i = top; i < bottom; ++i) {
+        new_buffer->Put(i, buffer->Get(i));
+    }
+    buffer_.store(new_buffer, std::memory_order_release);
+    return new_buffer;
+}
+
+}  // namespace renderer
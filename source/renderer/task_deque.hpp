@@ -0,0 +1,100 @@
+/**
+ * @file
+ * @brief Очередь задач потока ThreadPool
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "renderer/task.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Очередь задач с перехватом
+ *
+ * Неблокирующий дек Chase-Lev (Chase, Lev, 2005; Lê и др., 2013). Владелец добавляет и забирает
+ * задачи с одного конца (LIFO), остальные потоки перехватывают задачи с другого конца (FIFO).
+ * Методы Push и Pop может вызывать только поток-владелец, Steal - любой поток. Очередь хранит
+ * указатели и не владеет задачами
+ */
+class TaskDeque {
+public:
+    /**
+     * @brief Элемент очереди
+     */
+    using Item = Task*;
+
+    /**
+     * @brief Создание очереди
+     *
+     * @param[in] capacity Начальная вместимость, округляется вверх до степени двойки
+     */
+    explicit TaskDeque(const size_t capacity = 256);
+
+    TaskDeque(const TaskDeque& other) = delete;
+    TaskDeque& operator=(const TaskDeque& other) = delete;
+
+    /**
+     * @brief Добавление задачи владельцем
+     *
+     * При заполнении вместимость удваивается
+     *
+     * @param[in] item Задача
+     */
+    void Push(const Item item);
+
+    /**
+     * @brief Извлечение последней добавленной задачи владельцем
+     *
+     * @return Задача или nullptr, если очередь пуста
+     */
+    Item Pop();
+
+    /**
+     * @brief Перехват первой задачи другим потоком
+     *
+     * @return Задача или nullptr, если очередь пуста или задачу забрал другой поток
+     */
+    Item Steal();
+
+    /**
+     * @brief Оценка количества задач
+     *
+     * Значение может устареть к моменту использования
+     *
+     * @return Количество задач
+     */
+    size_t SizeEstimate() const;
+
+private:
+    /**
+     * @brief Кольцевой буфер задач
+     */
+    struct Buffer {
+        explicit Buffer(const size_t capacity);
+
+        Item Get(const int64_t index) const;
+        void Put(const int64_t index, const Item item);
+
+        size_t mask;
+        std::unique_ptr<std::atomic<Item>[]> items;
+    };
+
+    /**
+     * @brief Увеличение вместимости вдвое
+     */
+    Buffer* Grow(Buffer* buffer, const int64_t top, const int64_t bottom);
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_;
+    // все буферы хранятся до разрушения очереди, так как их может читать перехватывающий поток
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+};  // namespace renderer
@@ -0,0 +1,92 @@
+#include "renderer/task_group.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Количество попыток дождаться задач активно перед засыпанием
+ */
+constexpr size_t kSpinIterations = 64;
+
+}  // namespace
+
+struct TaskGroup::State {
+    /**
+     * @brief Выполнение очередной задачи группы
+     *
+     * @return Была ли выполнена задача
+     */
+    bool RunOne() {
+        Task task;
+        {
+            std::unique_lock lock{mutex};
+            if (tasks.empty()) {
+                return false;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+        // захваченные данные разрушаются до уменьшения счетчика, иначе Wait может вернуть
+        // управление, пока они еще разрушаются
+        task = Task{};
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pending.notify_all();
+        }
+        return true;
+    }
+
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::atomic<size_t> pending{0};  // добавленные и еще не выполненные задачи
+};
+
+TaskGroup::TaskGroup(ThreadPool& thread_pool)
+    : thread_pool_{thread_pool}, state_{std::make_shared<State>()} {
+}
+
+TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+void TaskGroup::Run(Task&& task) {
+    state_->pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::unique_lock lock{state_->mutex};
+        state_->tasks.push_back(std::move(task));
+    }
+    // билет владеет состоянием, так как может быть выполнен уже после разрушения группы
+    thread_pool_.Enqueue([state = state_]() { state->RunOne(); });
+}
+
+void TaskGroup::Wait() {
+    size_t idle_iterations = 0;
+    while (true) {
+        size_t pending = state_->pending.load(std::memory_order_acquire);
+        if (pending == 0) {
+            return;
+        }
+        if (state_->RunOne()) {
+            idle_iterations = 0;
+            continue;
+        }
+        if (++idle_iterations < kSpinIterations) {
+            std::this_thread::yield();
+            continue;
+        }
+        state_->pending.wait(pending, std::memory_order_acquire);
+        idle_iterations = 0;
+    }
+}
+
+size_t TaskGroup::PendingTasks() const {
+    return state_->pending.load(std::memory_order_relaxed);
+}
+
+}  // namespace renderer
@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @brief Группа задач ThreadPool
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "renderer/task.hpp"
+#include "renderer/thread_pool.hpp"
+
+namespace renderer {
+
+/**
+ * @brief Группа задач
+ *
+ * Набор задач ThreadPool, завершения которых можно дождаться независимо от остальных задач
+ * ThreadPool. Задачи группы хранятся в ее собственной очереди, а в ThreadPool для каждой задачи
+ * добавляется легкая задача-билет, которая выполняет очередную задачу группы. Поток, ожидающий
+ * группу, сам выполняет ее задачи, поэтому ожидание не зависит от загрузки ThreadPool чужими
+ * задачами и может вызываться из задач ThreadPool
+ *
+ * Методы группы можно вызывать из разных потоков одновременно. Разрушение группы дожидается
+ * завершения ее задач
+ */
+class TaskGroup {
+public:
+    /**
+     * @brief Создание группы
+     *
+     * @param[in] thread_pool ThreadPool, потоки которого выполняют задачи группы
+     */
+    explicit TaskGroup(ThreadPool& thread_pool = ThreadPool::Get());
+
+    TaskGroup(const TaskGroup& other) = delete;
+    TaskGroup(TaskGroup&& other) = delete;
+
+    TaskGroup& operator=(const TaskGroup& other) = delete;
+    TaskGroup& operator=(TaskGroup&& other) = delete;
+
+    ~TaskGroup();
+
+    /**
+     * @brief Добавление задачи в группу
+     *
+     * @param[in] task Задача
+     */
+    void Run(Task&& task);
+
+    /**
+     * @brief Ожидание выполнения задач группы
+     *
+     * Возвращает управление, когда выполнены все задачи, добавленные в группу до завершения
+     * ожидания. Пока в очереди группы есть задачи, вызвавший поток выполняет их сам, после чего
+     * ждет завершения задач, уже взятых другими потоками
+     */
+    void Wait();
+
+    /**
+     * @brief Количество невыполненных задач
+     *
+     * Значение может устареть к моменту использования
+     *
+     * @return Количество добавленных и еще не выполненных задач
+     */
+    size_t PendingTasks() const;
+
+private:
+    /**
+     * @brief Общее состояние группы и ее задач-билетов
+     */
+    struct State;
+
+    ThreadPool& thread_pool_;
+    std::shared_ptr<State> state_;
+};
+
+};  // namespace renderer
@@ -1,8 +1,229 @@
 #include "thread_pool.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <string>
+
+#include "renderer/numa.hpp"
+#include "renderer/trace.hpp"
+
 namespace renderer {
 
+namespace {
+
+/**
+ * @brief Количество узлов задач, передаваемых между потоками за раз
+ */
+constexpr size_t kNodesBatchSize = 256;
+
+/**
+ * @brief Узел задачи в очередях ThreadPool
+ */
+struct TaskNode : Task {
+    int64_t enqueue_time = 0;  // время добавления для метрик, 0 - не замерялось
+};
+
+/**
+ * @brief Узлы задач, освобожденные одними потоками для использования другими
+ *
+ * Задачи обычно создаются одним потоком, а выполняются и освобождаются другими, поэтому
+ * освобожденные узлы возвращаются в общий список пачками
+ */
+struct NodesBatches {
+    ~NodesBatches() {
+        for (std::vector<TaskNode*>& batch : batches) {
+            for (TaskNode* node : batch) {
+                delete node;
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<std::vector<TaskNode*>> batches;
+};
+
+NodesBatches nodes_batches;
+
+/**
+ * @brief Кэш свободных узлов задач потока
+ */
+struct NodesCache {
+    ~NodesCache() {
+        for (TaskNode* node : nodes) {
+            delete node;
+        }
+    }
+
+    std::vector<TaskNode*> nodes;
+};
+
+thread_local NodesCache nodes_cache;
+
+/**
+ * @brief Получение свободного узла задачи
+ */
+TaskNode* AcquireNode() {
+    std::vector<TaskNode*>& nodes = nodes_cache.nodes;
+    if (nodes.empty()) {
+        std::unique_lock lock{nodes_batches.mutex};
+        if (not nodes_batches.batches.empty()) {
+            nodes = std::move(nodes_batches.batches.back());
+            nodes_batches.batches.pop_back();
+        }
+    }
+    if (nodes.empty()) {
+        return new TaskNode;
+    }
+    TaskNode* node = nodes.back();
+    nodes.pop_back();
+    return node;
+}
+
+/**
+ * @brief Возврат узла выполненной задачи
+ */
+void ReleaseNode(TaskNode* node) {
+    *node = TaskNode{};
+    std::vector<TaskNode*>& nodes = nodes_cache.nodes;
+    nodes.push_back(node);
+    if (nodes.size() >= 2 * kNodesBatchSize) {
+        std::vector<TaskNode*> batch(nodes.end() - kNodesBatchSize, nodes.end());
+        nodes.resize(nodes.size() - kNodesBatchSize);
+        std::unique_lock lock{nodes_batches.mutex};
+        nodes_batches.batches.push_back(std::move(batch));
+    }
+}
+
+/**
+ * @brief Общее состояние параллельного цикла
+ *
+ * Принадлежит вызвавшему потоку и задачам-помощникам, так как помощники могут начать работу
+ * уже после завершения цикла
+ */
+struct ParallelForState {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    size_t parts;
+    void (*function)(void* context, const size_t begin, const size_t end);
+    void* context;
+    std::atomic<size_t> next_part{0};
+    std::atomic<size_t> completed_parts{0};
+
+    /**
+     * @brief Обработка частей, пока они есть
+     */
+    void Run() {
+        while (true) {
+            const size_t part = next_part.fetch_add(1, std::memory_order_relaxed);
+            if (part >= parts) {
+                return;
+            }
+            const size_t part_begin = begin + part * grain;
+            function(context, part_begin, std::min(part_begin + grain, end));
+            if (completed_parts.fetch_add(1, std::memory_order_acq_rel) + 1 == parts) {
+                completed_parts.notify_all();
+            }
+        }
+    }
+};
+
+/**
+ * @brief Количество попыток найти задачу перед засыпанием
+ */
+constexpr size_t kSpinIterations = 64;
+
+/**
+ * @brief ThreadPool, которому принадлежит текущий поток, или nullptr для других потоков
+ */
+thread_local const ThreadPool* current_pool = nullptr;
+
+/**
+ * @brief Номер текущего потока в current_pool
+ */
+thread_local size_t current_worker = 0;
+
+/**
+ * @brief Время steady_clock в наносекундах для метрик
+ */
+int64_t NowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Интервал гистограммы задержек
+ */
+size_t LatencyBucket(const int64_t latency) {
+    const size_t bucket = (latency > 0) ? std::bit_width(static_cast<uint64_t>(latency)) : 0;
+    return std::min(bucket, ThreadPool::kLatencyBuckets - 1);
+}
+
+/**
+ * @brief Перевод счетчиков в метрики
+ */
+template <class Counters>
+ThreadPool::WorkerMetrics ReadCounters(const Counters& counters) {
+    ThreadPool::WorkerMetrics metrics;
+    metrics.tasks_executed = counters.tasks_executed.load(std::memory_order_relaxed);
+    metrics.tasks_stolen = counters.tasks_stolen.load(std::memory_order_relaxed);
+    metrics.busy_time =
+        std::chrono::nanoseconds{counters.busy_time.load(std::memory_order_relaxed)};
+    metrics.idle_time =
+        std::chrono::nanoseconds{counters.idle_time.load(std::memory_order_relaxed)};
+    metrics.mutex_wait_time =
+        std::chrono::nanoseconds{counters.mutex_wait_time.load(std::memory_order_relaxed)};
+    return metrics;
+}
+
+/**
+ * @brief Генератор xorshift64 для выбора потока при перехвате
+ */
+uint64_t NextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+}  // namespace
+
+std::chrono::nanoseconds ThreadPool::Metrics::LatencyQuantile(const double fraction) const {
+    uint64_t total = 0;
+    for (const uint64_t count : latency_histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return std::chrono::nanoseconds{0};
+    }
+    const uint64_t rank = std::clamp(fraction, 0.0, 1.0) * (total - 1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+        seen += latency_histogram[bucket];
+        if (seen > rank) {
+            return std::chrono::nanoseconds{(bucket == 0) ? 0 : int64_t{1} << bucket};
+        }
+    }
+    return std::chrono::nanoseconds{int64_t{1} << (kLatencyBuckets - 1)};
+}
+
+void ThreadPool::Counters::Reset() {
+    tasks_executed.store(0, std::memory_order_relaxed);
+    tasks_stolen.store(0, std::memory_order_relaxed);
+    busy_time.store(0, std::memory_order_relaxed);
+    idle_time.store(0, std::memory_order_relaxed);
+    mutex_wait_time.store(0, std::memory_order_relaxed);
+    last_task_end.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>& count : latency) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
 size_t ThreadPool::k_threads = std::thread::hardware_concurrency();
+ThreadPool::Affinity ThreadPool::k_affinity;
+ThreadPool* ThreadPool::k_instance = nullptr;
 
 ThreadPool& ThreadPool::Get() {
     static ThreadPool instance;
@@ -15,66 +236,445 @@ void ThreadPool::SetThreadsCount(const size_t num_threads) {
     } else {
         k_threads = num_threads;
     }
+    if (k_instance != nullptr) {
+        k_instance->Resize(k_threads);
+    }
 }
 
 size_t ThreadPool::GetThreadsCount() {
     return k_threads;
 }
 
-void ThreadPool::Enqueue(std::function<void()>&& task) {
+void ThreadPool::SetAffinity(const Affinity& affinity) {
+    k_affinity = affinity;
+    if (k_instance != nullptr) {
+        k_instance->SetWorkersAffinity(affinity);
+    }
+}
+
+ThreadPool::Affinity ThreadPool::GetAffinity() {
+    return k_affinity;
+}
+
+size_t ThreadPool::CurrentWorker() {
+    return (current_pool != nullptr) ? current_worker : kNotWorker;
+}
+
+ThreadPool::ThreadPool(const size_t threads_count) : ThreadPool(threads_count, Affinity{}) {
+}
+
+ThreadPool::ThreadPool(const size_t threads_count, const Affinity& affinity)
+    : affinity_{affinity} {
+    StartWorkers(threads_count);
+}
+
+void ThreadPool::Resize(const size_t threads_count) {
+    {
+        assert((current_pool != this) and
+               "Resize: нельзя менять количество потоков из потока этого ThreadPool");
+    }
+    if (workers_.size() == std::max<size_t>(threads_count, 1)) {
+        return;
+    }
+    WaitAll();
+    StopWorkers();
+    StartWorkers(threads_count);
+}
+
+void ThreadPool::SetWorkersAffinity(const Affinity& affinity) {
+    affinity_ = affinity;
+    ApplyAffinity();
+}
+
+size_t ThreadPool::GetWorkersCount() const {
+    return workers_.size();
+}
+
+size_t ThreadPool::GetWorkerNode(const size_t worker) const {
     {
-        std::unique_lock lock{mutex_};
-        tasks_.push(task);
+        assert((worker < workers_.size()) and
+               "GetWorkerNode: номер потока должен быть меньше количества потоков");
+    }
+    return workers_[worker]->node;
+}
+
+void ThreadPool::EnableMetrics(const bool enabled) {
+    // простой до включения не учитывается
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        worker->counters.last_task_end.store(0, std::memory_order_relaxed);
+    }
+    metrics_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool ThreadPool::IsMetricsEnabled() const {
+    return metrics_enabled_.load(std::memory_order_relaxed);
+}
+
+ThreadPool::Metrics ThreadPool::GetMetrics() const {
+    Metrics metrics;
+    auto add_latency = [&metrics](const Counters& counters) {
+        for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+            metrics.latency_histogram[bucket] +=
+                counters.latency[bucket].load(std::memory_order_relaxed);
+        }
+    };
+    metrics.workers.reserve(workers_.size());
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        metrics.workers.push_back(ReadCounters(worker->counters));
+        add_latency(worker->counters);
     }
-    cv_task_.notify_one();
+    metrics.external = ReadCounters(external_counters_);
+    add_latency(external_counters_);
+    metrics.tasks_enqueued = tasks_enqueued_.load(std::memory_order_relaxed);
+    metrics.pending_tasks = pending_tasks_.load(std::memory_order_relaxed);
+    metrics.queue_high_water_mark = queue_high_water_mark_.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+void ThreadPool::ResetMetrics() {
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        worker->counters.Reset();
+    }
+    external_counters_.Reset();
+    tasks_enqueued_.store(0, std::memory_order_relaxed);
+    queue_high_water_mark_.store(0, std::memory_order_relaxed);
+}
+
+std::span<std::byte> ThreadPool::AccessScratch(const size_t bytes) {
+    thread_local std::unique_ptr<std::byte[]> external_scratch;
+    thread_local size_t external_scratch_size = 0;
+    std::unique_ptr<std::byte[]>* scratch = &external_scratch;
+    size_t* scratch_size = &external_scratch_size;
+    if (current_pool == this) {
+        Worker& worker = *workers_[current_worker];
+        scratch = &worker.scratch;
+        scratch_size = &worker.scratch_size;
+    }
+    if (*scratch_size < bytes) {
+        // память не инициализируется, страницы выделяются при первой записи этим потоком
+        *scratch = std::make_unique_for_overwrite<std::byte[]>(bytes);
+        *scratch_size = bytes;
+    }
+    return {scratch->get(), *scratch_size};
+}
+
+void ThreadPool::Enqueue(Task&& task) {
+    TaskNode* item = AcquireNode();
+    static_cast<Task&>(*item) = std::move(task);
+    const size_t pending = pending_tasks_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (metrics_enabled_.load(std::memory_order_relaxed)) {
+        item->enqueue_time = NowNanoseconds();
+        tasks_enqueued_.fetch_add(1, std::memory_order_relaxed);
+        size_t high_water_mark = queue_high_water_mark_.load(std::memory_order_relaxed);
+        while (pending > high_water_mark and
+               not queue_high_water_mark_.compare_exchange_weak(high_water_mark, pending,
+                                                                std::memory_order_relaxed)) {
+        }
+    }
+    if (current_pool == this) {
+        workers_[current_worker]->deque.Push(item);
+    } else {
+        Worker& worker =
+            *workers_[next_inbox_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+        std::unique_lock lock = LockInbox(worker, workers_.size());
+        worker.inbox.push_back(item);
+        worker.inbox_size.fetch_add(1, std::memory_order_release);
+    }
+    WakeOne();
 }
 
 void ThreadPool::WaitAll() {
-    std::unique_lock lock{mutex_};
-    cv_done_.wait(lock, [this]() { return tasks_.empty() and active_tasks_ == 0; });
+    const size_t index = LocalWorker();
+    size_t idle_iterations = 0;
+    while (true) {
+        size_t pending = pending_tasks_.load(std::memory_order_acquire);
+        if (pending == 0) {
+            return;
+        }
+        if (TaskDeque::Item task = FindTask(index)) {
+            RunTask(task, index);
+            idle_iterations = 0;
+            continue;
+        }
+        if (++idle_iterations < kSpinIterations) {
+            std::this_thread::yield();
+            continue;
+        }
+        // оставшиеся задачи выполняются другими потоками, уведомление приходит при обнулении
+        pending_tasks_.wait(pending, std::memory_order_acquire);
+        idle_iterations = 0;
+    }
+}
+
+void ThreadPool::ParallelForRange(const size_t begin, const size_t end, const size_t grain,
+                                  const RangeFunction function, void* context) {
+    if (begin >= end) {
+        return;
+    }
+    const size_t part_size = std::max<size_t>(grain, 1);
+    const size_t parts = (end - begin - 1) / part_size + 1;
+    if (parts == 1 or workers_.size() == 1) {
+        function(context, begin, end);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->begin = begin;
+    state->end = end;
+    state->grain = part_size;
+    state->parts = parts;
+    state->function = function;
+    state->context = context;
+    TraceScope trace{"ParallelFor"};
+    const size_t helpers = std::min(parts - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        Enqueue([state]() { state->Run(); });
+    }
+    state->Run();
+
+    size_t idle_iterations = 0;
+    size_t completed = state->completed_parts.load(std::memory_order_acquire);
+    while (completed < parts) {
+        if (++idle_iterations < kSpinIterations) {
+            std::this_thread::yield();
+        } else {
+            state->completed_parts.wait(completed, std::memory_order_acquire);
+        }
+        completed = state->completed_parts.load(std::memory_order_acquire);
+    }
 }
 
 ThreadPool::~ThreadPool() {
-    {
-        std::unique_lock lock{mutex_};
-        stop_ = true;
+    StopWorkers();
+    if (k_instance == this) {
+        k_instance = nullptr;
+    }
+}
+
+ThreadPool::ThreadPool() : ThreadPool(k_threads, k_affinity) {
+    k_instance = this;
+}
+
+void ThreadPool::StartWorkers(const size_t threads_count) {
+    // Tracer создается раньше глобального ThreadPool и разрушается после остановки его потоков
+    Tracer::Get();
+    const size_t count = std::max<size_t>(threads_count, 1);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->random_state = 0x9e3779b97f4a7c15ull * (i + 1);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        threads_.emplace_back([this, i]() { WorkerLoop(i); });
     }
-    cv_task_.notify_all();
-    for (auto& thread : workers_) {
+    if (affinity_.mode != Affinity::NONE) {
+        ApplyAffinity();
+    }
+}
+
+void ThreadPool::StopWorkers() {
+    stop_.store(true, std::memory_order_seq_cst);
+    wake_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    wake_epoch_.notify_all();
+    for (auto& thread : threads_) {
         thread.join();
     }
+    threads_.clear();
+    workers_.clear();
+    stop_.store(false, std::memory_order_seq_cst);
 }
 
-ThreadPool::ThreadPool() {
-    for (size_t i = 0; i < k_threads; ++i) {
-        workers_.emplace_back([this]() { WorkerLoop(); });
+void ThreadPool::ApplyAffinity() {
+    const std::vector<NumaNode> nodes = GetNumaNodes();
+    auto node_of_cpu = [&nodes](const size_t cpu) -> size_t {
+        for (const NumaNode& node : nodes) {
+            if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+                return node.id;
+            }
+        }
+        return 0;
+    };
+    const size_t count = workers_.size();
+    for (size_t i = 0; i < count; ++i) {
+        Worker& worker = *workers_[i];
+        if (affinity_.mode == Affinity::CORES and not affinity_.cores.empty()) {
+            const size_t cpu = affinity_.cores[i % affinity_.cores.size()];
+            SetThreadAffinity(threads_[i], std::span<const size_t>{&cpu, 1});
+            worker.node = node_of_cpu(cpu);
+        } else if (affinity_.mode == Affinity::NUMA_NODES) {
+            const NumaNode& node = nodes[i * nodes.size() / count];
+            SetThreadAffinity(threads_[i], node.cpus);
+            worker.node = node.id;
+        } else {
+            SetThreadAffinity(threads_[i], {});
+            worker.node = 0;
+        }
     }
 }
 
-void ThreadPool::WorkerLoop() {
+void ThreadPool::WorkerLoop(const size_t index) {
+    current_pool = this;
+    current_worker = index;
+    Tracer::SetThreadName("ThreadPool worker " + std::to_string(index));
+    size_t idle_iterations = 0;
     while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock lock{mutex_};
-            cv_task_.wait(lock, [this]() { return stop_ or (not tasks_.empty()); });
+        if (TaskDeque::Item task = FindTask(index)) {
+            RunTask(task, index);
+            idle_iterations = 0;
+            continue;
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (++idle_iterations < kSpinIterations) {
+            std::this_thread::yield();
+            continue;
+        }
 
-            if (stop_ and tasks_.empty()) {
-                return;
+        // засыпание: после регистрации спящим очереди проверяются повторно, чтобы не пропустить
+        // задачу, добавленную до увеличения sleeping_workers_
+        const uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        sleeping_workers_.fetch_add(1, std::memory_order_seq_cst);
+        TaskDeque::Item task = FindTask(index);
+        if (task == nullptr and not stop_.load(std::memory_order_seq_cst)) {
+            TraceScope trace{"Sleep"};
+            wake_epoch_.wait(epoch, std::memory_order_acquire);
+        }
+        sleeping_workers_.fetch_sub(1, std::memory_order_relaxed);
+        if (task != nullptr) {
+            RunTask(task, index);
+        }
+        idle_iterations = 0;
+    }
+}
+
+size_t ThreadPool::LocalWorker() const {
+    return (current_pool == this) ? current_worker : workers_.size();
+}
+
+TaskDeque::Item ThreadPool::FindTask(const size_t index) {
+    const bool is_worker = index < workers_.size();
+    if (is_worker) {
+        Worker& worker = *workers_[index];
+        if (TaskDeque::Item task = worker.deque.Pop()) {
+            return task;
+        }
+        if (worker.inbox_size.load(std::memory_order_acquire) > 0) {
+            if (TaskDeque::Item task = TakeFromInbox(worker, true, index)) {
+                return task;
             }
+        }
+    }
 
-            task = std::move(tasks_.front());
-            tasks_.pop();
-            ++active_tasks_;
+    thread_local uint64_t external_random_state = 0x2545f4914f6cdd1dull;
+    uint64_t& random_state = is_worker ? workers_[index]->random_state : external_random_state;
+    const size_t workers_count = workers_.size();
+    const size_t start = NextRandom(random_state) % workers_count;
+    for (size_t i = 0; i < workers_count; ++i) {
+        const size_t victim = (start + i) % workers_count;
+        if (victim == index) {
+            continue;
         }
-        task();
-        {
-            std::unique_lock lock{mutex_};
-            --active_tasks_;
-            if (tasks_.empty() and (active_tasks_ == 0)) {
-                cv_done_.notify_all();
+        if (TaskDeque::Item task = workers_[victim]->deque.Steal()) {
+            if (metrics_enabled_.load(std::memory_order_relaxed)) {
+                AccessCounters(index).tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+    }
+    for (size_t i = 0; i < workers_count; ++i) {
+        Worker& victim = *workers_[(start + i) % workers_count];
+        if (victim.inbox_size.load(std::memory_order_acquire) > 0) {
+            if (TaskDeque::Item task = TakeFromInbox(victim, false, index)) {
+                return task;
             }
         }
     }
+    return nullptr;
+}
+
+TaskDeque::Item ThreadPool::TakeFromInbox(Worker& worker, const bool move_rest,
+                                          const size_t index) {
+    std::unique_lock lock = LockInbox(worker, index);
+    if (worker.inbox.empty()) {
+        return nullptr;
+    }
+    TaskDeque::Item task = worker.inbox.front();
+    worker.inbox.pop_front();
+    size_t taken = 1;
+    if (move_rest) {
+        for (TaskDeque::Item rest : worker.inbox) {
+            worker.deque.Push(rest);
+        }
+        taken += worker.inbox.size();
+        worker.inbox.clear();
+    }
+    worker.inbox_size.fetch_sub(taken, std::memory_order_relaxed);
+    if (taken > 1) {
+        WakeOne();
+    }
+    return task;
+}
+
+std::unique_lock<std::mutex> ThreadPool::LockInbox(Worker& worker, const size_t index) {
+    std::unique_lock lock{worker.inbox_mutex, std::try_to_lock};
+    if (not lock.owns_lock()) {
+        if (metrics_enabled_.load(std::memory_order_relaxed)) {
+            const int64_t start = NowNanoseconds();
+            lock.lock();
+            AccessCounters(index).mutex_wait_time.fetch_add(NowNanoseconds() - start,
+                                                            std::memory_order_relaxed);
+        } else {
+            lock.lock();
+        }
+    }
+    return lock;
+}
+
+void ThreadPool::RunTask(TaskDeque::Item task, const size_t index) {
+    TaskNode* node = static_cast<TaskNode*>(task);
+    const bool measure = metrics_enabled_.load(std::memory_order_relaxed);
+    int64_t start = 0;
+    if (measure) {
+        Counters& counters = AccessCounters(index);
+        start = NowNanoseconds();
+        if (node->enqueue_time != 0) {
+            counters.latency[LatencyBucket(start - node->enqueue_time)].fetch_add(
+                1, std::memory_order_relaxed);
+        }
+        const int64_t last_task_end = counters.last_task_end.load(std::memory_order_relaxed);
+        if (index < workers_.size() and last_task_end != 0) {
+            counters.idle_time.fetch_add(start - last_task_end, std::memory_order_relaxed);
+        }
+    }
+    {
+        TraceScope trace{"Task"};
+        (*task)();
+    }
+    if (measure) {
+        Counters& counters = AccessCounters(index);
+        const int64_t end = NowNanoseconds();
+        counters.busy_time.fetch_add(end - start, std::memory_order_relaxed);
+        counters.tasks_executed.fetch_add(1, std::memory_order_relaxed);
+        if (index < workers_.size()) {
+            counters.last_task_end.store(end, std::memory_order_relaxed);
+        }
+    }
+    ReleaseNode(node);
+    if (pending_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pending_tasks_.notify_all();
+    }
+}
+
+ThreadPool::Counters& ThreadPool::AccessCounters(const size_t index) {
+    return (index < workers_.size()) ? workers_[index]->counters : external_counters_;
+}
+
+void ThreadPool::WakeOne() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_workers_.load(std::memory_order_seq_cst) > 0) {
+        wake_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        wake_epoch_.notify_one();
+    }
 }
 
 }  // namespace renderer
@@ -4,25 +4,161 @@
  */
 #pragma once
 
-#include <condition_variable>
-#include <functional>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <span>
 #include <thread>
+#include <vector>
+
+#include "renderer/task.hpp"
+#include "renderer/task_deque.hpp"
 
 namespace renderer {
 
 /**
  * @brief Singleton класс ThreadPool
+ *
+ * Планировщик с перехватом задач: у каждого потока есть своя неблокирующая очередь TaskDeque.
+ * Задачи, добавленные из потока ThreadPool, попадают в его очередь без блокировок. Задачи из
+ * других потоков распределяются по кругу между входящими очередями потоков, каждая со своим
+ * мьютексом. Поток без задач перехватывает их у случайно выбранных потоков, затем некоторое время
+ * ждет активно и только после этого засыпает до появления новых задач
+ *
+ * Задачи хранятся в Task и узлах, переиспользуемых между вызовами, поэтому добавление задачи с
+ * небольшим захватом не выделяет память
+ *
+ * Количество потоков можно менять во время работы, а потоки можно привязывать к процессорам или
+ * узлам NUMA (см. ThreadPool::SetAffinity)
+ *
+ * Кроме общего объекта, доступного через ThreadPool::Get, можно создавать независимые ThreadPool и
+ * передавать их в Renderer и другие компоненты библиотеки
+ *
+ * По запросу ThreadPool собирает метрики работы потоков (см. ThreadPool::EnableMetrics), которые
+ * можно читать во время работы без остановки потоков
  */
 class ThreadPool {
 public:
+    /**
+     * @brief Привязка потоков к процессорам
+     */
+    struct Affinity {
+        /**
+         * @brief Способ привязки
+         */
+        enum Mode : uint8_t {
+            /**
+             * Потоки не привязываются
+             */
+            NONE,
+            /**
+             * Поток i привязывается к процессору cores[i % cores.size()]
+             */
+            CORES,
+            /**
+             * Потоки делятся на равные непрерывные группы по узлам NUMA, каждый поток привязывается
+             * ко всем процессорам своего узла
+             */
+            NUMA_NODES
+        };
+
+        Mode mode = NONE;
+
+        /**
+         * Номера логических процессоров для режима CORES
+         */
+        std::vector<size_t> cores;
+    };
+
+    /**
+     * @brief Номер потока, не принадлежащего ThreadPool
+     */
+    static constexpr size_t kNotWorker = SIZE_MAX;
+
+    /**
+     * @brief Количество интервалов гистограммы задержек
+     */
+    static constexpr size_t kLatencyBuckets = 32;
+
+    /**
+     * @brief Метрики одного потока
+     */
+    struct WorkerMetrics {
+        /**
+         * Количество выполненных задач
+         */
+        uint64_t tasks_executed = 0;
+        /**
+         * Количество задач, перехваченных у других потоков
+         */
+        uint64_t tasks_stolen = 0;
+        /**
+         * Время выполнения задач
+         */
+        std::chrono::nanoseconds busy_time{0};
+        /**
+         * Время между задачами: поиск, активное ожидание и сон. Простой учитывается, когда
+         * поток берет следующую задачу
+         */
+        std::chrono::nanoseconds idle_time{0};
+        /**
+         * Время ожидания мьютексов входящих очередей
+         */
+        std::chrono::nanoseconds mutex_wait_time{0};
+    };
+
+    /**
+     * @brief Снимок метрик ThreadPool
+     */
+    struct Metrics {
+        /**
+         * Метрики потоков ThreadPool по номерам
+         */
+        std::vector<WorkerMetrics> workers;
+        /**
+         * Суммарные метрики остальных потоков, выполнявших задачи в ThreadPool::WaitAll или
+         * добавлявших задачи. Время простоя для них не считается
+         */
+        WorkerMetrics external;
+        /**
+         * Количество добавленных задач
+         */
+        uint64_t tasks_enqueued = 0;
+        /**
+         * Количество добавленных и еще не выполненных задач в момент снимка
+         */
+        size_t pending_tasks = 0;
+        /**
+         * Наибольшее количество добавленных и еще не выполненных задач
+         */
+        size_t queue_high_water_mark = 0;
+        /**
+         * Гистограмма задержек от добавления задачи до начала ее выполнения. Интервал 0 - задержка
+         * меньше 1 нс, интервал i - от 2^(i-1) до 2^i нс, последний интервал не ограничен сверху
+         */
+        std::array<uint64_t, kLatencyBuckets> latency_histogram{};
+
+        /**
+         * @brief Оценка квантиля задержки
+         *
+         * @param[in] fraction Доля задач от 0 до 1
+         *
+         * @return Верхняя граница интервала гистограммы, в который попадает квантиль, или 0, если
+         * задержки не измерялись
+         */
+        std::chrono::nanoseconds LatencyQuantile(const double fraction) const;
+    };
+
     /**
      * @brief Получение объекта ThreadPool
      *
      * Возвращает ссылку на ThreadPool. Объект создается при первом запросе. Количество потоков
      * по-умолчанию std::thread::hardware_concurrency, это значение можно менять с помощью
-     * ThreadPool::SetThreadsCount. Учитывается только последний вызов перед первым Get
+     * ThreadPool::SetThreadsCount как до первого Get, так и после него
      *
      * @return Ссылка на объект
      */
@@ -32,7 +168,9 @@ public:
      * @brief Задание количества потоков
      *
      * Задает количество потоков в ThreadPool. Если num_threads = 0, то устанавливает значение по
-     * умолчанию
+     * умолчанию. Если ThreadPool уже создан, дожидается выполнения всех задач и перезапускает
+     * потоки в новом количестве. В этом случае не должен вызываться из потоков ThreadPool и
+     * одновременно с другими обращениями к ThreadPool
      *
      * @param[in] num_threads Число потоков
      */
@@ -47,19 +185,172 @@ public:
      */
     static size_t GetThreadsCount();
 
+    /**
+     * @brief Задание привязки потоков к процессорам
+     *
+     * Применяется сразу, если ThreadPool уже создан, и к потокам, созданным позже. Привязка
+     * поддерживается только в Linux, на других системах настройка сохраняется, но не действует
+     *
+     * @param[in] affinity Привязка потоков
+     */
+    static void SetAffinity(const Affinity& affinity);
+
+    /**
+     * @brief Получение привязки потоков
+     *
+     * @return Привязка, заданная последним вызовом ThreadPool::SetAffinity
+     */
+    static Affinity GetAffinity();
+
+    /**
+     * @brief Номер текущего потока
+     *
+     * @return Номер потока в его ThreadPool, если вызов исполняется потоком какого-либо
+     * ThreadPool, иначе ThreadPool::kNotWorker
+     */
+    static size_t CurrentWorker();
+
+    /**
+     * @brief Создание независимого ThreadPool
+     *
+     * Потоки не привязываются к процессорам
+     *
+     * @param[in] threads_count Количество потоков, 0 заменяется на 1
+     */
+    explicit ThreadPool(const size_t threads_count);
+
+    /**
+     * @brief Создание независимого ThreadPool
+     *
+     * @param[in] threads_count Количество потоков, 0 заменяется на 1
+     * @param[in] affinity Привязка потоков к процессорам
+     */
+    ThreadPool(const size_t threads_count, const Affinity& affinity);
+
+    /**
+     * @brief Изменение количества потоков
+     *
+     * Дожидается выполнения всех задач и перезапускает потоки в новом количестве. Не должен
+     * вызываться из потоков этого ThreadPool и одновременно с другими обращениями к нему
+     *
+     * @param[in] threads_count Количество потоков, 0 заменяется на 1
+     */
+    void Resize(const size_t threads_count);
+
+    /**
+     * @brief Привязка потоков этого ThreadPool к процессорам
+     *
+     * @param[in] affinity Привязка потоков
+     */
+    void SetWorkersAffinity(const Affinity& affinity);
+
+    /**
+     * @brief Количество потоков этого ThreadPool
+     *
+     * @return Количество потоков
+     */
+    size_t GetWorkersCount() const;
+
+    /**
+     * @brief Узел NUMA потока
+     *
+     * Требуется, чтобы worker был меньше количества потоков
+     *
+     * @param[in] worker Номер потока
+     *
+     * @return Номер узла NUMA, к которому привязан поток, или 0, если поток не привязан
+     */
+    size_t GetWorkerNode(const size_t worker) const;
+
+    /**
+     * @brief Включение сбора метрик
+     *
+     * Пока сбор выключен, метрики не изменяются и ThreadPool не опрашивает часы. Сбор включенных
+     * метрик стоит нескольких обращений к часам и атомарных операций на задачу
+     *
+     * @param[in] enabled Собирать ли метрики
+     */
+    void EnableMetrics(const bool enabled);
+
+    /**
+     * @brief Включен ли сбор метрик
+     *
+     * @return true, если метрики собираются
+     */
+    bool IsMetricsEnabled() const;
+
+    /**
+     * @brief Снимок метрик
+     *
+     * Читает счетчики без блокировок и может вызываться одновременно с работой потоков, поэтому
+     * значения разных счетчиков могут относиться к немного разным моментам. Метрики потоков
+     * обнуляются при изменении их количества
+     *
+     * @return Метрики
+     */
+    Metrics GetMetrics() const;
+
+    /**
+     * @brief Обнуление метрик
+     */
+    void ResetMetrics();
+
+    /**
+     * @brief Временная память потока
+     *
+     * Возвращает буфер текущего потока размером не меньше bytes. Буфер выделяется и расширяется
+     * самим потоком, поэтому для привязанных потоков он размещается на их узле NUMA. Содержимое
+     * буфера не сохраняется при расширении. Буфер действителен до следующего вызова из этого же
+     * потока или до изменения количества потоков. Вызов из других потоков возвращает буфер этого
+     * потока
+     *
+     * @param[in] bytes Требуемый размер
+     *
+     * @return Буфер
+     */
+    std::span<std::byte> AccessScratch(const size_t bytes);
+
     /**
      * @brief Добавление задачи
      *
-     * Добавляет задачу в очередь для исполнения
+     * Добавляет задачу в очередь для исполнения. Из потока ThreadPool задача добавляется в его
+     * собственную очередь без блокировок
      *
      * @param[in] task Задача
      */
-    void Enqueue(std::function<void()>&& task);
+    void Enqueue(Task&& task);
+
+    /**
+     * @brief Параллельный цикл
+     *
+     * Разбивает диапазон [begin, end) на части по grain элементов и вызывает для каждой части
+     * function(part_begin, part_end). Части разбираются потоками ThreadPool и вызвавшим потоком
+     * через общий атомарный счетчик, поэтому на весь цикл создается не больше задач, чем потоков,
+     * а function не копируется. Если часть одна, она выполняется в вызвавшем потоке без обращения
+     * к очередям. Возвращает управление после обработки всех частей
+     *
+     * @param[in] begin Начало диапазона
+     * @param[in] end Конец диапазона
+     * @param[in] grain Количество элементов в части, 0 считается за 1
+     * @param[in] function Функция от границ части
+     */
+    template <class Function>
+    void ParallelFor(const size_t begin, const size_t end, const size_t grain,
+                     Function&& function) {
+        using Stored = std::remove_reference_t<Function>;
+        RangeFunction invoke = [](void* context, const size_t part_begin, const size_t part_end) {
+            (*static_cast<Stored*>(context))(part_begin, part_end);
+        };
+        void* context = const_cast<void*>(static_cast<const void*>(std::addressof(function)));
+        ParallelForRange(begin, end, grain, invoke, context);
+    }
 
     /**
      * @brief Ожидание выполнения всех задач
      *
-     * Останавливает вызвавший поток до тех пор, пока не опустеет очередь задач
+     * Останавливает вызвавший поток до тех пор, пока не будут выполнены все добавленные задачи.
+     * Во время ожидания вызвавший поток сам выполняет задачи из очередей. Ожидает в том числе
+     * чужие задачи, поэтому для ожидания только своих задач следует использовать TaskGroup
      */
     void WaitAll();
 
@@ -72,6 +363,51 @@ public:
     ~ThreadPool();
 
 private:
+    /**
+     * @brief Функция от границ части диапазона с контекстом
+     */
+    using RangeFunction = void (*)(void* context, const size_t begin, const size_t end);
+
+    /**
+     * @brief Реализация ThreadPool::ParallelFor без шаблонов
+     */
+    void ParallelForRange(const size_t begin, const size_t end, const size_t grain,
+                          const RangeFunction function, void* context);
+
+    /**
+     * @brief Счетчики метрик потока или группы потоков
+     */
+    struct Counters {
+        std::atomic<uint64_t> tasks_executed{0};
+        std::atomic<uint64_t> tasks_stolen{0};
+        std::atomic<int64_t> busy_time{0};  // наносекунды
+        std::atomic<int64_t> idle_time{0};
+        std::atomic<int64_t> mutex_wait_time{0};
+        std::atomic<int64_t> last_task_end{0};  // конец последней задачи, 0 - неизвестен
+        std::array<std::atomic<uint64_t>, kLatencyBuckets> latency{};
+
+        void Reset();
+    };
+
+    /**
+     * @brief Состояние потока
+     */
+    struct alignas(64) Worker {
+        TaskDeque deque;  // собственная очередь, доступна без блокировок
+
+        std::mutex inbox_mutex;
+        std::deque<TaskDeque::Item> inbox;  // задачи, добавленные из других потоков
+        std::atomic<size_t> inbox_size{0};
+
+        uint64_t random_state;  // состояние генератора для выбора потока при перехвате
+        size_t node = 0;        // узел NUMA, к которому привязан поток
+
+        std::unique_ptr<std::byte[]> scratch;  // временная память потока
+        size_t scratch_size = 0;
+
+        Counters counters;
+    };
+
     /**
      * @brief Создание ThreadPool
      *
@@ -79,26 +415,105 @@ private:
      */
     ThreadPool();
 
+    /**
+     * @brief Запуск потоков
+     */
+    void StartWorkers(const size_t threads_count);
+
+    /**
+     * @brief Остановка всех потоков
+     *
+     * Задачи, оставшиеся в очередях, выполняются до остановки
+     */
+    void StopWorkers();
+
+    /**
+     * @brief Применение привязки affinity_ к запущенным потокам
+     */
+    void ApplyAffinity();
+
     /**
      * @brief Цикл, исполняемый в каждом потоке
+     *
+     * @param[in] index Номер потока
+     */
+    void WorkerLoop(const size_t index);
+
+    /**
+     * @brief Номер текущего потока в этом ThreadPool или workers_.size() для остальных потоков
+     */
+    size_t LocalWorker() const;
+
+    /**
+     * @brief Поиск задачи
+     *
+     * Проверяет собственную очередь потока index, затем его входящую очередь, затем пытается
+     * перехватить задачу у других потоков, начиная со случайного. Для потоков не из ThreadPool
+     * index равен workers_.size()
+     *
+     * @return Задача или nullptr
+     */
+    TaskDeque::Item FindTask(const size_t index);
+
+    /**
+     * @brief Извлечение задачи из входящей очереди
+     *
+     * Если move_rest, остальные задачи входящей очереди переносятся в собственную очередь
+     * потока, откуда их могут перехватить другие потоки. index - номер потока, выполняющего
+     * поиск, как в ThreadPool::FindTask
      */
-    void WorkerLoop();
+    TaskDeque::Item TakeFromInbox(Worker& worker, const bool move_rest, const size_t index);
+
+    /**
+     * @brief Захват мьютекса входящей очереди с учетом времени ожидания в метриках потока index
+     */
+    std::unique_lock<std::mutex> LockInbox(Worker& worker, const size_t index);
+
+    /**
+     * @brief Выполнение и удаление задачи потоком index
+     */
+    void RunTask(TaskDeque::Item task, const size_t index);
+
+    /**
+     * @brief Счетчики потока index, для потоков не из ThreadPool - общие счетчики
+     */
+    Counters& AccessCounters(const size_t index);
+
+    /**
+     * @brief Пробуждение одного спящего потока, если такой есть
+     */
+    void WakeOne();
 
     /**
      * @brief Количество потоков
      */
     static size_t k_threads;
 
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
+    /**
+     * @brief Привязка потоков
+     */
+    static Affinity k_affinity;
+
+    /**
+     * @brief Созданный объект или nullptr
+     */
+    static ThreadPool* k_instance;
+
+    Affinity affinity_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
 
-    std::mutex mutex_;
-    std::condition_variable cv_task_;  // ожидание задач
-    std::condition_variable cv_done_;  // ожидание опустошения очереди задач
+    std::atomic<size_t> pending_tasks_{0};   // добавленные и еще не выполненные задачи
+    std::atomic<size_t> next_inbox_{0};      // входящая очередь для следующей внешней задачи
+    std::atomic<uint32_t> wake_epoch_{0};    // изменяется при появлении задач для спящих
+    std::atomic<size_t> sleeping_workers_{0};
 
-    size_t active_tasks_ = 0;  // число задач в работе
+    std::atomic<bool> stop_{false};  // остановка при разрушении
 
-    bool stop_ = false;  // остановка при разрушении
+    std::atomic<bool> metrics_enabled_{false};
+    Counters external_counters_;  // счетчики потоков не из ThreadPool
+    std::atomic<uint64_t> tasks_enqueued_{0};
+    std::atomic<size_t> queue_high_water_mark_{0};
 };
 
 }  // namespace renderer
@@ -0,0 +1,231 @@
+#include "renderer/trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <ios>
+#include <string_view>
+
+namespace renderer {
+
+namespace {
+
+/**
+ * @brief Номер для следующего потока
+ */
+std::atomic<size_t> next_thread_id{1};
+
+/**
+ * @brief Состояние записи текущего потока
+ */
+struct ThreadState {
+    size_t id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    std::string name;
+    void* buffer = nullptr;  // буфер в Tracer или nullptr
+    uint64_t generation = 0;
+};
+
+thread_local ThreadState thread_state;
+
+/**
+ * @brief Время steady_clock в наносекундах
+ */
+int64_t SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Запись строки в JSON с экранированием
+ */
+void WriteJsonString(std::ostream& output, const std::string_view text) {
+    output << '"';
+    for (const char symbol : text) {
+        if (symbol == '"' or symbol == '\\') {
+            output << '\\' << symbol;
+        } else if (static_cast<unsigned char>(symbol) < 0x20) {
+            output << ' ';
+        } else {
+            output << symbol;
+        }
+    }
+    output << '"';
+}
+
+/**
+ * @brief Наносекунды в микросекунды, используемые форматом
+ */
+double ToMicroseconds(const int64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1000.0;
+}
+
+}  // namespace
+
+std::atomic<bool> Tracer::k_enabled{false};
+
+Tracer& Tracer::Get() {
+    static Tracer instance;
+    return instance;
+}
+
+bool Tracer::IsEnabled() {
+    return k_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::Enable(const bool enabled) {
+    k_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::SetBufferCapacity(const size_t events) {
+    capacity_.store(std::bit_ceil(std::max<size_t>(events, 1)), std::memory_order_relaxed);
+}
+
+Tracer::FrameId Tracer::BeginFrame() {
+    const FrameId frame = frame_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (IsEnabled()) {
+        const int64_t now = Now();
+        Record("Frame", frame, now, now);
+    }
+    return frame;
+}
+
+Tracer::FrameId Tracer::CurrentFrame() const {
+    return frame_.load(std::memory_order_relaxed);
+}
+
+void Tracer::SetThreadName(std::string name) {
+    thread_state.name = std::move(name);
+    Tracer& tracer = Get();
+    std::lock_guard lock{tracer.mutex_};
+    // буфер, созданный до Tracer::Clear, уже удален
+    if (thread_state.buffer != nullptr and
+        thread_state.generation == tracer.generation_.load(std::memory_order_relaxed)) {
+        static_cast<ThreadBuffer*>(thread_state.buffer)->thread_name = thread_state.name;
+    }
+}
+
+void Tracer::Record(const char* name, const FrameId frame, const int64_t begin,
+                    const int64_t end) {
+    {
+        assert(name and "Record: название события не должно быть nullptr");
+    }
+    ThreadBuffer& buffer = AccessBuffer();
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index & (buffer.events.size() - 1)] =
+        Event{.name = name, .frame = frame, .begin = begin, .end = end};
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+int64_t Tracer::Now() const {
+    return SteadyNow() - epoch_;
+}
+
+void Tracer::Clear() {
+    std::lock_guard lock{mutex_};
+    buffers_.clear();
+    generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Tracer::WriteChromeTrace(std::ostream& output, const FrameId first_frame,
+                              const FrameId last_frame) const {
+    std::lock_guard lock{mutex_};
+    // микросекунды с точностью до наносекунд
+    const std::ios_base::fmtflags flags = output.flags();
+    const std::streamsize precision = output.precision(3);
+    output.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&output, &first]() {
+        output << (first ? "\n" : ",\n");
+        first = false;
+    };
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+        separator();
+        output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+               << ",\"args\":{\"name\":";
+        WriteJsonString(output, buffer->thread_name.empty()
+                                    ? "thread " + std::to_string(buffer->thread_id)
+                                    : buffer->thread_name);
+        output << "}}";
+
+        // читаются только опубликованные события, начиная с самого старого сохранившегося
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t capacity = buffer->events.size();
+        const uint64_t oldest = (written > capacity) ? written - capacity : 0;
+        for (uint64_t index = oldest; index < written; ++index) {
+            const Event& event = buffer->events[index & (capacity - 1)];
+            if (event.frame < first_frame or event.frame > last_frame) {
+                continue;
+            }
+            separator();
+            output << "{\"name\":";
+            WriteJsonString(output, event.name);
+            output << ",\"pid\":1,\"tid\":" << buffer->thread_id
+                   << ",\"ts\":" << ToMicroseconds(event.begin);
+            if (event.begin == event.end) {
+                output << ",\"ph\":\"i\",\"s\":\"g\"";
+            } else {
+                output << ",\"ph\":\"X\",\"dur\":" << ToMicroseconds(event.end - event.begin);
+            }
+            output << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+    }
+    output << "\n]}\n";
+    output.flags(flags);
+    output.precision(precision);
+}
+
+bool Tracer::SaveChromeTrace(const std::string& path, const FrameId first_frame,
+                             const FrameId last_frame) const {
+    std::ofstream output{path, std::ios_base::trunc};
+    if (not output) {
+        return false;
+    }
+    WriteChromeTrace(output, first_frame, last_frame);
+    return static_cast<bool>(output);
+}
+
+Tracer::Tracer() : epoch_{SteadyNow()} {
+}
+
+Tracer::ThreadBuffer& Tracer::AccessBuffer() {
+    const uint64_t generation = generation_.load(std::memory_order_relaxed);
+    if (thread_state.buffer == nullptr or thread_state.generation != generation) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->thread_id = thread_state.id;
+        buffer->thread_name = thread_state.name;
+        buffer->events.resize(capacity_.load(std::memory_order_relaxed));
+        std::lock_guard lock{mutex_};
+        thread_state.buffer = buffer.get();
+        thread_state.generation = generation;
+        buffers_.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer*>(thread_state.buffer);
+}
+
+TraceScope::TraceScope(const char* name) : name_{Tracer::IsEnabled() ? name : nullptr} {
+    if (name_ != nullptr) {
+        Tracer& tracer = Tracer::Get();
+        frame_ = tracer.CurrentFrame();
+        begin_ = tracer.Now();
+    }
+}
+
+TraceScope::TraceScope(const char* name, const Tracer::FrameId frame)
+    : name_{Tracer::IsEnabled() ? name : nullptr}, frame_{frame} {
+    if (name_ != nullptr) {
+        begin_ = Tracer::Get().Now();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (name_ != nullptr) {
+        Tracer& tracer = Tracer::Get();
+        tracer.Record(name_, frame_, begin_, std::max(tracer.Now(), begin_ + 1));
+    }
+}
+
+}  // namespace renderer
@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @brief Запись временной шкалы выполнения для просмотра в chrome://tracing и Perfetto
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace renderer {
+
+/**
+ * @brief Запись временной шкалы
+ *
+ * Собирает интервалы выполнения (события) со всех потоков: задачи ThreadPool, стадии кадров
+ * Renderer и RenderPipeline, а также пользовательские интервалы TraceScope. У каждого потока свой
+ * кольцевой буфер, в который пишет только он сам, поэтому запись не использует блокировок. При
+ * переполнении буфера старые события перезаписываются
+ *
+ * Каждое событие помечается номером кадра, начатого последним на момент начала события (см.
+ * Tracer::BeginFrame). Выгрузка в формате Chrome trace JSON выполняется для диапазона кадров
+ *
+ * По умолчанию запись выключена, и каждый TraceScope стоит одной атомарной загрузки
+ */
+class Tracer {
+public:
+    /**
+     * @brief Номер кадра
+     */
+    using FrameId = uint64_t;
+
+    /**
+     * @brief Размер буфера потока в событиях по умолчанию
+     */
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    /**
+     * @brief Событие
+     */
+    struct Event {
+        /**
+         * Название, должно существовать все время работы программы
+         */
+        const char* name = nullptr;
+        /**
+         * Кадр, в котором началось событие
+         */
+        FrameId frame = 0;
+        /**
+         * Начало и конец в наносекундах от создания Tracer
+         */
+        int64_t begin = 0;
+        int64_t end = 0;
+    };
+
+    /**
+     * @brief Получение Tracer
+     *
+     * @return Ссылка на объект, создаваемый при первом запросе
+     */
+    static Tracer& Get();
+
+    /**
+     * @brief Включена ли запись
+     *
+     * @return true, если события записываются
+     */
+    static bool IsEnabled();
+
+    /**
+     * @brief Включение и выключение записи
+     *
+     * @param[in] enabled Записывать ли события
+     */
+    void Enable(const bool enabled);
+
+    /**
+     * @brief Задание размера буферов
+     *
+     * Действует на буферы потоков, которые запишут свое первое событие после вызова или после
+     * Tracer::Clear
+     *
+     * @param[in] events Количество событий, округляется вверх до степени двойки
+     */
+    void SetBufferCapacity(const size_t events);
+
+    /**
+     * @brief Начало нового кадра
+     *
+     * Вызывается Renderer и RenderPipeline для каждого кадра, но может вызываться и приложением
+     * для разметки своих этапов. Если запись включена, добавляет мгновенное событие "Frame"
+     *
+     * @return Номер начатого кадра
+     */
+    FrameId BeginFrame();
+
+    /**
+     * @brief Номер последнего начатого кадра
+     *
+     * @return Номер кадра, 0 до первого вызова BeginFrame
+     */
+    FrameId CurrentFrame() const;
+
+    /**
+     * @brief Название текущего потока
+     *
+     * Название попадает в выгрузку как имя дорожки потока. Потоки ThreadPool называются
+     * автоматически
+     *
+     * @param[in] name Название
+     */
+    static void SetThreadName(std::string name);
+
+    /**
+     * @brief Запись события текущего потока
+     *
+     * @param[in] name Название, должно существовать все время работы программы
+     * @param[in] frame Кадр, в котором началось событие
+     * @param[in] begin Начало, значение Tracer::Now
+     * @param[in] end Конец, значение Tracer::Now
+     */
+    void Record(const char* name, const FrameId frame, const int64_t begin, const int64_t end);
+
+    /**
+     * @brief Текущее время
+     *
+     * @return Наносекунды от создания Tracer
+     */
+    int64_t Now() const;
+
+    /**
+     * @brief Удаление записанных событий
+     *
+     * Освобождает буферы всех потоков. Не должен вызываться одновременно с записью событий
+     */
+    void Clear();
+
+    /**
+     * @brief Выгрузка в формате Chrome trace JSON
+     *
+     * Записывает события кадров от first_frame до last_frame включительно. Одновременная запись
+     * событий не блокируется, но события, перезаписываемые в момент выгрузки, могут быть
+     * искажены, поэтому выгружать следует между кадрами
+     *
+     * @param[out] output Поток для записи
+     * @param[in] first_frame Первый кадр
+     * @param[in] last_frame Последний кадр
+     */
+    void WriteChromeTrace(std::ostream& output, const FrameId first_frame,
+                          const FrameId last_frame) const;
+
+    /**
+     * @brief Сохранение в файл в формате Chrome trace JSON
+     *
+     * @param[in] path Путь к файлу
+     * @param[in] first_frame Первый кадр
+     * @param[in] last_frame Последний кадр
+     *
+     * @return true, если файл записан
+     */
+    bool SaveChromeTrace(const std::string& path, const FrameId first_frame,
+                         const FrameId last_frame) const;
+
+    Tracer(const Tracer& other) = delete;
+    Tracer(Tracer&& other) = delete;
+
+    Tracer& operator=(const Tracer& other) = delete;
+    Tracer& operator=(Tracer&& other) = delete;
+
+private:
+    /**
+     * @brief Кольцевой буфер потока
+     *
+     * Пишет только поток-владелец, written публикует записанные события для выгрузки
+     */
+    struct ThreadBuffer {
+        size_t thread_id = 0;
+        std::string thread_name;
+        std::vector<Event> events;  // размер - степень двойки
+        std::atomic<uint64_t> written{0};
+    };
+
+    Tracer();
+
+    /**
+     * @brief Буфер текущего потока, создается при первой записи
+     */
+    ThreadBuffer& AccessBuffer();
+
+    static std::atomic<bool> k_enabled;
+
+    const int64_t epoch_;
+    std::atomic<FrameId> frame_{0};
+    std::atomic<size_t> capacity_{kDefaultCapacity};
+    std::atomic<uint64_t> generation_{0};  // изменяется при Clear, чтобы потоки создали буферы
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+/**
+ * @brief Интервал временной шкалы
+ *
+ * Записывает событие от создания до разрушения объекта, если запись Tracer включена
+ */
+class TraceScope {
+public:
+    /**
+     * @brief Начало интервала
+     *
+     * Интервал относится к последнему начатому кадру
+     *
+     * @param[in] name Название, должно существовать все время работы программы. Если nullptr,
+     * интервал не записывается
+     */
+    explicit TraceScope(const char* name);
+
+    /**
+     * @brief Начало интервала в переданном кадре
+     *
+     * Используется для работы, выполняемой после начала следующих кадров, например для
+     * растеризации в RenderPipeline
+     *
+     * @param[in] name Название, должно существовать все время работы программы. Если nullptr,
+     * интервал не записывается
+     * @param[in] frame Кадр
+     */
+    TraceScope(const char* name, const Tracer::FrameId frame);
+
+    TraceScope(const TraceScope& other) = delete;
+    TraceScope& operator=(const TraceScope& other) = delete;
+
+    ~TraceScope();
+
+private:
+    const char* name_;  // nullptr, если запись выключена
+    Tracer::FrameId frame_ = 0;
+    int64_t begin_ = 0;
+};
+
+}  // namespace renderer
@@ -9,7 +9,8 @@
 
 namespace renderer::utils {
 
-Object LoadFile(const std::string& path) {
+Object LoadFile(const std::string& path, const bool optimize,
+                MeshOptimizationStats* stats) {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(
         path.c_str(), aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs);
@@ -85,6 +86,13 @@ Object LoadFile(const std::string& path) {
         materials[material_index] = manager.PushMaterial(new_material);
     }
 
+    // грани записываются сразу в итоговый массив, который затем передается в объект без копирования
+    size_t total_faces = 0;
+    for (size_t mesh_index = 0; mesh_index < scene->mNumMeshes; ++mesh_index) {
+        total_faces += scene->mMeshes[mesh_index]->mNumFaces;
+    }
+    triangles.reserve(total_faces);
+
     for (size_t mesh_index = 0; mesh_index < scene->mNumMeshes; ++mesh_index) {
         const aiMesh* mesh = scene->mMeshes[mesh_index];
         {
@@ -95,7 +103,10 @@ Object LoadFile(const std::string& path) {
             MaterialId material_index = materials[mesh->mMaterialIndex];
         }
 
-        size_t mesh_vertices_start = vertices.size();
+        // в памяти хранятся вершины только текущей сетки
+        vertices.clear();
+        vertices.reserve(mesh->mNumVertices);
+        size_t mesh_vertices_start = 0;
         for (size_t vertex_index = 0; vertex_index < mesh->mNumVertices; ++vertex_index) {
             Vertex new_vertex;
             new_vertex.point =
@@ -124,7 +135,14 @@ Object LoadFile(const std::string& path) {
         }
     }
 
-    return Object{triangles};
+    Object object{std::move(triangles)};
+    if (optimize) {
+        MeshOptimizationStats optimization_stats = OptimizeObject(object);
+        if (stats != nullptr) {
+            *stats = optimization_stats;
+        }
+    }
+    return object;
 }
 
 }  // namespace renderer::utils
@@ -5,8 +5,11 @@
 
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
+#include "renderer/mesh_optimizer.hpp"
 #include "renderer/object.hpp"
 
 namespace renderer {
@@ -27,12 +30,86 @@ namespace utils {
  * На текущий момент поддерживаются только внешние текстуры diffusive текстуры. Тексутры ищутся по
  * пути, записанном в файле модели, относительно директории, в который находится модель
  *
+ * Если передан флаг optimize, к загруженному объекту применяется OptimizeObject, а статистика
+ * оптимизации записывается по указателю stats, если он не nullptr
  *
  * @param[in] path Путь до файла
+ * @param[in] optimize Требуется ли оптимизировать геометрию объекта
+ * @param[out] stats Статистика оптимизации
  *
  * @return Объект, загруженный из файла
  */
-Object LoadFile(const std::string& path);
+Object LoadFile(const std::string& path, const bool optimize = false,
+                MeshOptimizationStats* stats = nullptr);
+
+/**
+ * @brief Версия формата бинарного кэша объектов
+ *
+ * Увеличивается при любом изменении формата. Кэш с другой версией считается недействительным
+ */
+inline constexpr uint32_t kMeshCacheVersion = 1;
+
+/**
+ * @brief Хэш содержимого файла
+ *
+ * Вычисляет 64-битный хэш FNV-1a содержимого файла по пути path. Используется для проверки
+ * актуальности кэша. Если файл не удалось открыть, возвращается 0
+ *
+ * @param[in] path Путь до файла
+ *
+ * @return Хэш содержимого файла
+ */
+uint64_t HashFile(const std::string& path);
+
+/**
+ * @brief Сохранение объекта в бинарный кэш
+ *
+ * Записывает грани объекта в файл cache_path в том же виде, в котором они хранятся в памяти, вместе
+ * с используемыми материалами и путями до их текстур. Запись производится во временный файл,
+ * который затем переименовывается, поэтому частично записанный кэш не может быть прочитан
+ *
+ * @param[in] object Объект
+ * @param[in] cache_path Путь до файла кэша
+ * @param[in] source_hash Хэш исходного файла модели
+ *
+ * @return Удалось ли записать кэш
+ */
+bool SaveMeshCache(const Object& object, const std::string& cache_path,
+                   const uint64_t source_hash);
+
+/**
+ * @brief Загрузка объекта из бинарного кэша
+ *
+ * Отображает файл cache_path в память и создает объект из записанных в нем граней без разбора
+ * модели. Материалы из кэша добавляются в ResourcesManager, текстуры загружаются заново по
+ * сохраненным путям. Если файл отсутствует, поврежден, записан другой версией формата или хэш
+ * исходного файла не совпадает с source_hash, возвращается std::nullopt
+ *
+ * @param[in] cache_path Путь до файла кэша
+ * @param[in] source_hash Ожидаемый хэш исходного файла модели
+ *
+ * @return Объект, загруженный из кэша
+ */
+std::optional<Object> LoadMeshCache(const std::string& cache_path, const uint64_t source_hash);
+
+/**
+ * @brief Загрузка объекта из файла с использованием кэша
+ *
+ * Если по пути cache_path лежит актуальный кэш для файла path, объект загружается из него с помощью
+ * LoadMeshCache. Иначе объект загружается с помощью LoadFile, после чего кэш перезаписывается.
+ * Оптимизированный и неоптимизированный объекты кэшируются как разные версии, поэтому смена флага
+ * optimize приводит к перестроению кэша. Статистика оптимизации заполняется только при загрузке из
+ * файла модели
+ *
+ * @param[in] path Путь до файла модели
+ * @param[in] cache_path Путь до файла кэша
+ * @param[in] optimize Требуется ли оптимизировать геометрию объекта
+ * @param[out] stats Статистика оптимизации
+ *
+ * @return Объект, загруженный из кэша или файла
+ */
+Object LoadFileCached(const std::string& path, const std::string& cache_path,
+                      const bool optimize = false, MeshOptimizationStats* stats = nullptr);
 
 };  // namespace utils
 };  // namespace renderer
@@ -0,0 +1,247 @@
+#include <renderer/image.hpp>
+#include <renderer/image_writer.hpp>
+#include <renderer/thread_pool.hpp>
+
+#include "stb_image.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace renderer::test {
+
+/**
+ * @brief Размер изображения и размер полосы PNG
+ */
+struct Case {
+    size_t width;
+    size_t height;
+    size_t rows_per_strip;
+};
+
+/**
+ * @brief Изображения нечетных размеров, одна строка, один столбец и много полос PNG, включая
+ * неполную последнюю
+ */
+constexpr Case kCases[] = {
+    {1, 1, ImageWriter::kDefaultRowsPerStrip},
+    {97, 1, ImageWriter::kDefaultRowsPerStrip},
+    {1, 53, 4},
+    {37, 23, ImageWriter::kDefaultRowsPerStrip},
+    {131, 201, 1},
+    {131, 201, 7},
+    {255, 129, ImageWriter::kDefaultRowsPerStrip},
+};
+
+constexpr ImageWriter::Format kFormats[] = {ImageWriter::BMP, ImageWriter::PPM, ImageWriter::QOI,
+                                             ImageWriter::PNG};
+
+const char* FormatName(const ImageWriter::Format format) {
+    switch (format) {
+        case ImageWriter::BMP:
+            return "BMP";
+        case ImageWriter::PPM:
+            return "PPM";
+        case ImageWriter::QOI:
+            return "QOI";
+        case ImageWriter::PNG:
+            return "PNG";
+    }
+    return "?";
+}
+
+/**
+ * @brief Заполнение изображения детерминированным узором
+ *
+ * Однотонная полоса, плавный градиент и шум, чтобы задействовать повторы, малые разности и
+ * произвольные пиксели всех кодировщиков
+ */
+Image MakeImage(const size_t width, const size_t height) {
+    Image image{Width{width}, Height{height}};
+    uint32_t state = 0x9e3779b9u ^ static_cast<uint32_t>(width * 7919 + height);
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            Image::Pixel& pixel = image.AccessPixel(x, y);
+            if (y % 5 == 0) {
+                pixel = {40, 80, 120};
+            } else if (x < width / 2) {
+                pixel = {static_cast<uint8_t>(x + y), static_cast<uint8_t>(2 * x),
+                         static_cast<uint8_t>(255 - y)};
+            } else {
+                pixel = {static_cast<uint8_t>(state), static_cast<uint8_t>(state >> 8),
+                         static_cast<uint8_t>(state >> 16)};
+            }
+        }
+    }
+    return image;
+}
+
+uint32_t ReadBigEndian(const uint8_t* data) {
+    return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) | (uint32_t{data[2]} << 8) |
+           uint32_t{data[3]};
+}
+
+/**
+ * @brief Декодирование QOI по спецификации формата
+ *
+ * stb_image не читает QOI, поэтому файл декодируется здесь
+ *
+ * @param[in] data Закодированный файл
+ * @param[out] width Ширина изображения
+ * @param[out] height Высота изображения
+ *
+ * @return Пиксели RGB построчно или пустой массив, если файл поврежден
+ */
+std::vector<uint8_t> DecodeQoi(const std::vector<uint8_t>& data, int& width, int& height) {
+    constexpr size_t kHeaderSize = 14;
+    constexpr uint8_t kEndMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+    if (data.size() < kHeaderSize + sizeof(kEndMarker) or
+        std::memcmp(data.data(), "qoif", 4) != 0 or
+        std::memcmp(data.data() + data.size() - sizeof(kEndMarker), kEndMarker,
+                    sizeof(kEndMarker)) != 0) {
+        return {};
+    }
+    width = static_cast<int>(ReadBigEndian(data.data() + 4));
+    height = static_cast<int>(ReadBigEndian(data.data() + 8));
+    const size_t pixels_count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const size_t end = data.size() - sizeof(kEndMarker);
+
+    uint8_t seen[64][4] = {};
+    uint8_t px[4] = {0, 0, 0, 255};
+    std::vector<uint8_t> pixels;
+    pixels.reserve(pixels_count * 3);
+    size_t pos = kHeaderSize;
+    while (pixels.size() < pixels_count * 3) {
+        if (pos >= end) {
+            return {};
+        }
+        const uint8_t op = data[pos++];
+        size_t run = 1;
+        if (op == 0xfe or op == 0xff) {
+            const size_t channels = (op == 0xfe) ? 3 : 4;
+            if (pos + channels > end) {
+                return {};
+            }
+            std::memcpy(px, data.data() + pos, channels);
+            pos += channels;
+        } else if ((op >> 6) == 0) {
+            std::memcpy(px, seen[op], 4);
+        } else if ((op >> 6) == 1) {
+            px[0] = static_cast<uint8_t>(px[0] + ((op >> 4) & 3) - 2);
+            px[1] = static_cast<uint8_t>(px[1] + ((op >> 2) & 3) - 2);
+            px[2] = static_cast<uint8_t>(px[2] + (op & 3) - 2);
+        } else if ((op >> 6) == 2) {
+            if (pos >= end) {
+                return {};
+            }
+            const int dg = (op & 0x3f) - 32;
+            const uint8_t next = data[pos++];
+            px[0] = static_cast<uint8_t>(px[0] + dg + (next >> 4) - 8);
+            px[1] = static_cast<uint8_t>(px[1] + dg);
+            px[2] = static_cast<uint8_t>(px[2] + dg + (next & 0x0f) - 8);
+        } else {
+            run = (op & 0x3f) + 1;
+        }
+        std::memcpy(seen[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        for (size_t i = 0; i < run; ++i) {
+            pixels.insert(pixels.end(), px, px + 3);
+        }
+    }
+    if (pixels.size() != pixels_count * 3 or pos != end) {
+        return {};
+    }
+    return pixels;
+}
+
+/**
+ * @brief Декодирование файла обратно в пиксели RGB
+ */
+std::vector<uint8_t> Decode(const std::vector<uint8_t>& data, const ImageWriter::Format format,
+                            int& width, int& height) {
+    if (format == ImageWriter::QOI) {
+        return DecodeQoi(data, width, height);
+    }
+    int channels = 0;
+    stbi_uc* decoded = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width,
+                                             &height, &channels, 3);
+    if (decoded == nullptr) {
+        return {};
+    }
+    const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+    std::vector<uint8_t> pixels(decoded, decoded + size);
+    stbi_image_free(decoded);
+    return pixels;
+}
+
+/**
+ * @brief Кодирование изображения, декодирование и сравнение с исходным
+ *
+ * @return Удалось ли получить исходное изображение без изменений
+ */
+bool RoundTrip(const ImageWriter& writer, const Image& image, const ImageWriter::Format format,
+               const Case& test_case) {
+    const std::vector<uint8_t> encoded = writer.Encode(image, format);
+    int width = 0;
+    int height = 0;
+    const std::vector<uint8_t> pixels = Decode(encoded, format, width, height);
+    if (pixels.empty()) {
+        std::fprintf(stderr, "%s %zux%zu, %zu rows per strip: failed to decode\n",
+                     FormatName(format), test_case.width, test_case.height,
+                     test_case.rows_per_strip);
+        return false;
+    }
+    if (static_cast<size_t>(width) != test_case.width or
+        static_cast<size_t>(height) != test_case.height) {
+        std::fprintf(stderr, "%s %zux%zu, %zu rows per strip: decoded as %dx%d\n",
+                     FormatName(format), test_case.width, test_case.height,
+                     test_case.rows_per_strip, width, height);
+        return false;
+    }
+    const Image::Pixel* expected = image.AccessData();
+    for (size_t index = 0; index < test_case.width * test_case.height; ++index) {
+        const uint8_t* actual = pixels.data() + index * 3;
+        if (actual[0] != expected[index].r or actual[1] != expected[index].g or
+            actual[2] != expected[index].b) {
+            std::fprintf(stderr,
+                         "%s %zux%zu, %zu rows per strip: pixel (%zu, %zu) is (%d, %d, %d), "
+                         "expected (%d, %d, %d)\n",
+                         FormatName(format), test_case.width, test_case.height,
+                         test_case.rows_per_strip, index % test_case.width,
+                         index / test_case.width, actual[0], actual[1], actual[2],
+                         expected[index].r, expected[index].g, expected[index].b);
+            return false;
+        }
+    }
+    return true;
+}
+
+};  // namespace renderer::test
+
+int main() {
+    using namespace renderer;
+    using namespace renderer::test;
+    // несколько потоков, чтобы полосы PNG и строки BMP действительно кодировались параллельно
+    ThreadPool thread_pool{3};
+    size_t failures = 0;
+    size_t checks = 0;
+    for (const Case& test_case : kCases) {
+        const Image image = MakeImage(test_case.width, test_case.height);
+        ImageWriter writer{thread_pool};
+        writer.SetRowsPerStrip(test_case.rows_per_strip);
+        for (const ImageWriter::Format format : kFormats) {
+            failures += RoundTrip(writer, image, format, test_case) ? 0u : 1u;
+            ++checks;
+        }
+    }
+    if (failures != 0) {
+        std::fprintf(stderr, "FAILED: %zu of %zu images changed after encoding\n", failures,
+                     checks);
+        return 1;
+    }
+    std::printf("OK: %zu images decoded without changes\n", checks);
+    return 0;
+}
@@ -0,0 +1,558 @@
+#include <renderer/include_all.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace renderer::test {
+
+/**
+ * Код возврата, по которому ctest считает тест пропущенным
+ */
+constexpr int kSkipCode = 77;
+
+/**
+ * Файл с эталонным временем кадров в каталоге эталонов
+ */
+constexpr const char* kBaselinesFile = "perf_baselines.txt";
+
+/**
+ * @brief Допуск сравнения изображений
+ *
+ * Пиксель считается отличающимся, если хотя бы один канал отличается больше чем на
+ * max_channel_diff. Изображения совпадают, если доля отличающихся пикселей не больше
+ * max_diff_fraction. Нулевой допуск - точное сравнение
+ */
+struct Tolerance {
+    uint8_t max_channel_diff = 0;
+    double max_diff_fraction = 0;
+};
+
+/**
+ * @brief Сцена для проверки
+ */
+struct TestScene {
+    std::string name;
+    Scene scene{Scene::FULL_PRECISION};
+    Scene::CameraId camera = 0;
+    Renderer::RenderFlags flags = Renderer::DRAW_FACETS;
+    /**
+     * Допуск сравнения с эталоном. Порядок операций с плавающей точкой, выбранный компилятором и
+     * реализацией glm, сдвигает отдельные пиксели на ребрах и меняет освещение на единицы, поэтому
+     * все сцены сравниваются с небольшим допуском
+     */
+    Tolerance tolerance{};
+};
+
+/**
+ * @brief Режим запуска
+ */
+enum Mode : uint8_t {
+    /**
+     * Сравнение изображений с эталонами
+     */
+    IMAGES,
+    /**
+     * Сравнение времени кадров с эталонным
+     */
+    PERF,
+    /**
+     * Перезапись эталонов изображений и времени кадров
+     */
+    UPDATE
+};
+
+/**
+ * @brief Параметры запуска
+ */
+struct Options {
+    Mode mode = IMAGES;
+    std::filesystem::path references;
+    std::filesystem::path output;
+    std::string scene_filter;
+    size_t width = 256;
+    size_t height = 144;
+    size_t perf_width = 640;
+    size_t perf_height = 360;
+    size_t iterations = 10;
+    double perf_tolerance = 0.25;
+};
+
+/**
+ * @brief Результат сравнения изображений
+ */
+struct Diff {
+    size_t different_pixels = 0;
+    uint8_t max_channel_diff = 0;
+    bool size_mismatch = false;
+};
+
+/**
+ * @brief Сетка с ребрами под углом к камере
+ */
+TestScene Edges(ResourcesManager&) {
+    TestScene result{.name = "edges",
+                     .flags = Renderer::DRAW_EDGES | Renderer::DRAW_FACETS,
+                     .tolerance = {.max_channel_diff = 2, .max_diff_fraction = 0.002}};
+    const Scene::MeshId mesh = utils::PushGridMesh(result.scene, {.cells = 16});
+    SceneObject& object = result.scene.AccessObject(result.scene.PushInstance(mesh));
+    object.AccessZAngle() = 30;
+    object.AccessXAngle() = 20;
+    result.camera = utils::PushFrontCamera(result.scene, 3);
+    return result;
+}
+
+/**
+ * @brief Повторяющаяся шахматная текстура под углом к камере
+ */
+TestScene Textured(ResourcesManager& resources) {
+    TestScene result{.name = "textured",
+                     .tolerance = {.max_channel_diff = 2, .max_diff_fraction = 0.003}};
+    result.camera = utils::PushTexturedScene(result.scene,
+                                             utils::TexturedSceneParameters{.texture_size = 64,
+                                                                            .checker_size = 8,
+                                                                            .cells = 8,
+                                                                            .uv_repeat = 4,
+                                                                            .x_angle = 60},
+                                             resources);
+    return result;
+}
+
+/**
+ * @brief Камера внутри коробки: почти каждая грань обрезается
+ */
+TestScene Clipping(ResourcesManager& resources) {
+    TestScene result{.name = "clipping",
+                     .flags = Renderer::DRAW_EDGES | Renderer::DRAW_FACETS,
+                     .tolerance = {.max_channel_diff = 2, .max_diff_fraction = 0.002}};
+    result.camera = utils::PushClippingScene(result.scene, 4, resources);
+    return result;
+}
+
+/**
+ * @brief Освещенная сетка с несколькими типами источников
+ */
+TestScene Lit(ResourcesManager&) {
+    TestScene result{.name = "lit",
+                     .flags = Renderer::DRAW_FACETS | Renderer::ENABLE_LIGHT,
+                     .tolerance = {.max_channel_diff = 2, .max_diff_fraction = 0.001}};
+    const Scene::MeshId mesh = utils::PushGridMesh(result.scene, {.cells = 32});
+    result.scene.AccessObject(result.scene.PushInstance(mesh)).AccessXAngle() = 45;
+    result.camera = utils::PushFrontCamera(result.scene, 2);
+    utils::PushDefaultLights(result.scene);
+    return result;
+}
+
+/**
+ * @brief Уменьшенная процедурная нагрузочная сцена с освещением
+ */
+TestScene Stress(ResourcesManager&) {
+    TestScene result{.name = "stress",
+                     .flags = Renderer::DRAW_FACETS | Renderer::ENABLE_LIGHT,
+                     .tolerance = {.max_channel_diff = 2, .max_diff_fraction = 0.002}};
+    result.camera = utils::PushStressScene(
+        result.scene, utils::StressSceneParameters{.terrain_cells = 64,
+                                                   .trees = 500,
+                                                   .spheres = 4,
+                                                   .sphere_subdivisions = 3,
+                                                   .soup_facets = 2000,
+                                                   .light_rows = 2,
+                                                   .light_columns = 2});
+    return result;
+}
+
+/**
+ * @brief Создание всех сцен
+ */
+std::vector<TestScene> MakeScenes(ResourcesManager& resources, const std::string& filter) {
+    std::vector<TestScene (*)(ResourcesManager&)> makers = {Edges, Textured, Clipping, Lit,
+                                                           Stress};
+    std::vector<TestScene> scenes;
+    for (auto maker : makers) {
+        TestScene scene = maker(resources);
+        if (not filter.empty() and scene.name != filter) {
+            continue;
+        }
+        scene.scene.UpdateTransforms();
+        scenes.push_back(std::move(scene));
+    }
+    return scenes;
+}
+
+/**
+ * @brief Сохранение изображения в формате PPM (P6)
+ */
+bool WritePpm(const std::filesystem::path& path, const Image& image) {
+    std::ofstream file{path, std::ios_base::binary | std::ios_base::trunc};
+    if (not file) {
+        return false;
+    }
+    file << "P6\n" << image.GetWidth() << ' ' << image.GetHeight() << "\n255\n";
+    file.write(reinterpret_cast<const char*>(image.AccessData()),
+               image.GetWidth() * image.GetHeight() * sizeof(Image::Pixel));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Загрузка изображения в формате PPM (P6), записанного WritePpm
+ */
+std::optional<Image> ReadPpm(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios_base::binary};
+    std::string magic;
+    size_t width = 0;
+    size_t height = 0;
+    size_t max_value = 0;
+    if (not(file >> magic >> width >> height >> max_value) or magic != "P6" or
+        max_value != 255 or width == 0 or height == 0) {
+        return std::nullopt;
+    }
+    file.get();  // один пробельный символ после заголовка
+    Image image{Width{width}, Height{height}};
+    file.read(reinterpret_cast<char*>(image.AccessData()), width * height * sizeof(Image::Pixel));
+    if (not file) {
+        return std::nullopt;
+    }
+    return image;
+}
+
+/**
+ * @brief Наибольшая разница каналов пикселей
+ */
+uint8_t ChannelDiff(const Image::Pixel& lhs, const Image::Pixel& rhs) {
+    return static_cast<uint8_t>(
+        std::max({std::abs(lhs.r - rhs.r), std::abs(lhs.g - rhs.g), std::abs(lhs.b - rhs.b)}));
+}
+
+/**
+ * @brief Сравнение изображений
+ */
+Diff Compare(const Image& actual, const Image& expected, const uint8_t max_channel_diff) {
+    Diff diff;
+    if (actual.GetWidth() != expected.GetWidth() or actual.GetHeight() != expected.GetHeight()) {
+        diff.size_mismatch = true;
+        return diff;
+    }
+    const size_t pixels = actual.GetWidth() * actual.GetHeight();
+    const Image::Pixel* lhs = actual.AccessData();
+    const Image::Pixel* rhs = expected.AccessData();
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint8_t channel_diff = ChannelDiff(lhs[i], rhs[i]);
+        diff.max_channel_diff = std::max(diff.max_channel_diff, channel_diff);
+        if (channel_diff > max_channel_diff) {
+            ++diff.different_pixels;
+        }
+    }
+    return diff;
+}
+
+/**
+ * @brief Изображение разницы: отличающиеся пиксели красные, остальные - затемненный эталон
+ */
+Image MakeDiffImage(const Image& actual, const Image& expected, const uint8_t max_channel_diff) {
+    Image result{Width{expected.GetWidth()}, Height{expected.GetHeight()}};
+    for (size_t y = 0; y < expected.GetHeight(); ++y) {
+        for (size_t x = 0; x < expected.GetWidth(); ++x) {
+            const Image::Pixel& lhs = actual.AccessPixel(x, y);
+            const Image::Pixel& rhs = expected.AccessPixel(x, y);
+            const uint8_t channel_diff = ChannelDiff(lhs, rhs);
+            result.AccessPixel(x, y) =
+                (channel_diff > max_channel_diff)
+                    ? Image::Pixel{255, 0, 0}
+                    : Image::Pixel{static_cast<uint8_t>(rhs.r / 4), static_cast<uint8_t>(rhs.g / 4),
+                                   static_cast<uint8_t>(rhs.b / 4)};
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Рендеринг сцены
+ */
+Image RenderScene(Renderer& renderer, const TestScene& scene, const size_t width,
+                  const size_t height) {
+    return renderer.Render(scene.scene, scene.camera, Image{Width{width}, Height{height}},
+                           scene.flags);
+}
+
+/**
+ * @brief Проверка изображений
+ *
+ * Каждая сцена рендерится в однопоточном и многопоточном ThreadPool. Результаты должны совпадать
+ * точно, а многопоточный - с эталоном с допуском сцены. Для несовпавших сцен в каталог output
+ * записываются полученное изображение и изображение разницы
+ */
+int CheckImages(const Options& options, const std::vector<TestScene>& scenes,
+                ResourcesManager& resources) {
+    ThreadPool single_pool{1};
+    Renderer single{single_pool, resources};
+    Renderer parallel{ThreadPool::Get(), resources};
+    if (not options.output.empty()) {
+        std::filesystem::create_directories(options.output);
+    }
+    size_t failed = 0;
+    size_t missing = 0;
+    for (const TestScene& scene : scenes) {
+        const Image actual = RenderScene(parallel, scene, options.width, options.height);
+        const Image sequential = RenderScene(single, scene, options.width, options.height);
+        const Diff threads_diff = Compare(actual, sequential, 0);
+        if (threads_diff.different_pixels > 0) {
+            std::fprintf(stderr, "%s: FAILED, %zu pixels differ between 1 and %zu threads\n",
+                         scene.name.c_str(), threads_diff.different_pixels,
+                         ThreadPool::Get().GetWorkersCount());
+            ++failed;
+        }
+
+        const std::filesystem::path reference_path = options.references / (scene.name + ".ppm");
+        const std::optional<Image> reference = ReadPpm(reference_path);
+        if (not reference) {
+            std::fprintf(stderr, "%s: no reference %s\n", scene.name.c_str(),
+                         reference_path.c_str());
+            ++missing;
+            continue;
+        }
+        const Diff diff = Compare(actual, *reference, scene.tolerance.max_channel_diff);
+        const double fraction =
+            static_cast<double>(diff.different_pixels) / (options.width * options.height);
+        if (not diff.size_mismatch and fraction <= scene.tolerance.max_diff_fraction) {
+            std::fprintf(stderr, "%s: ok, %zu pixels differ, max channel diff %u\n",
+                         scene.name.c_str(), diff.different_pixels, diff.max_channel_diff);
+            continue;
+        }
+        ++failed;
+        if (diff.size_mismatch) {
+            std::fprintf(stderr, "%s: FAILED, reference is %zux%zu\n", scene.name.c_str(),
+                         reference->GetWidth(), reference->GetHeight());
+        } else {
+            std::fprintf(stderr,
+                         "%s: FAILED, %zu pixels (%.4f%%) differ, max channel diff %u, "
+                         "allowed %.4f%% over %u\n",
+                         scene.name.c_str(), diff.different_pixels, fraction * 100,
+                         diff.max_channel_diff, scene.tolerance.max_diff_fraction * 100,
+                         scene.tolerance.max_channel_diff);
+        }
+        if (not options.output.empty()) {
+            WritePpm(options.output / (scene.name + ".actual.ppm"), actual);
+            if (not diff.size_mismatch) {
+                WritePpm(options.output / (scene.name + ".diff.ppm"),
+                         MakeDiffImage(actual, *reference, scene.tolerance.max_channel_diff));
+            }
+        }
+    }
+    if (failed > 0) {
+        return 1;
+    }
+    if (missing > 0) {
+        std::fprintf(stderr, "%zu references missing, run the update-golden target\n", missing);
+        return kSkipCode;
+    }
+    return 0;
+}
+
+/**
+ * @brief Замер времени кадра
+ *
+ * @return Минимальное время кадра в миллисекундах после одного прогревочного кадра
+ */
+double MeasureFrame(Renderer& renderer, const TestScene& scene, const Options& options) {
+    Image image{Width{options.perf_width}, Height{options.perf_height}};
+    image = renderer.Render(scene.scene, scene.camera, std::move(image), scene.flags);
+    double best = 0;
+    for (size_t i = 0; i < options.iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        image = renderer.Render(scene.scene, scene.camera, std::move(image), scene.flags);
+        const auto end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = (i == 0) ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+/**
+ * @brief Эталонное время кадров
+ */
+struct Baselines {
+    size_t threads = 0;
+    size_t width = 0;
+    size_t height = 0;
+    std::map<std::string, double> frame_ms;
+};
+
+/**
+ * @brief Загрузка эталонного времени кадров
+ *
+ * Формат: строка "threads T width W height H", затем строки "сцена миллисекунды"
+ */
+std::optional<Baselines> ReadBaselines(const std::filesystem::path& path) {
+    std::ifstream file{path};
+    Baselines baselines;
+    std::string threads_key, width_key, height_key;
+    if (not(file >> threads_key >> baselines.threads >> width_key >> baselines.width >>
+            height_key >> baselines.height) or
+        threads_key != "threads" or width_key != "width" or height_key != "height") {
+        return std::nullopt;
+    }
+    std::string name;
+    double ms = 0;
+    while (file >> name >> ms) {
+        baselines.frame_ms[name] = ms;
+    }
+    return baselines;
+}
+
+/**
+ * @brief Запись эталонного времени кадров
+ */
+bool WriteBaselines(const std::filesystem::path& path, const Baselines& baselines) {
+    std::ofstream file{path, std::ios_base::trunc};
+    file << "threads " << baselines.threads << " width " << baselines.width << " height "
+         << baselines.height << '\n';
+    for (const auto& [name, ms] : baselines.frame_ms) {
+        file << name << ' ' << ms << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Проверка времени кадров
+ *
+ * Время кадра не должно превышать эталонное больше чем в 1 + perf_tolerance раз. Эталон
+ * сравним только при том же количестве потоков и размере кадра, иначе проверка пропускается
+ */
+int CheckPerformance(const Options& options, const std::vector<TestScene>& scenes,
+                     ResourcesManager& resources) {
+    const std::optional<Baselines> baselines = ReadBaselines(options.references / kBaselinesFile);
+    const size_t threads = ThreadPool::Get().GetWorkersCount();
+    if (not baselines) {
+        std::fprintf(stderr, "no baselines in %s, run the update-golden target\n",
+                     (options.references / kBaselinesFile).c_str());
+        return kSkipCode;
+    }
+    if (baselines->threads != threads or baselines->width != options.perf_width or
+        baselines->height != options.perf_height) {
+        std::fprintf(stderr,
+                     "baselines were recorded with %zu threads at %zux%zu, "
+                     "this run uses %zu threads at %zux%zu\n",
+                     baselines->threads, baselines->width, baselines->height, threads,
+                     options.perf_width, options.perf_height);
+        return kSkipCode;
+    }
+    Renderer renderer{ThreadPool::Get(), resources};
+    size_t failed = 0;
+    for (const TestScene& scene : scenes) {
+        const double ms = MeasureFrame(renderer, scene, options);
+        const auto baseline = baselines->frame_ms.find(scene.name);
+        if (baseline == baselines->frame_ms.end()) {
+            std::fprintf(stderr, "%s: %.3f ms, no baseline\n", scene.name.c_str(), ms);
+            continue;
+        }
+        const double ratio = ms / baseline->second;
+        const bool ok = ratio <= 1 + options.perf_tolerance;
+        std::fprintf(stderr, "%s: %s, %.3f ms, baseline %.3f ms (%+.1f%%)\n", scene.name.c_str(),
+                     ok ? "ok" : "FAILED", ms, baseline->second, (ratio - 1) * 100);
+        if (not ok) {
+            ++failed;
+        }
+    }
+    return (failed > 0) ? 1 : 0;
+}
+
+/**
+ * @brief Перезапись эталонов
+ *
+ * Записывает изображения всех сцен и их время кадров. Время сцен, не попавших в фильтр,
+ * сохраняется из старого файла
+ */
+int UpdateReferences(const Options& options, const std::vector<TestScene>& scenes,
+                     ResourcesManager& resources) {
+    std::filesystem::create_directories(options.references);
+    Renderer renderer{ThreadPool::Get(), resources};
+    Baselines baselines = ReadBaselines(options.references / kBaselinesFile).value_or(Baselines{});
+    baselines.threads = ThreadPool::Get().GetWorkersCount();
+    baselines.width = options.perf_width;
+    baselines.height = options.perf_height;
+    for (const TestScene& scene : scenes) {
+        const std::filesystem::path path = options.references / (scene.name + ".ppm");
+        if (not WritePpm(path, RenderScene(renderer, scene, options.width, options.height))) {
+            std::fprintf(stderr, "Renderer_regression: не удалось записать %s\n", path.c_str());
+            return 1;
+        }
+        baselines.frame_ms[scene.name] = MeasureFrame(renderer, scene, options);
+        std::fprintf(stderr, "%s: %.3f ms\n", scene.name.c_str(), baselines.frame_ms[scene.name]);
+    }
+    if (not WriteBaselines(options.references / kBaselinesFile, baselines)) {
+        std::fprintf(stderr, "Renderer_regression: не удалось записать %s\n", kBaselinesFile);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Разбор аргументов командной строки
+ *
+ * @return false, если аргументы некорректны
+ */
+bool ParseOptions(int argc, char** argv, Options& options) {
+    if (argc < 2) {
+        return false;
+    }
+    if (std::strcmp(argv[1], "images") == 0) {
+        options.mode = IMAGES;
+    } else if (std::strcmp(argv[1], "perf") == 0) {
+        options.mode = PERF;
+    } else if (std::strcmp(argv[1], "update") == 0) {
+        options.mode = UPDATE;
+    } else {
+        return false;
+    }
+    for (int i = 2; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--references") == 0 and has_value) {
+            options.references = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 and has_value) {
+            options.output = argv[++i];
+        } else if (std::strcmp(argv[i], "--scene") == 0 and has_value) {
+            options.scene_filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--iterations") == 0 and has_value) {
+            options.iterations = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--perf-tolerance") == 0 and has_value) {
+            options.perf_tolerance = std::stod(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return not options.references.empty();
+}
+
+}  // namespace renderer::test
+
+int main(int argc, char** argv) {
+    using namespace renderer::test;
+    Options options;
+    if (not ParseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: Renderer_regression images|perf|update --references DIR\n"
+                     "                           [--output DIR] [--scene NAME] [--iterations N]\n"
+                     "                           [--perf-tolerance FRACTION]\n");
+        return 1;
+    }
+    renderer::ResourcesManager resources;
+    const std::vector<TestScene> scenes = MakeScenes(resources, options.scene_filter);
+    switch (options.mode) {
+        case IMAGES:
+            return CheckImages(options, scenes, resources);
+        case PERF:
+            return CheckPerformance(options, scenes, resources);
+        case UPDATE:
+            return UpdateReferences(options, scenes, resources);
+    }
+    return 1;
+}
@@ -0,0 +1,161 @@
+#include <renderer/task.hpp>
+#include <renderer/task_deque.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace renderer::test {
+
+/**
+ * @brief Параметры нагрузки
+ */
+struct Options {
+    size_t items = 200000;
+    size_t thieves = 3;
+    size_t rounds = 20;
+    // маленькая начальная вместимость, чтобы очередь многократно расширялась во время перехвата
+    size_t capacity = 4;
+};
+
+/**
+ * @brief Учет извлеченных задач
+ *
+ * Задачи очереди используются только как уникальные адреса, номер задачи - смещение от начала
+ * массива
+ */
+class Ledger {
+public:
+    explicit Ledger(std::vector<Task>& tasks) : tasks_{tasks}, taken_(tasks.size()) {
+    }
+
+    void Take(const TaskDeque::Item item) {
+        const size_t index = item - tasks_.data();
+        if (index < tasks_.size()) {
+            taken_[index].fetch_add(1, std::memory_order_relaxed);
+        } else {
+            foreign_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Проверка, что каждая задача извлечена ровно один раз
+     *
+     * @return Количество нарушений
+     */
+    size_t Check(const size_t round) const {
+        size_t errors = foreign_.load(std::memory_order_relaxed);
+        if (errors != 0) {
+            std::fprintf(stderr, "round %zu: %zu foreign items taken\n", round, errors);
+        }
+        for (size_t index = 0; index < taken_.size(); ++index) {
+            const int count = taken_[index].load(std::memory_order_relaxed);
+            if (count != 1) {
+                if (errors < 10) {
+                    std::fprintf(stderr, "round %zu: item %zu taken %d times\n", round, index,
+                                 count);
+                }
+                ++errors;
+            }
+        }
+        return errors;
+    }
+
+private:
+    std::vector<Task>& tasks_;
+    std::vector<std::atomic<int>> taken_;
+    std::atomic<size_t> foreign_{0};
+};
+
+/**
+ * @brief Один раунд нагрузки
+ *
+ * Владелец добавляет задачи и время от времени забирает последние, остальные потоки непрерывно
+ * перехватывают. После того как владелец закончил, он забирает оставшиеся задачи
+ *
+ * @return Количество нарушений
+ */
+size_t RunRound(const Options& options, const size_t round) {
+    std::vector<Task> tasks(options.items);
+    Ledger ledger{tasks};
+    TaskDeque deque{options.capacity};
+    std::atomic<bool> producing{true};
+
+    std::vector<std::thread> thieves;
+    thieves.reserve(options.thieves);
+    for (size_t thief = 0; thief < options.thieves; ++thief) {
+        thieves.emplace_back([&] {
+            while (producing.load(std::memory_order_acquire) or deque.SizeEstimate() != 0) {
+                if (TaskDeque::Item item = deque.Steal()) {
+                    ledger.Take(item);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // сериями разной длины, чтобы очередь то пустела, то росла
+    size_t pushed = 0;
+    for (size_t batch = 1; pushed < tasks.size(); batch = batch % 97 + 1) {
+        for (size_t i = 0; i < batch and pushed < tasks.size(); ++i) {
+            deque.Push(&tasks[pushed++]);
+        }
+        for (size_t i = 0; i < batch / 3; ++i) {
+            if (TaskDeque::Item item = deque.Pop()) {
+                ledger.Take(item);
+            }
+        }
+    }
+    // владелец соревнуется с перехватывающими потоками за последние задачи
+    while (TaskDeque::Item item = deque.Pop()) {
+        ledger.Take(item);
+    }
+    producing.store(false, std::memory_order_release);
+    for (std::thread& thief : thieves) {
+        thief.join();
+    }
+    return ledger.Check(round);
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const size_t value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--items") == 0) {
+            options.items = value;
+        } else if (std::strcmp(argv[i], "--thieves") == 0) {
+            options.thieves = value;
+        } else if (std::strcmp(argv[i], "--rounds") == 0) {
+            options.rounds = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+};  // namespace renderer::test
+
+int main(int argc, char** argv) {
+    using namespace renderer::test;
+    Options options;
+    if (not ParseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: Renderer_task_deque_test [--items N] [--thieves N] [--rounds N]\n");
+        return 1;
+    }
+    size_t errors = 0;
+    for (size_t round = 0; round < options.rounds; ++round) {
+        errors += RunRound(options, round);
+    }
+    if (errors != 0) {
+        std::fprintf(stderr, "FAILED: %zu items were lost or taken more than once\n", errors);
+        return 1;
+    }
+    std::printf("OK: %zu rounds of %zu items, %zu thieves\n", options.rounds, options.items,
+                options.thieves);
+    return 0;
+}